@@ -93,6 +93,14 @@ namespace dynamo
     /*! \brief Stream the boundary conditions forward in time.*/
     virtual void update(const double&) {};
 
+    /*! \brief Tests if the event times are still only scaled when
+        every velocity is scaled (see
+        Dynamics::eventTimesScaleWithVelocity).
+
+      This is false for boundaries which move at a fixed rate.
+     */
+    virtual bool eventTimesScaleWithVelocity() const { return true; }
+
     /*! \brief Load the Boundary condition from an XML file. */
     virtual void operator<<(const magnet::xml::Node&) = 0;
 
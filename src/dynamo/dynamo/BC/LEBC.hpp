@@ -42,6 +42,9 @@ namespace dynamo {
 
     virtual void operator<<(const magnet::xml::Node&);
 
+    //! The shear rate is not scaled with the peculiar velocities
+    virtual bool eventTimesScaleWithVelocity() const { return false; }
+
     virtual void applyBC(Vector&) const; 
 
     virtual void applyBC(Vector&, Vector&) const;
@@ -26,30 +26,6 @@ namespace dynamo {
     Sim = tmp;
   }
 
-  void 
-  BCPeriodic::applyBC(Vector & pos) const
-  { 
-    for (size_t n = 0; n < NDIM; ++n)
-      pos[n] -= Sim->primaryCellSize[n] *
-	lrint(pos[n]/Sim->primaryCellSize[n]);    
-  }
-
-  void 
-  BCPeriodic::applyBC(Vector & pos, Vector&) const
-  {
-    for (size_t n = 0; n < NDIM; ++n)
-      pos[n] -= Sim->primaryCellSize[n] *
-	lrint(pos[n] / Sim->primaryCellSize[n]);    
-  }
-
-  void 
-  BCPeriodic::applyBC(Vector  &pos, const double&) const 
-  {
-    for (size_t n = 0; n < NDIM; ++n)
-      pos[n] -= Sim->primaryCellSize[n] *
-	lrint(pos[n] / Sim->primaryCellSize[n]);    
-  }
-
   void 
   BCPeriodic::outputXML(magnet::xml::XmlStream &XML) const
   {
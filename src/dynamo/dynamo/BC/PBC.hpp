@@ -17,6 +17,8 @@
 
 #pragma once
 #include <dynamo/BC/BC.hpp>
+#include <dynamo/simulation.hpp>
+#include <cmath>
 
 namespace dynamo {
   /*! \brief A simple rectangular periodic boundary condition, also a
@@ -30,11 +32,22 @@ namespace dynamo {
   public:
     BCPeriodic(const dynamo::Simulation*);
 
-    virtual void applyBC(Vector &) const;
+    /*! These are defined here so that callers which know the exact
+        type of the boundary condition (see EventKernel) may inline
+        them using a qualified call.
+     */
+    virtual void applyBC(Vector & pos) const
+    { 
+      for (size_t n = 0; n < NDIM; ++n)
+	pos[n] -= Sim->primaryCellSize[n] *
+	  lrint(pos[n] / Sim->primaryCellSize[n]);    
+    }
   
-    virtual void applyBC(Vector &, Vector &) const;
+    virtual void applyBC(Vector & pos, Vector &) const
+    { BCPeriodic::applyBC(pos); }
 
-    virtual void applyBC(Vector &, const double&) const;
+    virtual void applyBC(Vector & pos, const double&) const
+    { BCPeriodic::applyBC(pos); }
 
     virtual void outputXML(magnet::xml::XmlStream&) const;
     virtual void operator<<(const magnet::xml::Node&);
@@ -18,9 +18,16 @@
 #pragma once
 
 #include <dynamo/2particleEventData.hpp>
-#include <list>
+#include <magnet/containers/small_vector.hpp>
 
 namespace dynamo {
+  /*! \brief Collects the changes made to particles during an event.
+
+    Nearly every event changes only one or two particles, so the
+    changes are stored in containers which hold the first two entries
+    inline. Building an NEventData for these events requires no heap
+    allocation.
+   */
   class NEventData
   {
   public:
@@ -31,7 +38,7 @@ namespace dynamo {
     NEventData&  operator+=(const ParticleEventData& p) { L1partChanges.push_back(p); return *this; }
     NEventData&  operator+=(const PairEventData& p) { L2partChanges.push_back(p); return *this; }
 
-    std::list<ParticleEventData> L1partChanges;
-    std::list<PairEventData> L2partChanges;
+    magnet::containers::SmallVector<ParticleEventData, 2> L1partChanges;
+    magnet::containers::SmallVector<PairEventData, 2> L2partChanges;
   };
 }
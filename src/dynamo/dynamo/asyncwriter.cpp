@@ -0,0 +1,154 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dynamo/asyncwriter.hpp>
+#include <magnet/stream/bzip2.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/chain.hpp>
+#include <iostream>
+
+namespace dynamo {
+  namespace {
+    //! The contents of a file which was formatted by the caller.
+    class StringSource: public AsyncWriter::Source
+    {
+    public:
+      StringSource(std::string& data) { _data.swap(data); }
+
+      size_t size() const { return _data.size(); }
+
+      void write(std::ostream& os) const { os.write(_data.data(), _data.size()); }
+
+    private:
+      std::string _data;
+    };
+  }
+
+  AsyncWriter::AsyncWriter(size_t maxBytes):
+    _maxBytes(maxBytes),
+    _bytes(0),
+    _files(0),
+    _started(false),
+    _stop(false)
+  {}
+
+  AsyncWriter::~AsyncWriter()
+  {
+    if (!_started) return;
+
+    {
+      magnet::thread::ScopedLock lock(_mutex);
+      _stop = true;
+      _queued.notify_all();
+    }
+
+    _thread.join();
+
+    if (!_error.empty())
+      std::cerr << "AsyncWriter: " << _error << std::endl;
+  }
+
+  void
+  AsyncWriter::write(const std::string& fileName, std::string data)
+  {
+    write(fileName, std::tr1::shared_ptr<Source>(new StringSource(data)));
+  }
+
+  void
+  AsyncWriter::write(const std::string& fileName, const std::tr1::shared_ptr<Source>& source)
+  {
+    magnet::thread::ScopedLock lock(_mutex);
+    throwError();
+
+    if (!_started)
+      {
+	_thread.startTask(magnet::function::Task::makeTask(&AsyncWriter::run, this));
+	_started = true;
+      }
+
+    //Back-pressure: wait for space, unless the queue is empty
+    while (_files && (_bytes + source->size() > _maxBytes))
+      {
+	_written.wait(_mutex);
+	throwError();
+      }
+
+    _bytes += source->size();
+    ++_files;
+    _queue.push_back(File(fileName, source));
+    _queued.notify_one();
+  }
+
+  void
+  AsyncWriter::finish()
+  {
+    magnet::thread::ScopedLock lock(_mutex);
+    while (_files && _error.empty())
+      _written.wait(_mutex);
+    throwError();
+  }
+
+  void
+  AsyncWriter::throwError()
+  {
+    if (_error.empty()) return;
+    std::string error;
+    error.swap(_error);
+    M_throw() << "Failed to write a file in the background:\n" << error;
+  }
+
+  void
+  AsyncWriter::run()
+  {
+    namespace io = boost::iostreams;
+
+    magnet::thread::ScopedLock lock(_mutex);
+    for (;;)
+      {
+	while (_queue.empty() && !_stop)
+	  _queued.wait(_mutex);
+
+	if (_queue.empty()) return;
+
+	File file(_queue.front());
+	_queue.pop_front();
+
+	lock.unlock();
+
+	std::string error;
+	try {
+	  io::filtering_ostream os;
+	  if ((file.first.size() > 4)
+	      && !file.first.compare(file.first.size() - 4, 4, ".bz2"))
+	    os.push(magnet::stream::ParallelBzip2Compressor());
+	  os.push(io::file_sink(file.first));
+	  file.second->write(os);
+	  os.reset();
+	} catch (std::exception& err) {
+	  error = err.what();
+	}
+
+	lock.lock();
+	if (!error.empty())
+	  _error += "While writing " + file.first + ": " + error + "\n";
+	_bytes -= file.second->size();
+	--_files;
+	_written.notify_all();
+      }
+  }
+}
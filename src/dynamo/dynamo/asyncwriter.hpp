@@ -0,0 +1,109 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <magnet/thread/thread.hpp>
+#include <magnet/thread/mutex.hpp>
+#include <tr1/memory>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace dynamo {
+  /*! \brief Compresses and writes files on a background thread.
+
+    The files are queued as in-memory copies, so the caller may alter
+    its state as soon as \ref write returns. A file is either queued as
+    its finished contents, or as a Source holding a copy of the data
+    it is formatted from, in which case the formatting also happens in
+    the background. Files ending in ".bz2" are bzip2 compressed, all
+    others are written as they are.
+
+    The total size of the queued files is bounded. If a write would
+    exceed the bound, it blocks until enough of the earlier files have
+    been written out. A single file larger than the bound is still
+    accepted once the queue is empty.
+   */
+  class AsyncWriter
+  {
+  public:
+    /*! \brief The contents of a file, which are produced on the
+        background thread.
+     */
+    class Source
+    {
+    public:
+      virtual ~Source() {}
+
+      //! \brief The number of bytes held, used to bound the queue.
+      virtual size_t size() const = 0;
+
+      //! \brief Writes out the contents of the file.
+      virtual void write(std::ostream&) const = 0;
+    };
+
+    /*! \param maxBytes The maximum number of bytes held in the
+        queue.
+     */
+    AsyncWriter(size_t maxBytes = 256 * 1024 * 1024);
+
+    //! \brief Waits for the queued files to be written.
+    ~AsyncWriter();
+
+    /*! \brief Queues a file to be written.
+
+      Any error from an earlier write is thrown here.
+
+      \param data The contents of the file.
+     */
+    void write(const std::string& fileName, std::string data);
+
+    /*! \brief Queues a file to be formatted and written.
+
+      Any error from an earlier write is thrown here.
+     */
+    void write(const std::string& fileName, const std::tr1::shared_ptr<Source>& source);
+
+    /*! \brief Blocks until all queued files have been written.
+
+      Any error from the background thread is thrown here.
+     */
+    void finish();
+
+  private:
+    AsyncWriter(const AsyncWriter&);
+    AsyncWriter& operator=(const AsyncWriter&);
+
+    void run();
+    void throwError();
+
+    typedef std::pair<std::string, std::tr1::shared_ptr<Source> > File;
+
+    magnet::thread::Thread _thread;
+    magnet::thread::Mutex _mutex;
+    magnet::thread::Condition _queued;
+    magnet::thread::Condition _written;
+    std::deque<File> _queue;
+    size_t _maxBytes;
+    size_t _bytes;
+    size_t _files;
+    bool _started;
+    bool _stop;
+    std::string _error;
+  };
+}
@@ -0,0 +1,162 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dynamo/checkpoint.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace dynamo {
+  namespace {
+    const char checkpointMagic[8] = {'D','y','n','a','m','O','C','P'};
+    const boost::uint32_t checkpointByteOrder = 0x01020304;
+    const boost::uint32_t checkpointVersion = 1;
+    const std::string checkpointExtension(".dynbin");
+
+    inline boost::uint64_t alignOffset(boost::uint64_t offset)
+    { return (offset + checkpointAlignment - 1) & ~boost::uint64_t(checkpointAlignment - 1); }
+
+    //! Tests the name of a block, without trusting it to be terminated.
+    inline bool hasName(const CheckpointBlock& block, const std::string& name)
+    {
+      const char* end = std::find(block.name, block.name + sizeof(block.name), '\0');
+      return !name.compare(0, std::string::npos, block.name, end - block.name);
+    }
+  }
+
+  bool
+  isCheckpointFile(const std::string& fileName)
+  {
+    return (fileName.size() >= checkpointExtension.size())
+      && (fileName.compare(fileName.size() - checkpointExtension.size(),
+			   checkpointExtension.size(), checkpointExtension) == 0);
+  }
+
+  CheckpointWriter::CheckpointWriter(const std::string& fileName):
+    _fileName(fileName),
+    _file(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+    _offset(alignOffset(sizeof(CheckpointHeader)))
+  {
+    if (!_file)
+      M_throw() << "Could not open \"" << fileName << "\" to write the checkpoint";
+
+    //The header is written once the layout is known
+    const std::vector<char> padding(_offset, 0);
+    _file.write(&padding[0], padding.size());
+  }
+
+  void
+  CheckpointWriter::addBlock(const std::string& name, const void* data, size_t bytes)
+  {
+    CheckpointBlock block;
+    if (name.size() >= sizeof(block.name))
+      M_throw() << "The checkpoint block name \"" << name << "\" is too long";
+
+    std::memset(&block, 0, sizeof(block));
+    name.copy(block.name, name.size());
+    block.offset = _offset;
+    block.bytes = bytes;
+    _blocks.push_back(block);
+
+    if (bytes) _file.write(static_cast<const char*>(data), bytes);
+
+    _offset = alignOffset(_offset + bytes);
+    _file.seekp(_offset);
+  }
+
+  void
+  CheckpointWriter::close()
+  {
+    CheckpointHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, checkpointMagic, sizeof(checkpointMagic));
+    header.byteOrder = checkpointByteOrder;
+    header.version = checkpointVersion;
+
+    const std::string xml = _xml.str();
+    header.xmlOffset = _offset;
+    header.xmlLength = xml.size();
+    _file.write(xml.data(), xml.size());
+
+    header.tableOffset = alignOffset(_offset + xml.size());
+    header.blockCount = _blocks.size();
+    _file.seekp(header.tableOffset);
+    if (!_blocks.empty())
+      _file.write(reinterpret_cast<const char*>(&_blocks[0]),
+		  _blocks.size() * sizeof(CheckpointBlock));
+
+    _file.seekp(0);
+    _file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    _file.close();
+
+    if (!_file)
+      M_throw() << "Failed while writing the checkpoint \"" << _fileName << "\"";
+  }
+
+  CheckpointReader::CheckpointReader(const std::string& fileName):
+    _fileName(fileName),
+    _file(fileName),
+    _blocks(NULL)
+  {
+    if (_file.size() < sizeof(CheckpointHeader))
+      M_throw() << "The file \"" << fileName << "\" is too small to be a checkpoint";
+
+    std::memcpy(&_header, _file.data(), sizeof(CheckpointHeader));
+
+    if (std::memcmp(_header.magic, checkpointMagic, sizeof(checkpointMagic)))
+      M_throw() << "The file \"" << fileName << "\" is not a DynamO checkpoint";
+
+    if (_header.byteOrder != checkpointByteOrder)
+      M_throw() << "The checkpoint \"" << fileName << "\" was written on a machine with a different byte order";
+
+    if (_header.version != checkpointVersion)
+      M_throw() << "The checkpoint \"" << fileName << "\" has version " << _header.version
+		<< ", but only version " << checkpointVersion << " can be read";
+
+    //The sizes are compared so that corrupt offsets cannot overflow
+    const boost::uint64_t size = _file.size();
+    if ((_header.xmlOffset > size) || (_header.xmlLength > size - _header.xmlOffset)
+	|| (_header.tableOffset > size)
+	|| (_header.blockCount > (size - _header.tableOffset) / sizeof(CheckpointBlock)))
+      M_throw() << "The checkpoint \"" << fileName << "\" is truncated";
+
+    _blocks = reinterpret_cast<const CheckpointBlock*>(_file.data() + _header.tableOffset);
+
+    for (size_t i(0); i < _header.blockCount; ++i)
+      if ((_blocks[i].offset > size) || (_blocks[i].bytes > size - _blocks[i].offset))
+	M_throw() << "The checkpoint \"" << fileName << "\" is truncated";
+  }
+
+  bool
+  CheckpointReader::hasBlock(const std::string& name) const
+  {
+    for (size_t i(0); i < _header.blockCount; ++i)
+      if (hasName(_blocks[i], name))
+	return true;
+    return false;
+  }
+
+  const CheckpointBlock&
+  CheckpointReader::findBlock(const std::string& name) const
+  {
+    for (size_t i(0); i < _header.blockCount; ++i)
+      if (hasName(_blocks[i], name))
+	return _blocks[i];
+
+    M_throw() << "Could not find the block \"" << name
+	      << "\" in the checkpoint \"" << _fileName << "\"";
+  }
+}
@@ -0,0 +1,160 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <magnet/exception.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/cstdint.hpp>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace dynamo {
+  /*! \brief The layout of a binary checkpoint file.
+
+    A binary checkpoint (a ".dynbin" file) holds the same
+    configuration as an XML file, but the bulk per-particle data is
+    stored as raw arrays which can be memory mapped instead of parsed.
+    The file is laid out as follows:
+
+    - A \ref CheckpointHeader.
+    - The data blocks, each starting on a \ref checkpointAlignment
+      byte boundary.
+    - The XML configuration, which is a normal configuration file with
+      the per-particle data replaced by references to the blocks.
+    - The table of \ref CheckpointBlock entries.
+
+    The file is only readable on a machine with the same byte order
+    and floating point format as the machine which wrote it.
+   */
+  struct CheckpointHeader
+  {
+    char magic[8];
+    boost::uint32_t byteOrder;
+    boost::uint32_t version;
+    boost::uint64_t xmlOffset;
+    boost::uint64_t xmlLength;
+    boost::uint64_t tableOffset;
+    boost::uint64_t blockCount;
+  };
+
+  //! \brief An entry in the block table of a binary checkpoint file.
+  struct CheckpointBlock
+  {
+    char name[48];
+    boost::uint64_t offset;
+    boost::uint64_t bytes;
+  };
+
+  //! \brief The alignment of the data blocks in a checkpoint file.
+  const size_t checkpointAlignment = 64;
+
+  //! \brief Tests if a file name refers to a binary checkpoint file.
+  bool isCheckpointFile(const std::string& fileName);
+
+  /*! \brief Writes a binary checkpoint file.
+
+    The data blocks are written to the file as they are added, while
+    the XML is collected in memory (it is small once the particle data
+    is removed) and written by \ref close().
+   */
+  class CheckpointWriter
+  {
+  public:
+    CheckpointWriter(const std::string& fileName);
+
+    //! \brief The stream the XML part of the checkpoint is written to.
+    std::ostream& xmlStream() { return _xml; }
+
+    /*! \brief Appends a named array to the checkpoint.
+
+      \param name The name used to fetch the array using
+      CheckpointReader::getBlock.
+     */
+    template<class T>
+    void addBlock(const std::string& name, const std::vector<T>& data)
+    { addBlock(name, data.empty() ? NULL : &data[0], data.size() * sizeof(T)); }
+
+    void addBlock(const std::string& name, const void* data, size_t bytes);
+
+    //! \brief Writes the XML and the block table, and closes the file.
+    void close();
+
+  private:
+    std::string _fileName;
+    std::ofstream _file;
+    std::ostringstream _xml;
+    std::vector<CheckpointBlock> _blocks;
+    boost::uint64_t _offset;
+  };
+
+  /*! \brief Memory maps a binary checkpoint file for reading.
+
+    The arrays returned by \ref getBlock point directly into the
+    mapping, so they remain valid only as long as the reader.
+   */
+  class CheckpointReader
+  {
+  public:
+    CheckpointReader(const std::string& fileName);
+
+    const char* xmlData() const { return _file.data() + _header.xmlOffset; }
+    size_t xmlLength() const { return _header.xmlLength; }
+
+    bool hasBlock(const std::string& name) const;
+
+    /*! \brief Returns the array stored under a name.
+
+      \param count Set to the number of elements in the array.
+     */
+    template<class T>
+    const T* getBlock(const std::string& name, size_t& count) const
+    {
+      const CheckpointBlock& block = findBlock(name);
+      if (block.bytes % sizeof(T))
+	M_throw() << "The checkpoint block \"" << name << "\" has a size of "
+		  << block.bytes << " bytes, which is not a multiple of "
+		  << sizeof(T);
+      count = block.bytes / sizeof(T);
+      return reinterpret_cast<const T*>(_file.data() + block.offset);
+    }
+
+    /*! \brief Returns the array stored under a name, checking it has
+        the expected number of elements.
+     */
+    template<class T>
+    const T* getBlock(const std::string& name, size_t expected, const std::string& what) const
+    {
+      size_t count;
+      const T* data = getBlock<T>(name, count);
+      if (count != expected)
+	M_throw() << "The checkpoint block \"" << name << "\" holds "
+		  << count << " entries of " << what << ", but " << expected
+		  << " were expected";
+      return data;
+    }
+
+  private:
+    const CheckpointBlock& findBlock(const std::string& name) const;
+
+    std::string _fileName;
+    boost::iostreams::mapped_file_source _file;
+    CheckpointHeader _header;
+    const CheckpointBlock* _blocks;
+  };
+}
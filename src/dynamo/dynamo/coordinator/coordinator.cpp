@@ -63,7 +63,7 @@ namespace dynamo {
       ("n-threads,N", po::value<unsigned int>(),
        "Number of threads to spawn for concurrent processing. (Only utilised by certain engine/sim configurations)")
       ("out-config-file,o", po::value<std::string>(),
-       "Default config output file,(config.%ID.end.xml.bz2)")
+       "Default config output file,(config.%ID.end.xml.bz2). Use a \".dynbin\" extension to write binary checkpoints")
       ("out-data-file", po::value<std::string>(),
        "Default result output file (output.%ID.xml.bz2)")
       ("config-file", po::value<std::vector<std::string> >(),
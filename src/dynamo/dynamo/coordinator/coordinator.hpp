@@ -23,7 +23,7 @@
 #pragma once
 
 #include <dynamo/coordinator/engine/engine.hpp>
-#include <magnet/thread/threadpool.hpp>
+#include <magnet/thread/workstealing.hpp>
 #include <boost/program_options.hpp>
 #include <vector>
 
@@ -33,7 +33,7 @@ namespace dynamo {
    
     This class is responsible for sorting out the correct simulation Engine to 
     run and initialising computational node specific objects like the 
-    ThreadPool.
+    WorkStealingPool.
    */
   class Coordinator
   {
@@ -112,16 +112,17 @@ namespace dynamo {
      */
     boost::program_options::variables_map vm;
 
-    /*! \brief A smart pointer to the Engine being run.
-     */
-    shared_ptr<Engine> _engine;
-
     /*! \brief A thread pool to utilise multiple cores on the
       computational node.
       
-      This ThreadPool is used/referenced by all code in a single
-      dynarun process.
+      This WorkStealingPool is used/referenced by all code in a single
+      dynarun process. It is declared before the Engine so that it
+      outlives it.
     */
-    magnet::thread::ThreadPool _threads;
+    magnet::thread::WorkStealingPool _threads;
+
+    /*! \brief A smart pointer to the Engine being run.
+     */
+    shared_ptr<Engine> _engine;
   };
 }
@@ -35,7 +35,7 @@ namespace dynamo {
   }
 
   ECompressingSimulation::ECompressingSimulation(const boost::program_options::variables_map& nVM, 
-						 magnet::thread::ThreadPool& tp):
+						 magnet::thread::WorkStealingPool& tp):
     ESingleSimulation(nVM, tp)
   {
     if (vm.count("target-pack-frac") && vm.count("target-density"))
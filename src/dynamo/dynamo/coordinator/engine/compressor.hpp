@@ -39,7 +39,7 @@ namespace dynamo {
      * \param tp The shared thread pool.
      */
     ECompressingSimulation(const boost::program_options::variables_map& vm,
-			   magnet::thread::ThreadPool& tp);
+			   magnet::thread::WorkStealingPool& tp);
 
     /*! \brief A trivial virtual destructor
      */
@@ -50,6 +50,9 @@ namespace dynamo {
       ("unwrapped", "Don't apply the boundary conditions of the system when writing out the particle positions.")
       ("snapshot", boost::program_options::value<double>(),
        "Sets the system time inbetween saving snapshots of the system.")
+      ("snapshot-memory", boost::program_options::value<size_t>()->default_value(256),
+       "The memory (in MB) which may be used by snapshots waiting to be written out "
+       "in the background. The simulation pauses if this is exceeded.")
       ;
   
     opts.add(simopts);
@@ -58,7 +61,7 @@ namespace dynamo {
 
   Engine::Engine(const boost::program_options::variables_map& nvm, 
 		 std::string configFile, std::string outputFile,
-		 magnet::thread::ThreadPool& tp):
+		 magnet::thread::WorkStealingPool& tp):
     vm(nvm),
     configFormat(configFile),
     outputFormat(outputFile),
@@ -105,7 +108,8 @@ namespace dynamo {
 #endif
 
     if (vm.count("snapshot"))
-      Sim.systems.push_back(shared_ptr<System>(new SSnapshot(&Sim, vm["snapshot"].as<double>(), "SnapshotEvent", !vm.count("unwrapped"))));
+      Sim.systems.push_back(shared_ptr<System>(new SSnapshot(&Sim, vm["snapshot"].as<double>(), "SnapshotEvent", !vm.count("unwrapped"),
+								 vm["snapshot-memory"].as<size_t>() * 1024 * 1024)));
 
     if (vm.count("load-plugin"))
       {
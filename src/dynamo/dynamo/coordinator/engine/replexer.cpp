@@ -21,9 +21,10 @@
 #include <dynamo/systems/andersenThermostat.hpp>
 #include <dynamo/dynamics/dynamics.hpp>
 #include <dynamo/schedulers/scheduler.hpp>
-#include <magnet/thread/threadpool.hpp>
+#include <magnet/thread/workstealing.hpp>
 #include <magnet/string/searchreplace.hpp>
 #include <boost/random/uniform_int.hpp>
+#include <algorithm>
 #include <fstream>
 #include <limits>
 #include <signal.h>
@@ -41,7 +42,10 @@ namespace dynamo {
        "other systems exchange interval is scaled by (T_cold/T_i)^{1/2} to try"
        "to keep the simulation calculation times approximately"
        "constant. Otherwise the high temperature system would consume all the"
-       "calculation time.")
+       "calculation time. The scaling is then adjusted during the run to balance"
+       "the measured calculation times.")
+      ("replex-static-interval", 
+       "Do not adjust the scaling of the replex-interval during the run.")
       ("replex-swap-mode", boost::program_options::value<unsigned int>()->default_value(1), 
        "System Swap Mode:\n"
        " Values:\n"
@@ -56,14 +60,16 @@ namespace dynamo {
   }
 
   EReplicaExchangeSimulation::EReplicaExchangeSimulation(const boost::program_options::variables_map& nVm,
-							 magnet::thread::ThreadPool& tp):
+							 magnet::thread::WorkStealingPool& tp):
     Engine(nVm, "config.%ID.end.xml.bz2", "output.%ID.xml.bz2", tp),
     replicaEndTime(0),
     ReplexMode(RandomSelection),
     replexSwapCalls(0),
     round_trips(0),
     SeqSelect(false),
-    nSims(0)
+    nSims(0),
+    _nextPlan(0),
+    _running(0)
   {
     if (vm["events"].as<size_t>() != std::numeric_limits<size_t>::max())
       M_throw() << "You cannot use collisions to control a replica exchange simulation\n"
@@ -162,6 +168,21 @@ namespace dynamo {
 			/ Simulations[i].ensemble->getReducedEnsembleVals()[2]); 
 	  Simulations[i].setTickerPeriod(vm["ticker-period"].as<double>() * tFactor);
 	}
+
+    //Each temperature's exchange interval starts inversely
+    //proportional to the square root of its temperature
+    _intervalFactor.clear();
+    BOOST_FOREACH(const replexPair& dat, temperatureList)
+      _intervalFactor.push_back(std::sqrt(temperatureList.begin()->second.realTemperature
+					  / dat.second.realTemperature));
+
+    _exchange.assign(nSims, 0);
+    _waiting.assign(nSims, false);
+    _wallRate.assign(nSims, 0);
+    _busyTime.assign(nSims, 0);
+    _plans.clear();
+    _nextPlan = 0;
+    _ranGenerator.seed(Simulations[0].ranGenerator());
   }
 
   void
@@ -280,42 +301,43 @@ namespace dynamo {
   }
 
   void 
-  EReplicaExchangeSimulation::ReplexSwapTicker()
+  EReplicaExchangeSimulation::ReplexSwapTicker(size_t tempID)
   {
-    //Update the counters indicating the replexSwap count
-    ++replexSwapCalls;
+    simData& dat = temperatureList[tempID].second;
 
-    for (size_t i(0); i < nSims; ++i)
-      ++(Simulations[i].replexExchangeNumber);
+    ++(Simulations[dat.simID].replexExchangeNumber);
 
     //Now update the histogramming
-    BOOST_FOREACH(replexPair& dat, temperatureList)
-      if (SimDirection[dat.second.simID])
-	{
-	  if (SimDirection[dat.second.simID] > 0)
-	    ++dat.second.upSims;
-	  else
-	    ++dat.second.downSims;
-	}
+    const int direction = SimDirection[dat.simID];
+    if (direction)
+      {
+	if (direction > 0)
+	  ++dat.upSims;
+	else
+	  ++dat.downSims;
+      }
 
-    if (SimDirection[temperatureList.front().second.simID] == -1)
+    if ((tempID == 0) && (direction == -1))
       {
-	if (roundtrip[temperatureList.front().second.simID])
+	if (roundtrip[dat.simID])
 	  ++round_trips;
 	
-	roundtrip[temperatureList.front().second.simID] = true;
+	roundtrip[dat.simID] = true;
       }
  
-    if (SimDirection[temperatureList.back().second.simID] == 1)
+    if ((tempID == temperatureList.size() - 1) && (direction == 1))
       {
-	if (roundtrip[temperatureList.back().second.simID])
+	if (roundtrip[dat.simID])
 	  ++round_trips;
 
-	roundtrip[temperatureList.back().second.simID] = true;
+	roundtrip[dat.simID] = true;
       }
 
-    SimDirection[temperatureList.front().second.simID] = 1; //Going up
-    SimDirection[temperatureList.back().second.simID] = -1; //Going down
+    if (tempID == 0)
+      SimDirection[dat.simID] = 1; //Going up
+
+    if (tempID == temperatureList.size() - 1)
+      SimDirection[dat.simID] = -1; //Going down
   }
 
   void 
@@ -343,7 +365,7 @@ namespace dynamo {
   }
 
   void
-  EReplicaExchangeSimulation::outputData()
+  EReplicaExchangeSimulation::outputReplexStats()
   {
     {
       std::fstream replexof("replex.dat",std::ios::out | std::ios::trunc);
@@ -361,21 +383,234 @@ namespace dynamo {
     }
   
     {      
+      timespec endTime;
+      clock_gettime(CLOCK_MONOTONIC, &endTime);
+      const double duration = double(endTime.tv_sec) - double(_startTime.tv_sec)
+	+ 1e-9 * (double(endTime.tv_nsec) - double(_startTime.tv_nsec));
+
+      double busyTime(0);
+      BOOST_FOREACH(const double& time, _busyTime)
+	busyTime += time;
+
       std::fstream replexof("replex.stats", std::ios::out | std::ios::trunc);
     
       replexof << "Number_of_replex_cycles " << replexSwapCalls
 	       << "\nTime_spent_replexing " <<  boost::posix_time::to_simple_string(end_Time - start_Time)
 	       << "\nReplex Rate " << static_cast<double>(replexSwapCalls) / static_cast<double>((end_Time - start_Time).total_seconds())
-	       << "\n";	
+	       << "\nCore_utilisation " << busyTime / (duration * std::max(threads.getThreadCount(), size_t(1)))
+	       << "\n";
+
+      //The fraction of the wall clock time each temperature was
+      //running, and its current scaling of the replex-interval
+      replexof << "#Replica_utilisation Temperature Utilisation Busy_seconds Interval_factor\n";
+      for (size_t i(0); i < _busyTime.size(); ++i)
+	replexof << "Replica_utilisation " << temperatureList[i].second.realTemperature
+		 << " " << _busyTime[i] / duration
+		 << " " << _busyTime[i]
+		 << " " << _intervalFactor[i]
+		 << "\n";
     
       replexof.close();
     }    
-  
+  }
+
+  void
+  EReplicaExchangeSimulation::outputData()
+  {
+    outputReplexStats();
+
+    //The replicas are independent, so they are written in parallel
+    std::vector<magnet::thread::WorkStealingPool::Future> writes;
     int i = 0;
-  
     BOOST_FOREACH(replexPair p1, temperatureList)
-      Simulations[p1.second.simID].outputData
-      ((magnet::string::search_replace(outputFormat, "%ID", boost::lexical_cast<std::string>(i++))).c_str());
+      writes.push_back(threads.submit(magnet::function::Task::makeTask
+				      (&Simulation::outputData, &static_cast<Simulation&>(Simulations[p1.second.simID]),
+				       magnet::string::search_replace(outputFormat, "%ID", boost::lexical_cast<std::string>(i++)))));
+
+    waitForAll(writes);
+  }
+
+  void
+  EReplicaExchangeSimulation::waitForAll(std::vector<magnet::thread::WorkStealingPool::Future>& futures)
+  {
+    //Every task is waited on before any failure is reported
+    std::string error;
+    for (size_t i(0); i < futures.size(); ++i)
+      if (futures[i].valid())
+	try { futures[i].wait(); }
+	catch (std::exception& err)
+	  { error += std::string("\n") + err.what(); }
+
+    futures.clear();
+
+    if (!error.empty())
+      M_throw() << "A replica task failed:" << error;
+  }
+
+  void
+  EReplicaExchangeSimulation::runReplica(size_t simID)
+  {
+    timespec startTime, endTime;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    //Exceptions are passed back to the main thread, so it may wait
+    //for the other replicas to stop before throwing
+    std::string error;
+    try {
+      Simulations[simID].runSimulation(true);
+    } catch (std::exception& err)
+      { error = err.what(); }
+
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    const double duration = double(endTime.tv_sec) - double(startTime.tv_sec)
+      + 1e-9 * (double(endTime.tv_nsec) - double(startTime.tv_nsec));
+
+    magnet::thread::ScopedLock lock(_finishedMutex);
+    _finished.push_back(FinishedRun(simID, duration, error));
+    _finishedCondition.notify_all();
+  }
+
+  void
+  EReplicaExchangeSimulation::startReplica(size_t tempID)
+  {
+    ++_running;
+    const size_t simID = temperatureList[tempID].second.simID;
+    _replicaRuns[simID] = threads.submit(magnet::function::Task::makeTask(&EReplicaExchangeSimulation::runReplica, this, simID));
+  }
+
+  const EReplicaExchangeSimulation::ExchangePlan&
+  EReplicaExchangeSimulation::getPlan(size_t exchange)
+  {
+    //The plans are made in order, so the random numbers are drawn in
+    //the same sequence however the replicas arrive
+    for (; _nextPlan <= exchange; ++_nextPlan)
+      makePlan(_plans[_nextPlan], ReplexMode);
+
+    return _plans[exchange];
+  }
+
+  void
+  EReplicaExchangeSimulation::makePlan(ExchangePlan& plan, Replex_Mode_Type localMode)
+  {
+    plan.partner.assign(nSims, -1);
+
+    if (temperatureList.size() < 2) return;
+
+    switch (localMode)
+      {
+      case NoSwapping:
+	break;
+      case SinglePair:
+	{
+	  size_t ID = 0;
+	  if (temperatureList.size() > 2)
+	    ID = boost::variate_generator<dynamo::baseRNG&, boost::uniform_int<unsigned int> >
+	      (_ranGenerator, boost::uniform_int<unsigned int>(0, temperatureList.size()-2))();
+
+	  plan.partner[ID] = ID + 1;
+	  plan.partner[ID + 1] = ID;
+	}
+	break;
+      case AlternatingSequence:
+	{
+	  for (size_t i = (SeqSelect) ? 0 : 1; i < (nSims -1); i +=2)
+	    {
+	      plan.partner[i] = i + 1;
+	      plan.partner[i + 1] = i;
+	    }
+	
+	  SeqSelect = !SeqSelect;
+	}
+	break;
+      case RandomPairs:
+	//Any temperature may be paired with any other, so they must
+	//all reach the exchange first
+	plan.global = true;
+	break;
+      case RandomSelection:
+	{
+	  boost::variate_generator<dynamo::baseRNG&, boost::uniform_int<> >
+	    rPID(_ranGenerator, boost::uniform_int<>(0, 1));
+	
+	  makePlan(plan, rPID() ? RandomPairs : AlternatingSequence);
+	}
+	break;
+      }
+  }
+
+  std::vector<size_t>
+  EReplicaExchangeSimulation::tryExchange(size_t tempID)
+  {
+    std::vector<size_t> completed;
+
+    const size_t exchange = _exchange[tempID];
+    const ExchangePlan& plan = getPlan(exchange);
+
+    if (plan.global)
+      {
+	for (size_t i(0); i < nSims; ++i)
+	  if (!_waiting[i] || (_exchange[i] != exchange))
+	    return completed;
+
+	ReplexSwap(RandomPairs);
+
+	for (size_t i(0); i < nSims; ++i)
+	  completed.push_back(i);
+      }
+    else
+      {
+	const int partner = plan.partner[tempID];
+	if (partner < 0)
+	  completed.push_back(tempID);
+	else if (_waiting[partner] && (_exchange[partner] == exchange))
+	  {
+	    AttemptSwap(std::min(tempID, size_t(partner)), std::max(tempID, size_t(partner)));
+	    completed.push_back(tempID);
+	    completed.push_back(partner);
+	  }
+      }
+
+    BOOST_FOREACH(const size_t& id, completed)
+      completeExchange(id);
+
+    return completed;
+  }
+
+  void
+  EReplicaExchangeSimulation::completeExchange(size_t tempID)
+  {
+    ReplexSwapTicker(tempID);
+
+    _waiting[tempID] = false;
+    ++_exchange[tempID];
+
+    //Balance the wall clock time of each temperature against the
+    //coldest. The change is damped, and limited to a factor of two
+    //per exchange.
+    if (!vm.count("replex-static-interval") && tempID && (_wallRate[tempID] > 0) && (_wallRate[0] > 0))
+      {
+	const double target = _intervalFactor[0] * _wallRate[0] / _wallRate[tempID];
+	const double factor = std::sqrt(_intervalFactor[tempID] * target);
+	_intervalFactor[tempID] = std::min(2 * _intervalFactor[tempID], 
+					   std::max(0.5 * _intervalFactor[tempID], factor));
+      }
+
+    Simulation& sim = Simulations[temperatureList[tempID].second.simID];
+
+    //Reset the stop event
+    shared_ptr<SystHalt> tmpRef = std::tr1::dynamic_pointer_cast<SystHalt>(sim.systems["ReplexHalt"]);
+		
+#ifdef DYNAMO_DEBUG
+    if (!tmpRef)
+      M_throw() << "Could not find the time halt event error";
+#endif			
+
+    tmpRef->increasedt(vm["replex-interval"].as<double>() * _intervalFactor[tempID]);
+
+    sim.ptrScheduler->rebuildSystemEvents();
+
+    //Reset the max collisions
+    sim.endEventCount = vm["events"].as<size_t>();
   }
 
   void EReplicaExchangeSimulation::runSimulation()
@@ -383,10 +618,114 @@ namespace dynamo {
     clock_gettime(CLOCK_MONOTONIC, &_startTime);
     start_Time = boost::posix_time::second_clock::local_time();
 
-    while (((Simulations[0].systemTime / Simulations[0].units.unitTime()) < replicaEndTime)
-	   && (Simulations[0].eventCount < vm["events"].as<size_t>()))
+    const double interval = vm["replex-interval"].as<double>();
+
+    std::string error;
+    std::vector<size_t> paused;
+
+    _replicaRuns.resize(nSims);
+
+    //The first run is zero length, so an exchange occurs immediately
+    for (size_t i(0); i < nSims; ++i)
+      startReplica(i);
+
+    while (_running)
       {
-	if (_SIGINT)
+	std::vector<FinishedRun> finished;
+	{
+	  magnet::thread::ScopedLock lock(_finishedMutex);
+	  while (_finished.empty())
+	    if (threads.getThreadCount())
+	      _finishedCondition.wait(_finishedMutex);
+	    else
+	      {
+		//Without any threads, the queued replicas are run here
+		lock.unlock();
+		BOOST_FOREACH(magnet::thread::WorkStealingPool::Future& run, _replicaRuns)
+		  if (run.valid() && !run.ready())
+		    {
+		      run.wait();
+		      break;
+		    }
+		lock.lock();
+	      }
+
+	  finished.swap(_finished);
+	}
+
+	BOOST_FOREACH(const FinishedRun& run, finished)
+	  {
+	    --_running;
+	    
+	    if (!run.error.empty())
+	      {
+		error += "\n" + run.error;
+		continue;
+	      }
+
+	    size_t tempID(0);
+	    while (size_t(temperatureList[tempID].second.simID) != run.simID) ++tempID;
+
+	    _busyTime[tempID] += run.seconds;
+	    
+	    //The first run is zero length, so it is not used to balance
+	    //the intervals
+	    if (_exchange[tempID])
+	      {
+		const double rate = run.seconds / _intervalFactor[tempID];
+		_wallRate[tempID] = (_wallRate[tempID] > 0) ? (0.8 * _wallRate[tempID] + 0.2 * rate) : rate;
+	      }
+
+	    _waiting[tempID] = true;
+
+	    BOOST_FOREACH(const size_t& id, tryExchange(tempID))
+	      if (!error.empty() || ((_exchange[id] - 1) * interval >= replicaEndTime))
+		continue;
+	      else if (_SIGINT)
+		paused.push_back(id);
+	      else
+		startReplica(id);
+	  }
+
+	//The exchanges that every temperature has completed
+	const size_t completedExchanges = *std::min_element(_exchange.begin(), _exchange.end());
+	_plans.erase(_plans.begin(), _plans.lower_bound(completedExchanges));
+
+	if (completedExchanges != replexSwapCalls)
+	  {
+	    replexSwapCalls = completedExchanges;
+
+	    timespec endTime;
+	    clock_gettime(CLOCK_MONOTONIC, &endTime);
+	    
+	    double duration = double(endTime.tv_sec) - double(_startTime.tv_sec)
+	      + 1e-9 * (double(endTime.tv_nsec) - double(_startTime.tv_nsec));
+	    
+	    double fractionComplete = ((replexSwapCalls - 1) * interval) / replicaEndTime;
+	    double seconds_remaining_double = duration * (1/ fractionComplete - 1);
+	    size_t seconds_remaining = seconds_remaining_double;
+	    
+	    if (seconds_remaining_double < std::numeric_limits<size_t>::max())
+	      {
+		size_t ETA_hours = seconds_remaining / 3600;
+		size_t ETA_mins = (seconds_remaining / 60) % 60;
+		size_t ETA_secs = seconds_remaining % 60;
+		
+		std::cout << "\rReplica Exchange No." << replexSwapCalls << ", ETA ";
+		if (ETA_hours)
+		  std::cout << ETA_hours << "hr ";
+		
+		if (ETA_mins)
+		  std::cout << ETA_mins << "min ";
+		
+		std::cout << ETA_secs << "s        ";
+		std::cout.flush();
+	      }
+	  }
+
+	//The replicas are paused on a SIGINT, so that the data
+	//output is consistent
+	if (_SIGINT && !_running && error.empty())
 	  {
 	    //Clear the writes to screen
 	    std::cout.flush();
@@ -406,7 +745,7 @@ namespace dynamo {
 		  replicaEndTime = 0.0;
 		  for (unsigned int i = 0; i < nSims; i++)
 		    Simulations[i].simShutdown();
-		  continue;
+		  paused.clear();
 		  break;
 		}
 	      case 'p':
@@ -422,31 +761,7 @@ namespace dynamo {
 											      "%ID", boost::lexical_cast<std::string>(i++))));
 		    }
 		  
-		  {
-		    std::fstream replexof("replex.dat",std::ios::out | std::ios::trunc);
-		    
-		    BOOST_FOREACH(const replexPair& myPair, temperatureList)
-		      replexof << myPair.second.realTemperature << " " 
-			       << myPair.second.swaps << " " 
-			       << (static_cast<double>(myPair.second.swaps) 
-				   / static_cast<double>(myPair.second.attempts))  << " "
-			       << myPair.second.upSims << " "
-			       << myPair.second.downSims
-			       << "\n";
-		    
-		    replexof.close();      
-		  }
-		  
-		  {      
-		    std::fstream replexof("replex.stats", std::ios::out | std::ios::trunc);
-		    
-		    replexof << "Number_of_replex_cycles " << replexSwapCalls
-			     << "\nTime_spent_replexing " <<  boost::posix_time::to_simple_string(end_Time - start_Time)
-			     << "\nReplex Rate " << static_cast<double>(replexSwapCalls) / static_cast<double>((end_Time - start_Time).total_seconds())
-			     << "\n";	
-		    
-		    replexof.close();
-		  }		  
+		  outputReplexStats();
 		  break;
 		}
 	      case 'd':
@@ -490,75 +805,19 @@ namespace dynamo {
 	      new_action.sa_flags = 0;
 	      sigaction(SIGINT, &new_action, NULL);
 	    }
-	  }
-	  {
-	    //Run the simulations. We also generate all tasks at once
-	    //and submit them all at once to minimise lock contention.
-	    std::vector<magnet::function::Task*> tasks(nSims, NULL);
-	  
-	    for (size_t i(0); i < nSims; ++i)
-	      tasks[i] = magnet::function::Task::makeTask(&Simulation::runSimulation, &static_cast<Simulation&>(Simulations[i]), true);
-
-	    threads.queueTasks(tasks);
-	    threads.wait();//This syncs the systems for the replica exchange
-		  
-	    //Swap calculation
-	    ReplexSwap(ReplexMode);
-		  
-	    ReplexSwapTicker();
-		  
-	    //Reset the stop events
-	    for (size_t i = nSims; i != 0;)
-	      {
-		//Reset the stop event
-		shared_ptr<SystHalt> tmpRef = std::tr1::dynamic_pointer_cast<SystHalt>
-		  (Simulations[--i].systems["ReplexHalt"]);
-		
-#ifdef DYNAMO_DEBUG
-		if (!tmpRef)
-		  M_throw() << "Could not find the time halt event error";
-#endif			
-		//Each simulations exchange time is inversly proportional to its temperature
-		double tFactor 
-		  = std::sqrt(temperatureList.begin()->second.realTemperature
-			      / Simulations[i].ensemble->getReducedEnsembleVals()[2]); 
 
-		tmpRef->increasedt(vm["replex-interval"].as<double>() * tFactor);
+	    BOOST_FOREACH(const size_t& id, paused)
+	      startReplica(id);
+	    paused.clear();
+	  }
+      }
 
-		Simulations[i].ptrScheduler->rebuildSystemEvents();
+    //Collect any exceptions from the replica runs
+    waitForAll(_replicaRuns);
 
-		//Reset the max collisions
-		Simulations[i].endEventCount = vm["events"].as<size_t>();
-	      }
+    if (!error.empty())
+      M_throw() << "A replica failed while running:" << error;
 
-	    timespec endTime;
-	    clock_gettime(CLOCK_MONOTONIC, &endTime);
-	    
-	    double duration = double(endTime.tv_sec) - double(_startTime.tv_sec)
-	      + 1e-9 * (double(endTime.tv_nsec) - double(_startTime.tv_nsec));
-	    
-	    double fractionComplete = (Simulations[0].systemTime / Simulations[0].units.unitTime()) / replicaEndTime;
-	    double seconds_remaining_double = duration * (1/ fractionComplete - 1);
-	    size_t seconds_remaining = seconds_remaining_double;
-	    
-	    if (seconds_remaining_double < std::numeric_limits<size_t>::max())
-	      {
-		size_t ETA_hours = seconds_remaining / 3600;
-		size_t ETA_mins = (seconds_remaining / 60) % 60;
-		size_t ETA_secs = seconds_remaining % 60;
-		
-		std::cout << "\rReplica Exchange No." << replexSwapCalls << ", ETA ";
-		if (ETA_hours)
-		  std::cout << ETA_hours << "hr ";
-		
-		if (ETA_mins)
-		  std::cout << ETA_mins << "min ";
-		
-		std::cout << ETA_secs << "s        ";
-		std::cout.flush();
-	      }
-	  }
-      }
     end_Time = boost::posix_time::second_clock::local_time();
   }
 
@@ -567,13 +826,19 @@ namespace dynamo {
   {
     std::fstream TtoID("TtoID.dat",std::ios::out | std::ios::trunc);
   
+    //The replicas are independent, so they are written in parallel
+    std::vector<magnet::thread::WorkStealingPool::Future> writes;
     int i = 0;
     BOOST_FOREACH(replexPair p1, temperatureList)
       {
 	TtoID << p1.second.realTemperature << " " << i << "\n";
 	Simulations[p1.second.simID].endEventCount = vm["events"].as<size_t>();
-	Simulations[p1.second.simID].writeXMLfile(magnet::string::search_replace(configFormat, "%ID", boost::lexical_cast<std::string>(i++)), 
-						  !vm.count("unwrapped"));
+	writes.push_back(threads.submit(magnet::function::Task::makeTask
+					(&Simulation::writeXMLfile, &static_cast<Simulation&>(Simulations[p1.second.simID]),
+					 magnet::string::search_replace(configFormat, "%ID", boost::lexical_cast<std::string>(i++)),
+					 !vm.count("unwrapped"), false)));
       }
+
+    waitForAll(writes);
   }
 }
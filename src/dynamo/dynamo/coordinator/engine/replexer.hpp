@@ -21,8 +21,10 @@
 #pragma once
 
 #include <dynamo/coordinator/engine/engine.hpp>
+#include <magnet/thread/workstealing.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <ctime>
+#include <map>
 
 namespace dynamo {
   /*! \brief The Replica Exchange/Parallel Tempering Engine.
@@ -32,8 +34,17 @@ namespace dynamo {
    * periodically and then the configurations of the particles positions
    * are swapped along with a rescaling of the particles velocities.
    *
-   * This class uses the ThreadPool to parallelise the running of the
-   * simulations.
+   * This class uses the WorkStealingPool to parallelise the running of the
+   * simulations. There is no global barrier between the exchanges:
+   * each replica runs on to its next exchange as soon as its own
+   * exchange is complete, so only the two replicas of a proposed swap
+   * wait for each other. The exchanges are counted separately for
+   * each temperature, and the \ref ExchangePlan of each exchange
+   * decides which temperatures are paired.
+   *
+   * The interval between exchanges at each temperature is also
+   * adjusted so that every replica takes a similar amount of wall
+   * clock time to reach its next exchange.
    */
   class EReplicaExchangeSimulation: public Engine
   {
@@ -41,10 +52,10 @@ namespace dynamo {
     /*! \brief The only constructor.
      *
      * \param vm The parsed command line options held by the Coordinator.
-     * \param tp The ThreadPool for this instance of dynarun.
+     * \param tp The WorkStealingPool for this instance of dynarun.
      */
     EReplicaExchangeSimulation(const boost::program_options::variables_map& vm, 
-			       magnet::thread::ThreadPool& tp);
+			       magnet::thread::WorkStealingPool& tp);
   
     /*! \brief A trivial virtual destructor. 
      */
@@ -133,6 +144,24 @@ namespace dynamo {
 
     typedef std::pair<double, simData> replexPair;
 
+    /*! \brief The pairs of temperatures which attempt an exchange in
+     * a single exchange phase.
+     */
+    struct ExchangePlan
+    {
+      ExchangePlan(): global(false) {}
+
+      /*! \brief If true, every temperature must reach the exchange
+       * before the random pairs are picked (see RandomPairs).
+       */
+      bool global;
+
+      /*! \brief The temperature index each temperature is paired
+       * with, or -1 if it is not paired.
+       */
+      std::vector<int> partner;
+    };
+
     /*! \brief The array of Simulations being run.
      */
     boost::scoped_array<Simulation> Simulations;
@@ -190,6 +219,67 @@ namespace dynamo {
 
     timespec _startTime;
 
+    /*! \brief The number of the exchange each temperature is at or
+     * running towards.
+     */
+    std::vector<size_t> _exchange;
+
+    /*! \brief Set if the Simulation at a temperature has reached its
+     * exchange and is waiting to be paired.
+     */
+    std::vector<char> _waiting;
+
+    /*! \brief The scaling of the replex-interval at each temperature.
+     */
+    std::vector<double> _intervalFactor;
+
+    /*! \brief A running average of the wall clock time taken per
+     * unit of the replex-interval at each temperature.
+     */
+    std::vector<double> _wallRate;
+
+    /*! \brief The total wall clock time spent running each
+     * temperature.
+     */
+    std::vector<double> _busyTime;
+
+    /*! \brief The plans of the exchanges which are not yet complete.
+     */
+    std::map<size_t, ExchangePlan> _plans;
+
+    /*! \brief The next exchange to make a plan for.
+     */
+    size_t _nextPlan;
+
+    /*! \brief The random number generator used to plan the
+     * exchanges, as the Simulation's generators may be in use.
+     */
+    baseRNG _ranGenerator;
+
+    /*! \brief A Simulation which has finished running to its exchange.
+     */
+    struct FinishedRun
+    {
+      FinishedRun(size_t id, double s, const std::string& err):
+	simID(id), seconds(s), error(err) {}
+      size_t simID;
+      double seconds;
+      std::string error;
+    };
+
+    magnet::thread::Mutex _finishedMutex;
+    magnet::thread::Condition _finishedCondition;
+    std::vector<FinishedRun> _finished;
+
+    /*! \brief The number of Simulations queued or running.
+     */
+    size_t _running;
+
+    /*! \brief The last run of each Simulation on the pool, indexed
+     * by the simulation ID.
+     */
+    std::vector<magnet::thread::WorkStealingPool::Future> _replicaRuns;
+
     /*! \brief Initialises this class ready for the replica exchange.
      */
     virtual void preSimInit();
@@ -222,9 +312,10 @@ namespace dynamo {
     void ReplexDataOutput(std::vector<std::string>&);
   
     /*! \brief After every replica exchange phase this function is
-     * called to update the replica exchange data collected.
+     * called for each temperature to update the replica exchange data
+     * collected.
      */
-    void ReplexSwapTicker();
+    void ReplexSwapTicker(size_t tempID);
 
     /*! \brief Attempt a replica exchange move between two configurations.
      *
@@ -232,5 +323,49 @@ namespace dynamo {
      * \param id2 Second Simulation to attempt to exchange.
      */
     void AttemptSwap(const unsigned int id1, const unsigned int id2);
+
+    /*! \brief Runs a Simulation to its next exchange, then reports
+     * that it has finished.
+     *
+     * This is run on the WorkStealingPool.
+     */
+    void runReplica(size_t simID);
+
+    /*! \brief Queues the Simulation at a temperature to run to its
+     * next exchange.
+     */
+    void startReplica(size_t tempID);
+
+    /*! \brief Waits on every task of a list, then reports any
+     * exceptions they threw.
+     */
+    void waitForAll(std::vector<magnet::thread::WorkStealingPool::Future>&);
+
+    /*! \brief Attempt the exchanges which are possible now that the
+     * Simulation at a temperature has reached its exchange.
+     *
+     * \return The temperatures which have completed the exchange.
+     */
+    std::vector<size_t> tryExchange(size_t tempID);
+
+    /*! \brief Records that a temperature has completed its exchange
+     * and sets the time of its next exchange.
+     */
+    void completeExchange(size_t tempID);
+
+    /*! \brief Returns the plan for an exchange, generating the plans
+     * in order as they are needed.
+     */
+    const ExchangePlan& getPlan(size_t exchange);
+
+    /*! \brief Generates the plan for the next exchange.
+     *
+     * \param localMode The type of replica exchange phase to plan.
+     */
+    void makePlan(ExchangePlan& plan, Replex_Mode_Type localMode);
+
+    /*! \brief Writes the replex.dat and replex.stats files.
+     */
+    void outputReplexStats();
   };
 }
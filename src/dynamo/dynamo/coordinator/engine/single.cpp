@@ -22,7 +22,7 @@
 
 namespace dynamo {
   ESingleSimulation::ESingleSimulation(const boost::program_options::variables_map& nVM, 
-				       magnet::thread::ThreadPool& tp):
+				       magnet::thread::WorkStealingPool& tp):
     Engine(nVM, "config.out.xml.bz2", "output.xml.bz2", tp)
   {}
 
@@ -90,6 +90,9 @@ namespace dynamo {
 	(vm["config-file"].as<std::vector<std::string> >().size() != 1))
       M_throw() << "You must only provide one input file in single mode";
 
+    //The threads are also used to decompress the configuration
+    simulation.threadPool = &threads;
+
     setupSim(simulation, vm["config-file"].as<std::vector<std::string> >()[0]);
 
     simulation.initialise();
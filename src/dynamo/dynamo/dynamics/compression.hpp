@@ -32,6 +32,9 @@ namespace dynamo {
   {
   public:
     DynCompression(dynamo::Simulation*, double);
+    //! The growth rate of the particles is not scaled with the velocities
+    virtual bool eventTimesScaleWithVelocity() const { return false; }
+
     virtual double SphereSphereInRoot(const Particle& p1, const Particle& p2, double d) const;
     virtual double SphereSphereOutRoot(const Particle& p1, const Particle& p2, double d) const;  
     virtual double sphereOverlap(const Particle& p1, const Particle& p2, const double& d) const;
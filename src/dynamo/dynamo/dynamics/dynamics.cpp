@@ -21,11 +21,31 @@
 #include <dynamo/NparticleEventData.hpp>
 #include <dynamo/units/units.hpp>
 #include <dynamo/BC/LEBC.hpp>
+#include <dynamo/checkpoint.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <magnet/xmlreader.hpp>
 #include <boost/foreach.hpp>
 
 namespace dynamo {
+  namespace {
+    /*! Writes the tags of a particle, in the units of the
+      configuration file, within its Pt tag.
+    */
+    void outputParticle(magnet::xml::XmlStream& XML, const Particle& part, 
+			const Dynamics::rotData* rot)
+    {
+      XML << part;
+
+      if (rot)
+	XML << magnet::xml::tag("O")
+	    << rot->angularVelocity
+	    << magnet::xml::endtag("O")
+	    << magnet::xml::tag("U")
+	    << rot->orientation
+	    << magnet::xml::endtag("U") ;
+    }
+  }
+
   magnet::xml::XmlStream& operator<<(magnet::xml::XmlStream& XML, const Dynamics& g)
   {
     g.outputXML(XML);
@@ -47,6 +67,18 @@ namespace dynamo {
   }
 
 
+  void
+  Dynamics::reorderParticles(const std::vector<size_t>& order)
+  {
+    if (!hasOrientationData()) return;
+
+    std::vector<rotData> newData;
+    newData.reserve(order.size());
+    for (std::vector<size_t>::const_iterator it = order.begin(); it != order.end(); ++it)
+      newData.push_back(orientationData[*it]);
+    orientationData.swap(newData);
+  }
+
   void 
   Dynamics::initialise()
   {
@@ -106,6 +138,18 @@ namespace dynamo {
   void 
   Dynamics::loadParticleXMLData(const magnet::xml::Node& XML)
   {
+    if (Sim->checkpointIn)
+      {
+	loadParticleBinaryData(XML, *Sim->checkpointIn);
+	return;
+      }
+
+    if (Sim->particleStreamIn)
+      {
+	loadParticleStreamData(XML, *Sim->particleStreamIn);
+	return;
+      }
+
     dout << "Loading Particle Data" << std::endl;
 
     bool outofsequence = false;  
@@ -154,10 +198,124 @@ namespace dynamo {
       }
   }
 
+  void
+  Dynamics::loadParticleBinaryData(const magnet::xml::Node& XML, const CheckpointReader& checkpoint)
+  {
+    dout << "Loading Particle Data from the checkpoint" << std::endl;
+
+    const magnet::xml::Node particleNode = XML.getNode("ParticleData");
+    const size_t N = particleNode.getAttribute("N").as<size_t>();
+
+    const double* positions
+      = checkpoint.getBlock<double>("Positions", N * NDIM, "position components");
+    const double* velocities
+      = checkpoint.getBlock<double>("Velocities", N * NDIM, "velocity components");
+    const boost::int32_t* states
+      = checkpoint.getBlock<boost::int32_t>("States", N, "particle states");
+
+    Sim->particles.reserve(N);
+    for (size_t i(0); i < N; ++i)
+      {
+	Vector pos, vel;
+	for (size_t iDim(0); iDim < NDIM; ++iDim)
+	  {
+	    pos[iDim] = positions[NDIM * i + iDim] * Sim->units.unitLength();
+	    vel[iDim] = velocities[NDIM * i + iDim] * Sim->units.unitVelocity();
+	  }
+
+	Sim->particles.push_back(Particle(pos, vel, i));
+	if (!(states[i] & Particle::DYNAMIC))
+	  Sim->particles.back().clearState(Particle::DYNAMIC);
+      }
+
+    Sim->N = N;
+
+    dout << "Particle count " << Sim->N << std::endl;
+
+    if (particleNode.hasAttribute("OrientationData"))
+      {
+	const double* orientations
+	  = checkpoint.getBlock<double>("Orientations", N * NDIM, "orientation components");
+	const double* angularVelocities
+	  = checkpoint.getBlock<double>("AngularVelocities", N * NDIM, "angular velocity components");
+
+	orientationData.resize(N);
+	for (size_t i(0); i < N; ++i)
+	  {
+	    for (size_t iDim(0); iDim < NDIM; ++iDim)
+	      {
+		orientationData[i].orientation[iDim] = orientations[NDIM * i + iDim];
+		orientationData[i].angularVelocity[iDim] = angularVelocities[NDIM * i + iDim];
+	      }
+
+	    double oL = orientationData[i].orientation.nrm();
+      
+	    if (!(oL > 0.0))
+	      M_throw() << "Particle ID " << i 
+			<< " orientation vector is zero!";
+      
+	    orientationData[i].orientation /= oL;
+	  }
+      }
+  }
+
+  void
+  Dynamics::loadParticleStreamData(const magnet::xml::Node& XML, ParticleStreamReader& stream)
+  {
+    dout << "Loading Particle Data" << std::endl;
+
+    //The particles are moved, not copied, out of the stream
+    Sim->particles.swap(stream.getParticles());
+    for (ParticleContainer::iterator iPtr = Sim->particles.begin();
+	 iPtr != Sim->particles.end(); ++iPtr)
+      {
+	iPtr->getVelocity() *= Sim->units.unitVelocity();
+	iPtr->getPosition() *= Sim->units.unitLength();
+      }
+
+    if (stream.outOfSequence())
+      dout << "Particle ID's out of sequence!\n"
+	   << "This can result in incorrect capture map loads etc.\n"
+	   << "Erase any capture maps in the configuration file so they are regenerated." << std::endl;
+
+    Sim->N = Sim->particles.size();
+
+    dout << "Particle count " << Sim->N << std::endl;
+
+    if (XML.getNode("ParticleData").hasAttribute("OrientationData"))
+      {
+	const std::vector<Vector>& orientations = stream.getOrientations();
+	const std::vector<Vector>& angularVelocities = stream.getAngularVelocities();
+
+	orientationData.resize(Sim->N);
+	for (size_t i(0); i < Sim->N; ++i)
+	  {
+	    orientationData[i].orientation = orientations[i];
+	    orientationData[i].angularVelocity = angularVelocities[i];
+
+	    double oL = orientationData[i].orientation.nrm();
+      
+	    if (!(oL > 0.0))
+	      M_throw() << "Particle ID " << i 
+			<< " orientation vector is zero!";
+      
+	    //Makes the vector a unit vector
+	    orientationData[i].orientation /= oL;
+	  }
+      }
+  }
+
   void 
   Dynamics::outputParticleXMLData(magnet::xml::XmlStream& XML, bool applyBC) const
   {
-    XML << magnet::xml::tag("ParticleData");
+    if (Sim->checkpointOut)
+      {
+	outputParticleBinaryData(XML, *Sim->checkpointOut, applyBC);
+	return;
+      }
+
+    XML << magnet::xml::tag("ParticleData")
+	<< magnet::xml::attr("N") << Sim->N;
   
     if (hasOrientationData())
       XML << magnet::xml::attr("OrientationData") << "Y";
@@ -173,22 +331,113 @@ namespace dynamo {
       
 	XML << magnet::xml::tag("Pt");
 	Sim->_properties.outputParticleXMLData(XML, i);
-	XML << tmp;
+	outputParticle(XML, tmp, hasOrientationData() ? &orientationData[i] : NULL);
+	XML << magnet::xml::endtag("Pt");
+      }
+  
+    XML << magnet::xml::endtag("ParticleData");
+  }
+
+  void
+  Dynamics::snapshotParticleData(ParticleSnapshot& snapshot, bool applyBC) const
+  {
+    snapshot.particles.clear();
+    snapshot.particles.reserve(Sim->N);
+    for (size_t i = 0; i < Sim->N; ++i)
+      {
+	Particle tmp(Sim->particles[i]);
+	if (applyBC) 
+	  Sim->BCs->applyBC(tmp.getPosition(), tmp.getVelocity());
+      
+	tmp.getVelocity() *= (1.0 / Sim->units.unitVelocity());
+	tmp.getPosition() *= (1.0 / Sim->units.unitLength());
+	snapshot.particles.push_back(tmp);
+      }
+
+    snapshot.orientationData = orientationData;
+    snapshot.properties.clear();
+    Sim->_properties.snapshotParticleData(snapshot.properties);
+  }
+
+  void
+  Dynamics::outputParticleSnapshot(magnet::xml::XmlStream& XML, const ParticleSnapshot& snapshot)
+  {
+    const size_t N = snapshot.particles.size();
+    const bool orientation = !snapshot.orientationData.empty();
 
-	if (hasOrientationData())
-	  XML << magnet::xml::tag("O")
-	      << orientationData[i].angularVelocity
-	      << magnet::xml::endtag("O")
-	      << magnet::xml::tag("U")
-	      << orientationData[i].orientation
-	      << magnet::xml::endtag("U") ;
+    XML << magnet::xml::tag("ParticleData")
+	<< magnet::xml::attr("N") << N;
+  
+    if (orientation)
+      XML << magnet::xml::attr("OrientationData") << "Y";
 
+    for (size_t i = 0; i < N; ++i)
+      {
+	XML << magnet::xml::tag("Pt");
+	for (Property::ParticleValues::const_iterator it = snapshot.properties.begin();
+	     it != snapshot.properties.end(); ++it)
+	  XML << magnet::xml::attr(it->first) << it->second[i];
+	outputParticle(XML, snapshot.particles[i], orientation ? &snapshot.orientationData[i] : NULL);
 	XML << magnet::xml::endtag("Pt");
       }
   
     XML << magnet::xml::endtag("ParticleData");
   }
 
+  void
+  Dynamics::outputParticleBinaryData(magnet::xml::XmlStream& XML, CheckpointWriter& checkpoint, bool applyBC) const
+  {
+    XML << magnet::xml::tag("ParticleData")
+	<< magnet::xml::attr("N") << Sim->N;
+  
+    if (hasOrientationData())
+      XML << magnet::xml::attr("OrientationData") << "Y";
+
+    XML << magnet::xml::endtag("ParticleData");
+
+    std::vector<double> positions, velocities;
+    std::vector<boost::int32_t> states;
+    positions.reserve(NDIM * Sim->N);
+    velocities.reserve(NDIM * Sim->N);
+    states.reserve(Sim->N);
+
+    for (size_t i = 0; i < Sim->N; ++i)
+      {
+	Particle tmp(Sim->particles[i]);
+	if (applyBC) 
+	  Sim->BCs->applyBC(tmp.getPosition(), tmp.getVelocity());
+      
+	for (size_t iDim(0); iDim < NDIM; ++iDim)
+	  {
+	    positions.push_back(tmp.getPosition()[iDim] / Sim->units.unitLength());
+	    velocities.push_back(tmp.getVelocity()[iDim] / Sim->units.unitVelocity());
+	  }
+
+	states.push_back(tmp.testState(Particle::DYNAMIC) ? Particle::DYNAMIC : 0);
+      }
+
+    checkpoint.addBlock("Positions", positions);
+    checkpoint.addBlock("Velocities", velocities);
+    checkpoint.addBlock("States", states);
+
+    Sim->_properties.outputParticleBinaryData(checkpoint);
+
+    if (hasOrientationData())
+      {
+	positions.clear();
+	velocities.clear();
+	for (size_t i = 0; i < Sim->N; ++i)
+	  for (size_t iDim(0); iDim < NDIM; ++iDim)
+	    {
+	      positions.push_back(orientationData[i].orientation[iDim]);
+	      velocities.push_back(orientationData[i].angularVelocity[iDim]);
+	    }
+
+	checkpoint.addBlock("Orientations", positions);
+	checkpoint.addBlock("AngularVelocities", velocities);
+      }
+  }
+
   double 
   Dynamics::getParticleKineticEnergy(const Particle& part) const
   {
@@ -216,8 +465,19 @@ namespace dynamo {
   {
     double sumEnergy(0);
 
-    BOOST_FOREACH(const Particle& part, Sim->particles)
-      sumEnergy += getParticleKineticEnergy(part);
+    if (std::tr1::dynamic_pointer_cast<BCLeesEdwards>(Sim->BCs) || hasOrientationData())
+      {
+	BOOST_FOREACH(const Particle& part, Sim->particles)
+	  sumEnergy += getParticleKineticEnergy(part);
+
+	return sumEnergy;
+      }
+
+    //The same sum as getParticleKineticEnergy, without testing the
+    //BC and orientations for every particle
+    const ParticleContainer::const_iterator end = Sim->particles.end();
+    for (ParticleContainer::const_iterator it = Sim->particles.begin(); it != end; ++it)
+      sumEnergy += 0.5 * (it->getVelocity().nrm2() * Sim->species[*it]->getMass(it->getID()));
 
     return sumEnergy;
   }
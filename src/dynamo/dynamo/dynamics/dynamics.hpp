@@ -64,6 +64,17 @@ namespace dynamo {
       Vector  angularVelocity;
     };
 
+    /*! \brief A copy of the particle data in the units of the
+      configuration file, which can be written out as XML while the
+      simulation carries on (see Simulation::writeXMLfileAsync).
+     */
+    struct ParticleSnapshot
+    {
+      ParticleContainer particles;
+      std::vector<rotData> orientationData;
+      Property::ParticleValues properties;
+    };
+
     Dynamics(dynamo::Simulation* tmp):
       SimBase(tmp, "Dynamics"),
       partPecTime(0.0),
@@ -81,6 +92,14 @@ namespace dynamo {
      */
     virtual void swapSystem(Dynamics& oDynamics) {}
 
+    /*! \brief Called when the particles are renumbered (see
+      Simulation::reorderParticles), to permute any data stored by
+      particle ID.
+     
+      \param order The new particle ID i is the old particle ID order[i].
+     */
+    virtual void reorderParticles(const std::vector<size_t>& order);
+
     /*! \brief Parses the XML data to see if it can load XML particle
       data or if it needs to decode the binary data. Then loads the
       particle data.
@@ -96,6 +115,19 @@ namespace dynamo {
      */
     void outputParticleXMLData(magnet::xml::XmlStream& XML, bool applyBC) const;
 
+    /*! \brief Copies the particle data for \ref outputParticleSnapshot.
+      \param applyBC Wether to apply the boundary conditions to the copied particle positions.
+     */
+    void snapshotParticleData(ParticleSnapshot& snapshot, bool applyBC) const;
+
+    /*! \brief Writes the XML particle data from a copy taken by \ref
+      snapshotParticleData.
+
+      This does not touch the Simulation, so it may be called from
+      another thread.
+     */
+    static void outputParticleSnapshot(magnet::xml::XmlStream& XML, const ParticleSnapshot& snapshot);
+
     /*! \brief Returns the degrees of freedom per particle.
      */
     inline size_t getParticleDOF() const { return NDIM + 2 * hasOrientationData(); }
@@ -116,6 +148,17 @@ namespace dynamo {
      */
     virtual void rescaleSystemKineticEnergy(const double&);
 
+    /*! \brief Tests if multiplying every velocity by a factor only
+        divides the time of every event by the same factor.
+
+      This is the case if the particles move along trajectories which
+      do not depend on their speed (e.g., straight lines), as these are
+      then just traversed faster. The Scheduler may then rescale the
+      event times instead of recalculating them (see
+      Scheduler::velocitiesRescaled).
+     */
+    virtual bool eventTimesScaleWithVelocity() const { return false; }
+
     /*! \brief Performs an elastic multibody collision between to ranges of particles.
       
       Also works for bounce (it will collide receeding structures).
@@ -590,11 +633,7 @@ namespace dynamo {
     {
       //May as well take this opportunity to reset the streaming
       //Note: the Replexing coordinator RELIES on this behaviour!
-      BOOST_FOREACH(Particle& part, Sim->particles)
-	{
-	  streamParticle(part, part.getPecTime() + partPecTime);
-	  part.getPecTime() = 0;
-	}
+      streamAllParticles(partPecTime);
 
       partPecTime = 0;
       streamCount = 0;
@@ -744,7 +783,38 @@ namespace dynamo {
     /*! \brief Moves the particles data along in time. */
     virtual void streamParticle(Particle& part, const double& dt) const = 0;
 
+    /*! \brief Moves every particle along in time by its delay plus
+      dt, and resets the delays to zero.
+
+      The default implementation calls \ref streamParticle for each
+      particle. Dynamics with a simple streaming law can override this
+      with a loop free of virtual calls.
+     */
+    virtual void streamAllParticles(const double& dt) const
+    {
+      BOOST_FOREACH(Particle& part, Sim->particles)
+	{
+	  streamParticle(part, part.getPecTime() + dt);
+	  part.getPecTime() = 0;
+	}
+    }
+
     mutable std::vector<rotData> orientationData;
+
+    /*! \brief Loads the particle data from the arrays of a binary
+        checkpoint (see \ref loadParticleXMLData).
+     */
+    void loadParticleBinaryData(const magnet::xml::Node& XML, const CheckpointReader& checkpoint);
+
+    /*! \brief Takes the particle data which was streamed out of the
+        XML file (see \ref loadParticleXMLData).
+     */
+    void loadParticleStreamData(const magnet::xml::Node& XML, ParticleStreamReader& stream);
+
+    /*! \brief Writes the particle data as arrays in a binary
+        checkpoint (see \ref outputParticleXMLData).
+     */
+    void outputParticleBinaryData(magnet::xml::XmlStream& XML, CheckpointWriter& checkpoint, bool applyBC) const;
   };
 }
 
@@ -466,6 +466,20 @@ namespace dynamo {
       Sim->globals.push_back(shared_ptr<Global>(new GParabolaSentinel(Sim, "NBListParabolaSentinel")));
   }
 
+  void
+  DynGravity::reorderParticles(const std::vector<size_t>& order)
+  {
+    DynNewtonian::reorderParticles(order);
+
+    if (_tcList.empty()) return;
+
+    std::vector<long double> newList;
+    newList.reserve(order.size());
+    for (std::vector<size_t>::const_iterator it = order.begin(); it != order.end(); ++it)
+      newList.push_back(_tcList[*it]);
+    _tcList.swap(newList);
+  }
+
   PairEventData 
   DynGravity::SmoothSpheresColl(const IntEvent& event, const double& ne,
 				       const double& d2, const EEventType& eType) const
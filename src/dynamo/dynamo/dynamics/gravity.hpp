@@ -29,7 +29,11 @@ namespace dynamo {
     DynGravity(dynamo::Simulation*, const magnet::xml::Node&);
     DynGravity(dynamo::Simulation* tmp, Vector gravity, double eV = 0, double tc = -HUGE_VAL);
     void initialise();
+    virtual void reorderParticles(const std::vector<size_t>& order);
     const Vector& getGravityVector() const { return g; }
+    //! The parabolic trajectories change shape with the speed
+    virtual bool eventTimesScaleWithVelocity() const { return false; }
+
     virtual double SphereSphereInRoot(const Particle& p1, const Particle& p2, double d) const;
     virtual double SphereSphereInRoot(const IDRange& p1, const IDRange& p2, double d) const;
     virtual double SphereSphereOutRoot(const Particle& p1, const Particle& p2, double d) const;
@@ -54,5 +58,9 @@ namespace dynamo {
     double _tc;
 
     virtual void outputXML(magnet::xml::XmlStream&) const;
+
+    //! \brief Gravity has its own streamParticle, so the generic bulk stream is used.
+    virtual void streamAllParticles(const double& dt) const
+    { Dynamics::streamAllParticles(dt); }
   };
 }
@@ -154,6 +154,28 @@ namespace dynamo {
 	* Vector(orientationData[particle.getID()].orientation); 
   }
 
+  void
+  DynNewtonian::streamAllParticles(const double& dt) const
+  {
+    //The orientations are streamed first as they need the
+    //particles delay, which is reset in the second loop. This keeps
+    //the position update free of branches and virtual calls.
+    if (hasOrientationData())
+      {
+	BOOST_FOREACH(const Particle& part, Sim->particles)
+	  orientationData[part.getID()].orientation 
+	    = Rodrigues(orientationData[part.getID()].angularVelocity * (part.getPecTime() + dt))
+	    * Vector(orientationData[part.getID()].orientation);
+      }
+
+    const ParticleContainer::iterator end = Sim->particles.end();
+    for (ParticleContainer::iterator it = Sim->particles.begin(); it != end; ++it)
+      {
+	it->getPosition() += it->getVelocity() * (it->getPecTime() + dt);
+	it->getPecTime() = 0;
+      }
+  }
+
   double 
   DynNewtonian::getPlaneEvent(const Particle& part, const Vector& wallLoc, const Vector& wallNorm, double diameter) const
   {
@@ -34,6 +34,8 @@ namespace dynamo {
   public:
     DynNewtonian(dynamo::Simulation*);
 
+    virtual bool eventTimesScaleWithVelocity() const { return true; }
+
     virtual double SphereSphereInRoot(const Particle& p1, const Particle& p2, double d) const;
     virtual double SphereSphereInRoot(const IDRange& p1, const IDRange& p2, double d) const;
     virtual double SphereSphereOutRoot(const Particle& p1, const Particle& p2, double d) const;
@@ -71,6 +73,8 @@ namespace dynamo {
   protected:
     virtual void outputXML(magnet::xml::XmlStream&) const;
 
+    virtual void streamAllParticles(const double&) const;
+
     mutable long double lastAbsoluteClock;
     mutable unsigned int lastCollParticle1;
     mutable unsigned int lastCollParticle2;
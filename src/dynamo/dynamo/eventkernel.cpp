@@ -0,0 +1,67 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dynamo/eventkernel.hpp>
+#include <dynamo/ranges/IDPairRangeAll.hpp>
+#include <typeinfo>
+
+namespace dynamo {
+  namespace {
+    //! Tests if a Property has the same value for every particle.
+    inline bool isFixed(const shared_ptr<Property>& property)
+    { return std::tr1::dynamic_pointer_cast<NumericProperty>(property); }
+  }
+
+  shared_ptr<EventKernel>
+  EventKernel::getKernel(const Simulation* Sim)
+  {
+    //The exact types are tested, as derived classes may change the
+    //behaviour of any of the virtual functions
+    if (!Sim->dynamics || (typeid(*Sim->dynamics) != typeid(DynNewtonian)))
+      return shared_ptr<EventKernel>();
+
+    if (!Sim->BCs || (typeid(*Sim->BCs) != typeid(BCPeriodic)))
+      return shared_ptr<EventKernel>();
+    
+    //The first Interaction must handle every pair of particles, so
+    //Simulation::getInteraction always returns it
+    if (Sim->interactions.empty())
+      return shared_ptr<EventKernel>();
+
+    const Interaction* interaction = Sim->interactions.front().get();
+    if (!std::tr1::dynamic_pointer_cast<IDPairRangeAll>(interaction->getRange()))
+      return shared_ptr<EventKernel>();
+
+    const BCPeriodic* BC = static_cast<const BCPeriodic*>(Sim->BCs.get());
+
+    if (typeid(*interaction) == typeid(IHardSphere))
+      {
+	const IHardSphere* hs = static_cast<const IHardSphere*>(interaction);
+	if (isFixed(hs->getDiameter()))
+	  return shared_ptr<EventKernel>(new HardSphereKernel(Sim, BC, hs));
+      }
+
+    if (typeid(*interaction) == typeid(ISquareWell))
+      {
+	const ISquareWell* sw = static_cast<const ISquareWell*>(interaction);
+	if (isFixed(sw->getDiameter()) && isFixed(sw->getLambda()))
+	  return shared_ptr<EventKernel>(new SquareWellKernel(Sim, BC, sw));
+      }
+
+    return shared_ptr<EventKernel>();
+  }
+}
@@ -0,0 +1,175 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <dynamo/interactions/intEvent.hpp>
+#include <dynamo/interactions/hardsphere.hpp>
+#include <dynamo/interactions/squarewell.hpp>
+#include <dynamo/dynamics/newtonian.hpp>
+#include <dynamo/BC/PBC.hpp>
+#include <magnet/intersection/ray_sphere.hpp>
+
+namespace dynamo {
+  /*! \brief A specialised predictor of the Interaction events of a
+      Simulation.
+
+    The generic path for predicting a pair event passes through
+    several virtual calls (Simulation::getInteraction,
+    Interaction::getEvent, Dynamics::SphereSphereInRoot and
+    BoundaryCondition::applyBC) and looks up the properties of both
+    particles through the Property interface. For the most common
+    simulations (Newtonian dynamics in periodic boundary conditions
+    with a single hard sphere or square well Interaction with fixed
+    parameters) the types of all of these are known once the
+    Simulation is initialised, so the whole prediction can be compiled
+    into a single function.
+
+    \ref getKernel selects a kernel matching the Simulation, if one
+    exists. The kernels perform exactly the same arithmetic as the
+    generic path, so the events predicted are identical. Only the
+    prediction is specialised, the events are still executed by the
+    Interaction.
+   */
+  class EventKernel
+  {
+  public:
+    virtual ~EventKernel() {}
+
+    /*! \brief Predicts the next event between two particles.
+
+      The particles must be up to date, as for Interaction::getEvent.
+     */
+    virtual IntEvent getEvent(const Particle& p1, const Particle& p2) const = 0;
+
+    /*! \brief Tests if the kernel still matches the Simulation.
+
+      The Dynamics and BoundaryCondition of a Simulation may be
+      replaced after it is initialised (e.g., by the compression
+      plugin), in which case the generic path must be used.
+     */
+    inline bool isValid() const
+    { return (Sim->dynamics.get() == _dynamics) && (Sim->BCs.get() == _BC); }
+
+    /*! \brief Returns a kernel for the Simulation, or an empty
+        pointer if none of the kernels match it.
+      
+      This must be called after the Interactions have been
+      initialised.
+     */
+    static shared_ptr<EventKernel> getKernel(const Simulation* Sim);
+
+  protected:
+    EventKernel(const Simulation* sim, const BCPeriodic* BC):
+      Sim(sim), _dynamics(Sim->dynamics.get()), _BC(BC)
+    {}
+
+    /*! \brief Calculates the separation and relative velocity of the
+        particles, as DynNewtonian::SphereSphereInRoot does.
+     */
+    inline void getRelativeMotion(const Particle& p1, const Particle& p2, Vector& r12, Vector& v12) const
+    {
+      r12 = p1.getPosition() - p2.getPosition();
+      v12 = p1.getVelocity() - p2.getVelocity();
+      _BC->BCPeriodic::applyBC(r12, v12);
+    }
+
+    const Simulation* Sim;
+    const Dynamics* _dynamics;
+    const BCPeriodic* _BC;
+  };
+
+  /*! \brief The EventKernel for a single IHardSphere Interaction with
+      a fixed diameter and elasticity.
+   */
+  class HardSphereKernel: public EventKernel
+  {
+  public:
+    HardSphereKernel(const Simulation* sim, const BCPeriodic* BC, const IHardSphere* interaction):
+      EventKernel(sim, BC), 
+      _interaction(interaction), 
+      _diameter(interaction->getDiameter()->getProperty(0))
+    {}
+
+    virtual IntEvent getEvent(const Particle& p1, const Particle& p2) const
+    {
+      const double d = (_diameter + _diameter) * 0.5;
+
+      Vector r12, v12;
+      getRelativeMotion(p1, p2, r12, v12);
+      const double dt = magnet::intersection::ray_sphere_bfc(r12, v12, d);
+
+      if (dt != HUGE_VAL)
+	return IntEvent(p1, p2, dt, CORE, *_interaction);
+  
+      return IntEvent(p1, p2, HUGE_VAL, NONE, *_interaction);
+    }
+
+  private:
+    const IHardSphere* _interaction;
+    //! A reference, as the property may be rescaled during the run
+    const double& _diameter;
+  };
+
+  /*! \brief The EventKernel for a single ISquareWell Interaction
+      with a fixed diameter, well width, well depth and elasticity.
+   */
+  class SquareWellKernel: public EventKernel
+  {
+  public:
+    SquareWellKernel(const Simulation* sim, const BCPeriodic* BC, const ISquareWell* interaction):
+      EventKernel(sim, BC), 
+      _interaction(interaction), 
+      _diameter(interaction->getDiameter()->getProperty(0)),
+      _lambda(interaction->getLambda()->getProperty(0))
+    {}
+
+    virtual IntEvent getEvent(const Particle& p1, const Particle& p2) const
+    {
+      const double d = (_diameter + _diameter) * 0.5;
+      const double l = (_lambda + _lambda) * 0.5;
+
+      Vector r12, v12;
+      getRelativeMotion(p1, p2, r12, v12);
+
+      IntEvent retval(p1, p2, HUGE_VAL, NONE, *_interaction);
+
+      if (_interaction->ISingleCapture::isCaptured(p1.getID(), p2.getID()))
+	{
+	  double dt = magnet::intersection::ray_sphere_bfc(r12, v12, d);
+	  if (dt != HUGE_VAL)
+	    retval = IntEvent(p1, p2, dt, CORE, *_interaction);
+	  
+	  dt = magnet::intersection::ray_inv_sphere_bfc(r12, v12, l * d);
+	  if (retval.getdt() > dt)
+	    retval = IntEvent(p1, p2, dt, STEP_OUT, *_interaction);
+	}
+      else
+	{
+	  const double dt = magnet::intersection::ray_sphere_bfc(r12, v12, l * d);
+	  if (dt != HUGE_VAL)
+	    retval = IntEvent(p1, p2, dt, STEP_IN, *_interaction);
+	}
+
+      return retval;
+    }
+
+  private:
+    const ISquareWell* _interaction;
+    const double& _diameter;
+    const double& _lambda;
+  };
+}
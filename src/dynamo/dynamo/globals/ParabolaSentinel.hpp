@@ -31,6 +31,8 @@ namespace dynamo {
 
     virtual void runEvent(Particle&, const double) const;
 
+    virtual bool eventTimesScaleWithVelocity() const { return false; }
+
     virtual void initialise(size_t);
 
     virtual void operator<<(const magnet::xml::Node&) {}
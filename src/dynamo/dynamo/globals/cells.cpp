@@ -23,9 +23,21 @@
 #include <dynamo/ranges/IDRangeAll.hpp>
 #include <dynamo/schedulers/scheduler.hpp>
 #include <dynamo/BC/LEBC.hpp>
+#include <dynamo/dynamics/compression.hpp>
 #include <dynamo/ranges/IDRangeList.hpp>
+#include <dynamo/ranges/IDPairRange.hpp>
+#include <dynamo/interactions/captures.hpp>
+#include <dynamo/locals/local.hpp>
+#include <dynamo/systems/andersenThermostat.hpp>
+#include <dynamo/systems/sysTicker.hpp>
+#include <dynamo/systems/snapshot.hpp>
+#include <dynamo/systems/tHalt.hpp>
+#include <dynamo/systems/rescale.hpp>
+#include <dynamo/systems/nblistCompressionFix.hpp>
+#include <dynamo/outputplugins/outputplugin.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <magnet/xmlreader.hpp>
+#include <boost/bind.hpp>
 #include <cstdio>
 #include <set>
 #include <algorithm>
@@ -40,7 +52,10 @@ namespace dynamo {
     cellDimension(1,1,1),
     _oversizeCells(1.0),
     NCells(0),
-    overlink(overlink)
+    overlink(overlink),
+    _sortInterval(0),
+    _cellEventsSinceSort(0),
+    _cellCapacity(0)
   {
     globName = name;
     dout << "Cells Loaded" << std::endl;
@@ -51,7 +66,10 @@ namespace dynamo {
     cellDimension(1,1,1),
     _oversizeCells(1.0),
     NCells(0),
-    overlink(1)
+    overlink(1),
+    _sortInterval(0),
+    _cellEventsSinceSort(0),
+    _cellCapacity(0)
   {
     operator<<(XML);
 
@@ -73,6 +91,9 @@ namespace dynamo {
     
     if (_oversizeCells < 1.0)
       M_throw() << "You must specify an Oversize greater than 1.0, otherwise your cells are too small!";
+
+    if (XML.hasAttribute("SortInterval"))
+      _sortInterval = XML.getAttribute("SortInterval").as<double>();
     
     globName = XML.getAttribute("Name");
     
@@ -128,9 +149,7 @@ namespace dynamo {
     //expect the particle to be up to date.
     Sim->dynamics->updateParticle(part);
 
-    std::tr1::unordered_map<size_t, size_t>::iterator it = partCellData.find(part.getID());
-
-    const size_t oldCell(it->second);
+    const size_t oldCell(partCellData[part.getID()]);
 
     size_t endCell;
 
@@ -167,7 +186,7 @@ namespace dynamo {
       endCell = dendCell.getMortonNum();
     }
 
-    removeFromCellwIt(part.getID(), it);
+    removeFromCell(part.getID());
     addToCell(part.getID(), endCell);
 
     //Get rid of the virtual event we're running, an updated event is
@@ -197,9 +216,10 @@ namespace dynamo {
 	  {
 	    newNBCell[dim1] %= cellCount[dim1];
 	    
-	    BOOST_FOREACH(const size_t& next, list[newNBCell.getMortonNum()])
+	    const size_t cellID = newNBCell.getMortonNum();
+	    for (const size_t* next = cellBegin(cellID); next != cellEnd(cellID); ++next)
 	      BOOST_FOREACH(const nbHoodSlot& nbs, sigNewNeighbourNotify)
-	        nbs.second(part, next);
+	        nbs.second(part, *next);
 	  
 	    ++newNBCell[dim1];
 	  }
@@ -207,6 +227,8 @@ namespace dynamo {
 	newNBCell[dim1] = saved_coord; 
 	++newNBCell[dim2];
       }
+
+    notifyNewLocals(part, oldCell, endCell);
   
     //Push the next virtual event, this is the reason the scheduler
     //doesn't need a second callback
@@ -233,6 +255,114 @@ namespace dynamo {
 	     << "," << endCellv[2].getRealValue() << ">"
 	     << std::endl;
       }
+
+    if ((_sortInterval > 0) && (++_cellEventsSinceSort > _sortInterval * Sim->N))
+      sortParticles();
+  }
+
+  namespace {
+    //! Tests if a range of particles is either empty or all particles.
+    bool uniformRange(const IDRange* range, const size_t N)
+    { return !range || (range->size() == 0) || (range->size() == N); }
+  }
+
+  void
+  GCells::checkSortable() const
+  {
+    //Renumbering the particles is only valid if every particle is
+    //treated identically, and all data stored by particle ID is
+    //either rebuilt or permuted (see Simulation::reorderParticles)
+    if (!std::tr1::dynamic_pointer_cast<IDRangeAll>(range)
+	|| (Sim->species.size() != 1) || !Sim->topology.empty())
+      M_throw() << "The SortInterval option of the " << globName << " neighbour list requires a "
+	"single species, no topology and a neighbour list containing all particles";
+
+    BOOST_FOREACH(const shared_ptr<Interaction>& interaction, Sim->interactions)
+      {
+	std::vector<const IDRange*> ranges;
+	bool uniform = interaction->getRange()->getIDRanges(ranges);
+	BOOST_FOREACH(const IDRange* idrange, ranges)
+	  uniform &= uniformRange(idrange, Sim->N);
+
+	//Captured pairs are also stored by particle ID
+	if (!uniform || std::tr1::dynamic_pointer_cast<ICapture>(interaction))
+	  M_throw() << "The SortInterval option of the " << globName << " neighbour list cannot "
+	    "be used as the interaction " << interaction->getName() << " depends on the particle IDs";
+      }
+
+    BOOST_FOREACH(const shared_ptr<Local>& local, Sim->locals)
+      if (!uniformRange(local->getRange().get(), Sim->N))
+	M_throw() << "The SortInterval option of the " << globName << " neighbour list cannot "
+	  "be used as the local " << local->getName() << " depends on the particle IDs";
+
+    //Only this neighbour list is renumbered with the particles
+    BOOST_FOREACH(const shared_ptr<Global>& global, Sim->globals)
+      if (!uniformRange(global->getRange().get(), Sim->N)
+	  || ((global.get() != this) && std::tr1::dynamic_pointer_cast<GNeighbourList>(global)))
+	M_throw() << "The SortInterval option of the " << globName << " neighbour list cannot "
+	  "be used as the global " << global->getName() << " depends on the particle IDs";
+
+    //Only the System events known not to store particle IDs are allowed
+    BOOST_FOREACH(const shared_ptr<System>& system, Sim->systems)
+      {
+	const shared_ptr<SysAndersen> thermostat
+	  = std::tr1::dynamic_pointer_cast<SysAndersen>(system);
+
+	if ((thermostat && uniformRange(thermostat->getRange().get(), Sim->N))
+	    || std::tr1::dynamic_pointer_cast<SysTicker>(system)
+	    || std::tr1::dynamic_pointer_cast<SSnapshot>(system)
+	    || std::tr1::dynamic_pointer_cast<SystHalt>(system)
+	    || std::tr1::dynamic_pointer_cast<SysRescale>(system)
+	    || std::tr1::dynamic_pointer_cast<SysNBListCompressionFix>(system))
+	  continue;
+
+	M_throw() << "The SortInterval option of the " << globName << " neighbour list cannot "
+	  "be used with the System event " << system->getName();
+      }
+
+    BOOST_FOREACH(const shared_ptr<OutputPlugin>& plugin, Sim->outputPlugins)
+      if (!plugin->canReorderParticles())
+	M_throw() << "The SortInterval option of the " << globName << " neighbour list cannot "
+	  "be used with the " << plugin->getPluginName() << " output plugin, as it stores data by particle ID";
+  }
+
+  void
+  GCells::sortParticles() const
+  {
+    _cellEventsSinceSort = 0;
+
+    //The cells are stored in Morton order, so reading out the cell
+    //storage gives the new particle order. Each particle keeps its
+    //cell and slot, only the IDs stored in the cells change.
+    std::vector<size_t> order;
+    order.reserve(Sim->N);
+    for (size_t index(0); index < _cellOccupancy.size(); ++index)
+      for (size_t slot(0); slot < _cellOccupancy[index]; ++slot)
+	{
+	  size_t& ID = _cellParticles[index * _cellCapacity + slot];
+	  order.push_back(ID);
+	  ID = order.size() - 1;
+	}
+
+    std::vector<size_t> oldCellData(partCellData);
+    for (size_t ID(0); ID < order.size(); ++ID)
+      partCellData[ID] = oldCellData[order[ID]];
+
+    std::vector<size_t> oldSlot(_partSlot);
+    for (size_t ID(0); ID < order.size(); ++ID)
+      _partSlot[ID] = oldSlot[order[ID]];
+
+    Sim->reorderParticles(order);
+
+    //Everything holding particle IDs must now be rebuilt. The
+    //scheduler stores particle IDs even if it is not using this
+    //neighbour list.
+    BOOST_FOREACH(const initSlot& nbs, sigReInitNotify)
+      nbs.second();
+
+    Sim->ptrScheduler->rebuildList();
+
+    dout << "Renumbered the particles in Morton order on collision " << Sim->eventCount << std::endl;
   }
 
   void 
@@ -246,9 +376,12 @@ namespace dynamo {
     _particleRemoved = Sim->particle_removed_signal()
       .connect(boost::bind(CallBackType(&GCells::removeFromCell), this, _1));
 
+    if (_sortInterval > 0)
+      checkSortable();
+
     reinitialise();
 
-    dout << "Neighbourlist contains " << partCellData.size() 
+    dout << "Neighbourlist contains " << range->size()
 	 << " particle entries"
 	 << std::endl;
   }
@@ -272,6 +405,100 @@ namespace dynamo {
       Sim->ptrScheduler->initialise();
   }
 
+  double
+  GCells::regrid(double newRange)
+  {
+    if (!_initialised)
+      return GNeighbourList::regrid(newRange);
+
+    _maxInteractionRange = newRange;
+
+    dout << "Regridding on collision " << Sim->eventCount << std::endl;
+
+    //The events of the pairs which were neighbours in the old cells
+    //are still valid, so the old cell of each particle is kept to
+    //find the new pairs
+    const std::vector<size_t> oldCellData(partCellData);
+    const size_t oldCellCount[3] = {cellCount[0], cellCount[1], cellCount[2]};
+
+    addCells((_maxInteractionRange
+	      * (1.0 + 10 * std::numeric_limits<double>::epsilon()))
+	     * _oversizeCells / overlink);
+
+    BOOST_FOREACH(const initSlot& nbs, sigReInitNotify)
+      nbs.second();
+
+    double fraction(0);
+    if (isUsedInScheduler)
+      {
+	NewNeighbourNotifier notifier(*this, oldCellData, oldCellCount);
+	BOOST_FOREACH(const size_t& id, *range)
+	  {
+	    const Particle& part = Sim->particles[id];
+	    getParticleNeighbourhood(part, nbHoodFunc(&notifier, &NewNeighbourNotifier::notify));
+
+	    //Every Local of the new cell is signalled, as there are
+	    //few and a repeated local event is harmless
+	    for (const size_t* it = cellLocalsBegin(partCellData[id]);
+		 it != cellLocalsEnd(partCellData[id]); ++it)
+	      BOOST_FOREACH(const nbHoodSlot& nbs, sigNewLocalNotify)
+		nbs.second(part, *it);
+	  }
+
+	if (notifier._pairs)
+	  fraction = double(notifier._newPairs) / notifier._pairs;
+
+	dout << "New neighbour pairs " << notifier._newPairs << " of " << notifier._pairs << std::endl;
+      }
+
+    //The cell events of the old cells are no longer valid
+    Sim->ptrScheduler->rebuildGlobalEvents();
+
+    return fraction;
+  }
+
+  GCells::NewNeighbourNotifier::NewNeighbourNotifier(const GCells& cells,
+						     const std::vector<size_t>& oldCellData,
+						     const size_t* oldCellCount):
+    _cells(cells),
+    _oldCellData(oldCellData),
+    _oldCellCount(oldCellCount),
+    _pairs(0),
+    _newPairs(0)
+  {}
+
+  void
+  GCells::NewNeighbourNotifier::notify(const Particle& part, const size_t& ID2) const
+  {
+    //Each pair is only signalled to the particle with the lower ID
+    if (ID2 <= part.getID()) return;
+
+    ++_pairs;
+
+    const size_t ID1 = part.getID();
+    bool isNew = (ID2 >= _oldCellData.size())
+      || (_oldCellData[ID1] == std::numeric_limits<size_t>::max())
+      || (_oldCellData[ID2] == std::numeric_limits<size_t>::max());
+
+    if (!isNew)
+      {
+	const magnet::math::MortonNumber<3> oldCell1(_oldCellData[ID1]), oldCell2(_oldCellData[ID2]);
+	for (size_t iDim(0); iDim < NDIM; ++iDim)
+	  {
+	    const size_t separation = (oldCell2[iDim].getRealValue() + _oldCellCount[iDim]
+				       - oldCell1[iDim].getRealValue()) % _oldCellCount[iDim];
+	    isNew |= (separation > _cells.overlink)
+	      && (separation < _oldCellCount[iDim] - _cells.overlink);
+	  }
+      }
+
+    if (!isNew) return;
+
+    ++_newPairs;
+    BOOST_FOREACH(const nbHoodSlot& nbs, _cells.sigNewNeighbourNotify)
+      nbs.second(part, ID2);
+  }
+
   void
   GCells::outputXML(magnet::xml::XmlStream& XML) const
   { 
@@ -283,6 +510,7 @@ namespace dynamo {
     
     if (overlink > 1)   XML << magnet::xml::attr("OverLink") << overlink;
     if (_oversizeCells != 1.0) XML << magnet::xml::attr("Oversize") << _oversizeCells;
+    if (_sortInterval > 0) XML << magnet::xml::attr("SortInterval") << _sortInterval;
     
     XML << *range
 	<< magnet::xml::endtag("Global");
@@ -291,8 +519,6 @@ namespace dynamo {
   void
   GCells::addCells(double maxdiam)
   {
-    list.clear();
-    partCellData.clear();
     NCells = 1;
 
     for (size_t iDim = 0; iDim < NDIM; iDim++)
@@ -319,7 +545,27 @@ namespace dynamo {
     magnet::math::MortonNumber<3> coords(cellCount[0], cellCount[1], cellCount[2]);
     size_t sizeReq = coords.getMortonNum();
 
-    list.resize(sizeReq); //Empty Cells created!
+    //Number the cells densely, in Morton order
+    _cellIndex.assign(sizeReq, 0);
+    {
+      size_t index(0);
+      for (size_t cellID(0); cellID < sizeReq; ++cellID)
+	{
+	  magnet::math::MortonNumber<3> cell(cellID);
+	  if ((cell[0].getRealValue() < cellCount[0])
+	      && (cell[1].getRealValue() < cellCount[1])
+	      && (cell[2].getRealValue() < cellCount[2]))
+	    _cellIndex[cellID] = index++;
+	}
+    }
+
+    //Empty Cells created! Start with room for a few times the
+    //average cell occupancy.
+    _cellCapacity = std::max(size_t(4), 2 * (range->size() / NCells + 1));
+    _cellOccupancy.assign(NCells, 0);
+    _cellParticles.assign(NCells * _cellCapacity, 0);
+    partCellData.assign(Sim->N, std::numeric_limits<size_t>::max());
+    _partSlot.assign(Sim->N, 0);
 
     dout << "Cells <x,y,z> " << cellCount[0] << ","
 	 << cellCount[1] << "," << cellCount[2]
@@ -343,6 +589,8 @@ namespace dynamo {
 	 << "\nSupported length           " << getMaxSupportedInteractionLength() / Sim->units.unitLength()
 	 << "\nVector Size <N>  " << sizeReq << std::endl;
   
+    addLocalsToCells();
+
     //Add the particles section
     //Required so particles find the right owning cell
     Sim->dynamics->updateAllParticles();
@@ -355,8 +603,7 @@ namespace dynamo {
 	addToCell(id);
 	if (verbose)
 	  {
-	    std::tr1::unordered_map<size_t, size_t>::iterator it = partCellData.find(id);
-	    magnet::math::MortonNumber<3> currentCell(it->second);
+	    magnet::math::MortonNumber<3> currentCell(partCellData[id]);
 	    
 	    magnet::math::MortonNumber<3> estCell(getCellID(Sim->particles[ID].getPosition()));
 	  
@@ -373,7 +620,7 @@ namespace dynamo {
 		 << "," << currentCell[1].getRealValue()
 		 << "," << currentCell[2].getRealValue()
 		 << ">"
-		 << "\nParticle is at this distance " << Vector(p.getPosition() - calcPosition(it->second, p)).toString() << " from the cell origin"
+		 << "\nParticle is at this distance " << Vector(p.getPosition() - calcPosition(partCellData[id], p)).toString() << " from the cell origin"
 		 << "\nParticle position  " << p.getPosition().toString()	
 		 << "\nParticle wrapped distance  " << wrapped_pos.toString()	
 		 << "\nParticle relative position  " << origin_pos.toString()
@@ -385,10 +632,102 @@ namespace dynamo {
 	  }
       }
 
-    dout << "Cell loading " << float(partCellData.size()) / NCells 
+    dout << "Cell loading " << float(range->size()) / NCells 
 	 << std::endl;
   }
 
+  void
+  GCells::addLocalsToCells()
+  {
+    std::vector<std::vector<size_t> > cellLocals(NCells);
+
+    //Sliding boundaries shear the images of the bounds, and
+    //compression grows the contact distances past the bounds between
+    //regrids, so there every Local is placed in every cell
+    const bool everyCell(std::tr1::dynamic_pointer_cast<BCLeesEdwards>(Sim->BCs)
+		       || std::tr1::dynamic_pointer_cast<DynCompression>(Sim->dynamics));
+
+    for (size_t localID(0); localID < Sim->locals.size(); ++localID)
+      {
+	const std::pair<Vector, Vector> bounds = Sim->locals[localID]->getBounds();
+
+	//The cell coordinates which overlap the bounds in each dimension
+	std::vector<size_t> coords[3];
+	for (size_t iDim(0); iDim < NDIM; ++iDim)
+	  {
+	    if (bounds.first[iDim] > bounds.second[iDim]) continue;
+
+	    long start(0), end(cellCount[iDim] - 1);
+	    if (!everyCell && (bounds.second[iDim] - bounds.first[iDim] < Sim->primaryCellSize[iDim]))
+	      {
+		//Cell i spans [origin + i * cellLatticeWidth, origin + i *
+		//cellLatticeWidth + cellDimension]
+		const double origin = cellOffset[iDim] - 0.5 * Sim->primaryCellSize[iDim];
+		const long first = std::ceil((bounds.first[iDim] - cellDimension[iDim] - origin)
+					     / cellLatticeWidth[iDim]);
+		const long last = std::floor((bounds.second[iDim] - origin) / cellLatticeWidth[iDim]);
+
+		if (last - first + 1 < long(cellCount[iDim]))
+		  {
+		    start = first;
+		    end = last;
+		  }
+	      }
+
+	    //Any periodic image of the bounds is in range
+	    for (long i(start); i <= end; ++i)
+	      coords[iDim].push_back(((i % long(cellCount[iDim])) + cellCount[iDim]) % cellCount[iDim]);
+	  }
+
+	BOOST_FOREACH(const size_t& x, coords[0])
+	  BOOST_FOREACH(const size_t& y, coords[1])
+	  BOOST_FOREACH(const size_t& z, coords[2])
+	  cellLocals[_cellIndex[magnet::math::MortonNumber<3>(x, y, z).getMortonNum()]]
+	  .push_back(localID);
+      }
+
+    _cellLocalStart.assign(NCells + 1, 0);
+    _cellLocals.clear();
+    for (size_t index(0); index < NCells; ++index)
+      {
+	_cellLocalStart[index] = _cellLocals.size();
+	_cellLocals.insert(_cellLocals.end(), cellLocals[index].begin(), cellLocals[index].end());
+      }
+    _cellLocalStart[NCells] = _cellLocals.size();
+    _cellLocals.push_back(0);
+
+    if (!Sim->locals.empty())
+      dout << "Local entries per cell " << float(_cellLocals.size() - 1) / NCells << std::endl;
+  }
+
+  void
+  GCells::notifyNewLocals(const Particle& part, size_t oldCell, size_t newCell) const
+  {
+    const size_t* oldBegin = cellLocalsBegin(oldCell);
+    const size_t* oldEnd = cellLocalsEnd(oldCell);
+
+    for (const size_t* it = cellLocalsBegin(newCell); it != cellLocalsEnd(newCell); ++it)
+      if (std::find(oldBegin, oldEnd, *it) == oldEnd)
+	{
+	  BOOST_FOREACH(const nbHoodSlot& nbs, sigNewLocalNotify)
+	    nbs.second(part, *it);
+	}
+  }
+
+  void
+  GCells::growCells() const
+  {
+    const size_t newCapacity = 2 * _cellCapacity;
+    std::vector<size_t> newParticles(_cellOccupancy.size() * newCapacity);
+    for (size_t index(0); index < _cellOccupancy.size(); ++index)
+      std::copy(_cellParticles.begin() + index * _cellCapacity,
+		_cellParticles.begin() + index * _cellCapacity + _cellOccupancy[index],
+		newParticles.begin() + index * newCapacity);
+
+    _cellParticles.swap(newParticles);
+    _cellCapacity = newCapacity;
+  }
+
   magnet::math::MortonNumber<3>
   GCells::getCellID(Vector pos) const
   {
@@ -418,32 +757,10 @@ namespace dynamo {
 	  << std::endl;
       }
 
-    magnet::math::MortonNumber<3> zero_coords;
-    for (size_t iDim(0); iDim < NDIM; ++iDim)
-      zero_coords[iDim] = (particle_cell_coords[iDim].getRealValue() + cellCount[iDim] - overlink)
-	% cellCount[iDim];
-    
     IDRangeList retval;
     //This initial reserve greatly speeds up the later inserts
     retval.getContainer().reserve(32);
-
-    magnet::math::MortonNumber<3> coords(zero_coords);
-    for (size_t x(0); x < 2 * overlink + 1; ++x)
-      {
-	coords[0] = (zero_coords[0].getRealValue() + x) % cellCount[0];
-	for (size_t y(0); y < 2 * overlink + 1; ++y)
-	  {
-	    coords[1] = (zero_coords[1].getRealValue() + y) % cellCount[1];
-	    for (size_t z(0); z < 2 * overlink + 1; ++z)
-	      {
-		coords[2] = (zero_coords[2].getRealValue() + z) % cellCount[2];
-
-		const std::vector<size_t>&  nlist = list[coords.getMortonNum()];
-		retval.getContainer().insert(retval.getContainer().end(), nlist.begin(), nlist.end());
-	      }
-	  }
-      }
-
+    visitNeighbourhoodCells(particle_cell_coords, ListCellVisitor(retval));
     return retval;
   }
   
@@ -459,6 +776,43 @@ namespace dynamo {
     return getParticleNeighbours(getCellID(vec));
   }
 
+  void
+  GCells::getParticleNeighbourhood(const Particle& part, const nbHoodFunc& func) const
+  {
+    visitNeighbourhoodCells(partCellData[part.getID()], ParticleCellVisitor(part, func));
+  }
+
+  void
+  GCells::getParticleNeighbourhood(const Vector& vec, const nbHoodFunc2& func) const
+  {
+    visitNeighbourhoodCells(getCellID(vec), PointCellVisitor(func));
+  }
+
+  IDRangeList
+  GCells::getParticleLocals(const Particle& part) const
+  {
+    //Particles outside of the neighbour list are tested against
+    //every Local
+    if (partCellData[part.getID()] == std::numeric_limits<size_t>::max())
+      return GNeighbourList::getParticleLocals(part);
+
+    IDRangeList retval;
+    retval.getContainer().assign(cellLocalsBegin(partCellData[part.getID()]),
+				 cellLocalsEnd(partCellData[part.getID()]));
+    return retval;
+  }
+
+  void
+  GCells::getLocalNeighbourhood(const Particle& part, const nbHoodFunc& func) const
+  {
+    const size_t cellID = partCellData[part.getID()];
+    if (cellID == std::numeric_limits<size_t>::max())
+      GNeighbourList::getLocalNeighbourhood(part, func);
+    else
+      for (const size_t* it = cellLocalsBegin(cellID); it != cellLocalsEnd(cellID); ++it)
+	func(part, *it);
+  }
+
   double 
   GCells::getMaxSupportedInteractionLength() const
   {
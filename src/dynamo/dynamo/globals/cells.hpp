@@ -19,8 +19,8 @@
 #include <dynamo/globals/neighbourList.hpp>
 #include <dynamo/particle.hpp>
 #include <magnet/math/morton_number.hpp>
-#include <tr1/unordered_map>
 #include <vector>
+#include <limits>
 
 namespace dynamo {
   /*! \brief A regular cell neighbour list implementation.
@@ -39,11 +39,22 @@ namespace dynamo {
     distance from the cells border. This helps remove "rattling"
     events where particles rapidly pass between two cells.
 
-    The second property is that the contents of each cell is stored as
-    a std::vector. In theory, a linked list is far more memory
-    efficient however, the vector is much more cache friendly and can
-    boost performance by 50% in cases where the cell has multiple
-    particles inside of it.
+    The second property is that the contents of all cells are stored
+    in a single flat array, where each cell owns a fixed number of
+    slots (the array is regrown if a cell overflows). The cells are
+    laid out in Morton order, so neighbouring cells are close in
+    memory, and the cell and slot of each particle are stored in
+    plain arrays. A cell transition is then a constant time
+    swap-and-pop and an append, without any allocation.
+
+    Optionally (the SortInterval attribute), the particles of the
+    Simulation are periodically renumbered in the Morton order of
+    their cells, so that neighbouring particles are also neighbours
+    in memory. This changes the particle IDs, so it is only allowed
+    for systems where every particle is equivalent (one species, no
+    topology, no captured pairs and no ID dependent ranges), no other
+    neighbour list, and only System events and output plugins which
+    can follow the renumbering (see \ref checkSortable).
    */
   class GCells: public GNeighbourList
   {
@@ -61,8 +72,17 @@ namespace dynamo {
 
     virtual void reinitialise();
 
+    virtual double regrid(double);
+
     virtual IDRangeList getParticleNeighbours(const Particle&) const;
     virtual IDRangeList getParticleNeighbours(const Vector&) const;
+
+    virtual void getParticleNeighbourhood(const Particle&, const nbHoodFunc&) const;
+    virtual void getParticleNeighbourhood(const Vector&, const nbHoodFunc2&) const;
+
+    virtual IDRangeList getParticleLocals(const Particle&) const;
+
+    virtual void getLocalNeighbourhood(const Particle&, const nbHoodFunc&) const;
     
     virtual void operator<<(const magnet::xml::Node&);
 
@@ -74,6 +94,120 @@ namespace dynamo {
   protected:
     IDRangeList getParticleNeighbours(const magnet::math::MortonNumber<3>&) const;
 
+    //! \brief Appends the contents of each visited cell to an IDRangeList.
+    struct ListCellVisitor
+    {
+      ListCellVisitor(IDRangeList& list): _list(list) {}
+
+      void operator()(const size_t* begin, const size_t* end) const
+      { _list.getContainer().insert(_list.getContainer().end(), begin, end); }
+
+      IDRangeList& _list;
+    };
+
+    //! \brief Passes each particle in the visited cells to a nbHoodFunc.
+    struct ParticleCellVisitor
+    {
+      ParticleCellVisitor(const Particle& part, const nbHoodFunc& func): 
+	_part(part), _func(func) {}
+
+      void operator()(const size_t* begin, const size_t* end) const
+      {
+	for (const size_t* it = begin; it != end; ++it)
+	  _func(_part, *it);
+      }
+
+      const Particle& _part;
+      const nbHoodFunc& _func;
+    };
+
+    //! \brief Passes each particle in the visited cells to a nbHoodFunc2.
+    struct PointCellVisitor
+    {
+      PointCellVisitor(const nbHoodFunc2& func): _func(func) {}
+
+      void operator()(const size_t* begin, const size_t* end) const
+      {
+	for (const size_t* it = begin; it != end; ++it)
+	  _func(*it);
+      }
+
+      const nbHoodFunc2& _func;
+    };
+
+    /*! \brief Signals the new neighbours of a particle after a \ref
+      regrid.
+
+      A pair of particles is new if their old cells were not within
+      overlink cells of each other. Each pair is only signalled once.
+     */
+    struct NewNeighbourNotifier
+    {
+      NewNeighbourNotifier(const GCells& cells, const std::vector<size_t>& oldCellData, 
+			   const size_t* oldCellCount);
+
+      void notify(const Particle&, const size_t&) const;
+
+      const GCells& _cells;
+      const std::vector<size_t>& _oldCellData;
+      const size_t* _oldCellCount;
+      //! \brief The number of neighbouring pairs tested.
+      mutable size_t _pairs;
+      //! \brief The number of pairs which were signalled.
+      mutable size_t _newPairs;
+    };
+
+    /*! \brief Calls the visitor on the contents of every cell in the
+      neighbourhood of the passed cell.
+
+      The cells are visited in place, no copies of the cell contents
+      are made.
+     */
+    template<class Visitor>
+    void visitNeighbourhoodCells(const magnet::math::MortonNumber<3>& particle_cell_coords, 
+				 const Visitor& visitor) const
+    {
+      magnet::math::MortonNumber<3> zero_coords;
+      for (size_t iDim(0); iDim < NDIM; ++iDim)
+	zero_coords[iDim] = (particle_cell_coords[iDim].getRealValue() + cellCount[iDim] - overlink)
+	  % cellCount[iDim];
+
+      magnet::math::MortonNumber<3> coords(zero_coords);
+      for (size_t x(0); x < 2 * overlink + 1; ++x)
+	{
+	  coords[0] = (zero_coords[0].getRealValue() + x) % cellCount[0];
+	  for (size_t y(0); y < 2 * overlink + 1; ++y)
+	    {
+	      coords[1] = (zero_coords[1].getRealValue() + y) % cellCount[1];
+	      for (size_t z(0); z < 2 * overlink + 1; ++z)
+		{
+		  coords[2] = (zero_coords[2].getRealValue() + z) % cellCount[2];
+		  const size_t cellID = coords.getMortonNum();
+		  visitor(cellBegin(cellID), cellEnd(cellID));
+		}
+	    }
+	}
+    }
+
+    //! \brief The first particle ID stored in a cell.
+    inline const size_t* cellBegin(size_t cellID) const
+    { return &_cellParticles[0] + _cellIndex[cellID] * _cellCapacity; }
+
+    //! \brief One past the last particle ID stored in a cell.
+    inline const size_t* cellEnd(size_t cellID) const
+    { 
+      const size_t index = _cellIndex[cellID];
+      return &_cellParticles[0] + index * _cellCapacity + _cellOccupancy[index];
+    }
+
+    //! \brief The first Local ID stored in a cell.
+    inline const size_t* cellLocalsBegin(size_t cellID) const
+    { return &_cellLocals[0] + _cellLocalStart[_cellIndex[cellID]]; }
+
+    //! \brief One past the last Local ID stored in a cell.
+    inline const size_t* cellLocalsEnd(size_t cellID) const
+    { return &_cellLocals[0] + _cellLocalStart[_cellIndex[cellID] + 1]; }
+
     size_t cellCount[3];
     magnet::math::DilatedInteger<3> dilatedCellMax[3];
     Vector cellDimension;
@@ -87,15 +221,47 @@ namespace dynamo {
     boost::signals2::scoped_connection _particleAdded;
     boost::signals2::scoped_connection _particleRemoved;
 
-    //! \brief The list of particles in each cell.
-    mutable std::vector<std::vector<size_t> > list;
+    /*! \brief The number of cell transitions per particle between
+      renumbering the particles in Morton order (zero to disable).
+     */
+    double _sortInterval;
+    mutable size_t _cellEventsSinceSort;
+
+    /*! \brief Maps the Morton number of a cell to its index in the
+      cell storage.
+
+      The Morton numbers of the cells are not contiguous, so the
+      cells are stored densely in Morton order.
+     */
+    std::vector<size_t> _cellIndex;
 
-    /*! \brief The cell for a given particle.
+    //! \brief The particle IDs of each cell, in slots of _cellCapacity.
+    mutable std::vector<size_t> _cellParticles;
+
+    //! \brief The number of particles in each cell.
+    mutable std::vector<size_t> _cellOccupancy;
+
+    //! \brief The number of slots of each cell.
+    mutable size_t _cellCapacity;
+
+    /*! \brief The cell (Morton number) of each particle.
       
-      This container is an unordered map, so we only store the linked
-      list for the particles actually inserted into this neighborlist.
+      Particles which are not in the neighbour list are marked with
+      std::numeric_limits<size_t>::max().
+     */
+    mutable std::vector<size_t> partCellData;
+
+    //! \brief The slot of each particle in its cell.
+    mutable std::vector<size_t> _partSlot;
+
+    /*! \brief The Local IDs of each cell, in a compressed row layout.
+
+      The Locals of the cell with index i are stored in
+      [_cellLocalStart[i], _cellLocalStart[i+1]) of _cellLocals.
+      _cellLocals has an extra padding entry, so it is never empty.
      */
-    mutable std::tr1::unordered_map<size_t, size_t> partCellData;
+    std::vector<size_t> _cellLocalStart;
+    std::vector<size_t> _cellLocals;
 
     GCells(const GCells&);
 
@@ -105,6 +271,30 @@ namespace dynamo {
 
     void addCells(double);
 
+    /*! \brief Stores each Local in the cells which overlap an image of
+      its bounds (see Local::getBounds).
+     */
+    void addLocalsToCells();
+
+    /*! \brief Signals the Locals of a particle's new cell which were
+      not in its old cell.
+     */
+    void notifyNewLocals(const Particle&, size_t oldCell, size_t newCell) const;
+
+    /*! \brief Doubles the number of slots of every cell.
+     */
+    void growCells() const;
+
+    /*! \brief Renumbers the particles in the Morton order of their
+      cells and rebuilds the neighbour list and scheduler.
+     */
+    void sortParticles() const;
+
+    /*! \brief Throws if the particles cannot be renumbered by
+      \ref sortParticles, as something depends on the particle IDs.
+     */
+    void checkSortable() const;
+
     inline Vector calcPosition(const magnet::math::MortonNumber<3>& coords,
 			       const Particle& part) const;
 
@@ -115,38 +305,35 @@ namespace dynamo {
 
     inline void addToCell(size_t ID, size_t cellID) const
     {
-      list[cellID].push_back(ID);
+      if (ID >= partCellData.size())
+	{
+	  partCellData.resize(ID + 1, std::numeric_limits<size_t>::max());
+	  _partSlot.resize(ID + 1);
+	}
+
+      const size_t index = _cellIndex[cellID];
+      if (_cellOccupancy[index] == _cellCapacity) growCells();
+
+      _partSlot[ID] = _cellOccupancy[index]++;
+      _cellParticles[index * _cellCapacity + _partSlot[ID]] = ID;
       partCellData[ID] = cellID;
     }
   
     inline void removeFromCell(size_t ID) const
-    { removeFromCellwIt(ID, partCellData.find(ID)); }
-
-    inline void removeFromCellwIt(size_t ID, std::tr1::unordered_map<size_t, size_t>::iterator it) const
     {
 #ifdef DYNAMO_DEBUG
-    if (it == partCellData.end())
-      M_throw() << "Could not find the particle's cell data";
-#endif
-      const size_t cellID = it->second;
-      //Erase the cell data
-      partCellData.erase(it);
-
-      std::vector<std::vector<size_t> >::iterator listIt = list.begin() + cellID;
-#ifdef DYNAMO_DEBUG
-    if (listIt == list.end())
-      M_throw() << "Could not find the particle's cell data";
-#endif
-
-      std::vector<size_t>::iterator pit = std::find(listIt->begin(), listIt->end(), ID);      
-
-#ifdef DYNAMO_DEBUG
-      if (pit == listIt->end())
+      if ((ID >= partCellData.size()) || (partCellData[ID] == std::numeric_limits<size_t>::max()))
 	M_throw() << "Removing a particle (ID=" << ID << ") which is not in a cell";
 #endif
+      const size_t index = _cellIndex[partCellData[ID]];
+      const size_t base = index * _cellCapacity;
+
+      //Move the last particle of the cell into the vacated slot
+      const size_t last = _cellParticles[base + --_cellOccupancy[index]];
+      _cellParticles[base + _partSlot[ID]] = last;
+      _partSlot[last] = _partSlot[ID];
 
-      *pit = listIt->back();
-      listIt->pop_back();
+      partCellData[ID] = std::numeric_limits<size_t>::max();
     }
   };
 }
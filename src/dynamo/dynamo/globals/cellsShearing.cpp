@@ -237,9 +237,10 @@ namespace dynamo {
 	      {
 		newNBCell[dim1] %= cellCount[dim1];
   
-		BOOST_FOREACH(const size_t& next, list[newNBCell.getMortonNum()])
+		const size_t cellID = newNBCell.getMortonNum();
+		for (const size_t* next = cellBegin(cellID); next != cellEnd(cellID); ++next)
 		  BOOST_FOREACH(const nbHoodSlot& nbs, sigNewNeighbourNotify)
-		    nbs.second(part, next);
+		    nbs.second(part, *next);
 	  
 		++newNBCell[dim1];
 	      }
@@ -248,6 +249,8 @@ namespace dynamo {
 	    ++newNBCell[dim2];
 	  }
       }
+
+    notifyNewLocals(part, oldCell, partCellData[part.getID()]);
     
     //Push the next virtual event, this is the reason the scheduler
     //doesn't need a second callback
@@ -311,34 +314,29 @@ namespace dynamo {
   std::vector<size_t>
   GCellsShearing::getAdditionalLEParticleNeighbourhood(magnet::math::MortonNumber<3> cellCoords) const
   {  
-#ifdef DYNAMO_DEBUG
-    if ((cellCoords[1] != 0) && (cellCoords[1] != dilatedCellMax[1]))
-      M_throw() << "Shouldn't call this function unless the particle is at a border in the y dimension";
-#endif 
-
-    //Move to the bottom of x
-    cellCoords[0] = 0;
-    //Get the correct y-side (its the opposite to the particles current side)
-    cellCoords[1] = (cellCoords[1] > 0) ? 0 : dilatedCellMax[1];  
-    ////Move te overlink across
-    cellCoords[2] = (cellCoords[2].getRealValue() + cellCount[2] - overlink) % cellCount[2];
-
-    std::vector<size_t> retval;
-    retval.reserve(32);
-    for (size_t i(0); i < 2 * overlink + 1; ++i)
-      {
-	cellCoords[2] %= cellCount[2];
+    IDRangeList retval;
+    retval.getContainer().reserve(32);
+    visitAdditionalLECells(cellCoords, ListCellVisitor(retval));
+    return retval.getContainer();
+  }
 
-	for (size_t j(0); j < cellCount[0]; ++j)
-	  {
-	    const std::vector<size_t>& nbs(list[cellCoords.getMortonNum()]);
-	    retval.insert(retval.end(), nbs.begin(), nbs.end());
+  void
+  GCellsShearing::getParticleNeighbourhood(const Particle& part, const nbHoodFunc& func) const
+  {
+    const magnet::math::MortonNumber<3> cellCoords(partCellData[part.getID()]);
+    visitNeighbourhoodCells(cellCoords, ParticleCellVisitor(part, func));
 
-	    ++cellCoords[0];
-	  }
-	++cellCoords[2];
-	cellCoords[0] = 0;
-      }
-    return retval;
+    if ((cellCoords[1] == 0) || (cellCoords[1] == dilatedCellMax[1]))
+      visitAdditionalLECells(cellCoords, ParticleCellVisitor(part, func));
+  }
+
+  void
+  GCellsShearing::getParticleNeighbourhood(const Vector& vec, const nbHoodFunc2& func) const
+  {
+    const magnet::math::MortonNumber<3> cellCoords(getCellID(vec));
+    visitNeighbourhoodCells(cellCoords, PointCellVisitor(func));
+
+    if ((cellCoords[1] == 0) || (cellCoords[1] == dilatedCellMax[1]))
+      visitAdditionalLECells(cellCoords, PointCellVisitor(func));
   }
 }
@@ -38,8 +38,46 @@ namespace dynamo {
     virtual IDRangeList getParticleNeighbours(const Particle&) const;
     virtual IDRangeList getParticleNeighbours(const Vector&) const;
 
+    virtual void getParticleNeighbourhood(const Particle&, const nbHoodFunc&) const;
+    virtual void getParticleNeighbourhood(const Vector&, const nbHoodFunc2&) const;
+
   protected:
     IDRangeList getParticleNeighbours(const magnet::math::MortonNumber<3>&) const;
+
+    /*! \brief Calls the visitor on every cell in the extra Lees-Edwards
+      neighbourhood strip of a cell on the y boundary.
+     */
+    template<class Visitor>
+    void visitAdditionalLECells(magnet::math::MortonNumber<3> cellCoords,
+				const Visitor& visitor) const
+    {
+#ifdef DYNAMO_DEBUG
+      if ((cellCoords[1] != 0) && (cellCoords[1] != dilatedCellMax[1]))
+	M_throw() << "Shouldn't call this function unless the particle is at a border in the y dimension";
+#endif 
+
+      //Move to the bottom of x
+      cellCoords[0] = 0;
+      //Get the correct y-side (its the opposite to the particles current side)
+      cellCoords[1] = (cellCoords[1] > 0) ? 0 : dilatedCellMax[1];  
+      ////Move te overlink across
+      cellCoords[2] = (cellCoords[2].getRealValue() + cellCount[2] - overlink) % cellCount[2];
+
+      for (size_t i(0); i < 2 * overlink + 1; ++i)
+	{
+	  cellCoords[2] %= cellCount[2];
+
+	  for (size_t j(0); j < cellCount[0]; ++j)
+	    {
+	      const size_t cellID = cellCoords.getMortonNum();
+	      visitor(cellBegin(cellID), cellEnd(cellID));
+	      ++cellCoords[0];
+	    }
+	  ++cellCoords[2];
+	  cellCoords[0] = 0;
+	}
+    }
+
     std::vector<size_t> getAdditionalLEParticleNeighbourhood(const Particle&) const;
     std::vector<size_t> getAdditionalLEParticleNeighbourhood(magnet::math::MortonNumber<3>) const;
   };
@@ -64,6 +64,14 @@ namespace dynamo {
      */
     virtual void runEvent(Particle& p, const double dt) const = 0;
 
+    /*! \brief Tests if the event times of this Global are only scaled
+        when every velocity is scaled (see
+        Dynamics::eventTimesScaleWithVelocity).
+
+      This is false for Globals with events at fixed times.
+     */
+    virtual bool eventTimesScaleWithVelocity() const { return true; }
+
     /*! \brief Initializes the Global event.
      */
     virtual void initialise(size_t) = 0;
@@ -93,6 +101,10 @@ namespace dynamo {
     /*! \brief Returns the unique ID number of this Global.
      */
     inline const size_t& getID() const { return ID; }
+
+    /*! \brief Returns the range of particles this Global applies to.
+     */
+    const shared_ptr<IDRange>& getRange() const { return range; }
   
   protected:
     /*! \brief Writes out an XML representation of the Global
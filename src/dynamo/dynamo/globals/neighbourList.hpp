@@ -96,6 +96,47 @@ namespace dynamo {
     virtual IDRangeList getParticleNeighbours(const Particle&) const = 0;
     virtual IDRangeList getParticleNeighbours(const Vector&) const = 0;
 
+    /*! \brief Calls the passed function for every particle in the
+      neighbourhood of a \ref Particle.
+
+      Unlike \ref getParticleNeighbours, this walks the neighbour
+      list's own storage in place and does not build a temporary
+      container, so it may be used inside the event loop without any
+      heap allocation.
+     */
+    virtual void getParticleNeighbourhood(const Particle&, const nbHoodFunc&) const = 0;
+
+    /*! \brief Calls the passed function for every particle in the
+      neighbourhood of a point.
+      
+      \sa getParticleNeighbourhood(const Particle&, const nbHoodFunc&)
+     */
+    virtual void getParticleNeighbourhood(const Vector&, const nbHoodFunc2&) const = 0;
+
+    /*! \brief Returns the IDs of the \ref Local s which may have
+      events with a \ref Particle.
+
+      The default implementation returns every Local.
+     */
+    virtual IDRangeList getParticleLocals(const Particle&) const
+    {
+      IDRangeList retval;
+      for (size_t id(0); id < Sim->locals.size(); ++id)
+	retval.getContainer().push_back(id);
+      return retval;
+    }
+
+    /*! \brief Calls the passed function for every \ref Local which
+      may have events with a \ref Particle.
+
+      \sa getParticleLocals
+     */
+    virtual void getLocalNeighbourhood(const Particle& part, const nbHoodFunc& func) const
+    {
+      for (size_t id(0); id < Sim->locals.size(); ++id)
+	func(part, id);
+    }
+
     template<class T> size_t
     ConnectSigCellChangeNotify
     (void (T::*func)(const Particle&, const size_t&)const , const T* tp) const 
@@ -138,6 +179,31 @@ namespace dynamo {
 	 sigNewNeighbourNotify.end());
     }
     
+    /*! \brief Registers a callback for when a \ref Local may start
+      to have events with a particle, as the particle has moved
+      closer to it.
+     */
+    template<class T> size_t
+    ConnectSigNewLocalNotify
+    (void (T::*func)(const Particle&, const size_t&) const, const T* tp) const 
+    {    
+      sigNewLocalNotify.push_back
+	(nbHoodSlot(++sigNewLocalNotifyCount, 
+		    nbHoodFunc(tp, func)));
+    
+      return sigNewLocalNotifyCount; 
+    }
+
+    inline void
+    DisconnectSigNewLocalNotify(const size_t& id) const 
+    {    
+      sigNewLocalNotify.erase
+	(std::remove_if(sigNewLocalNotify.begin(),
+			sigNewLocalNotify.end(),
+			nbHoodSlotEraser(id)), 
+	 sigNewLocalNotify.end());
+    }
+
     template<class T> size_t
     ConnectSigReInitNotify(void (T::*func)(), T* tp) const 
     {    
@@ -199,6 +265,23 @@ namespace dynamo {
       if (_initialised) reinitialise();
     }
 
+    /*! \brief Changes the minimum range this neighbourlist is to
+      support during a simulation.
+
+      Unlike \ref setMaxInteractionRange, this does not validate the
+      system or rebuild every event of the scheduler. Neighbour lists
+      which can, only add the events of the pairs of particles which
+      were not already neighbours.
+
+      \returns The fraction of the neighbouring pairs whose events
+      had to be predicted, which is one for a full rebuild.
+     */
+    virtual double regrid(double range)
+    {
+      setMaxInteractionRange(range);
+      return 1.0;
+    }
+
     /*! \brief Returns the requested minimum supported interaction
         range.
      */
@@ -223,6 +306,10 @@ namespace dynamo {
     mutable std::vector<nbHoodSlot>
     sigNewNeighbourNotify;
 
+    mutable size_t sigNewLocalNotifyCount;
+    mutable std::vector<nbHoodSlot>
+    sigNewLocalNotify;
+
     mutable size_t sigReInitNotifyCount;
     mutable std::vector<initSlot> 
     sigReInitNotify;
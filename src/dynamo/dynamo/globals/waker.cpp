@@ -133,9 +133,8 @@ namespace dynamo {
     _neighbors = 0;
 
     //Add the interaction events
-    std::auto_ptr<IDRange> ids(Sim->ptrScheduler->getParticleNeighbours(part));
-    BOOST_FOREACH(const size_t& id1, *ids)
-      nblistCallback(part, id1);
+    Sim->ptrScheduler->getParticleNeighbourhood
+      (part, GNeighbourList::nbHoodFunc(this, &GWaker::nblistCallback));
   
     ParticleEventData EDat(part, *Sim->species[part], iEvent.getType());
       
@@ -151,8 +150,7 @@ namespace dynamo {
       
     Sim->signalParticleUpdate(EDat);
       
-    BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, Sim->outputPlugins)
-      Ptr->eventUpdate(iEvent, EDat);
+    Sim->signalEvent(iEvent, EDat);
 
     //Now we're past the event, update the scheduler and plugins
     Sim->ptrScheduler->fullUpdate(part);
@@ -37,6 +37,9 @@ namespace dynamo {
 
     virtual void runEvent(Particle&, const double) const;
 
+    //! The particles are woken after a fixed time
+    virtual bool eventTimesScaleWithVelocity() const { return false; }
+
     virtual void initialise(size_t);
 
     virtual void operator<<(const magnet::xml::Node&);
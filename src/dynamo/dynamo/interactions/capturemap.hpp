@@ -0,0 +1,238 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <magnet/containers/small_vector.hpp>
+#include <magnet/exception.hpp>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+namespace dynamo {
+  namespace detail {
+    /*! \brief Describes the entries of a CaptureMap.
+
+      An entry is either the ID of the partner particle (for a map
+      without states) or a pair of the partner ID and the state.
+     */
+    template<class Entry> struct CaptureEntryTraits;
+
+    template<> 
+    struct CaptureEntryTraits<size_t>
+    {
+      typedef std::pair<size_t, size_t> value_type;
+
+      static inline size_t ID(const size_t& entry) { return entry; }
+      static inline size_t make(size_t ID) { return ID; }
+      static inline value_type value(size_t ID, const size_t& entry) 
+      { return value_type(ID, entry); }
+    };
+
+    template<class T>
+    struct CaptureEntryTraits<std::pair<size_t, T> >
+    {
+      typedef std::pair<const std::pair<size_t, size_t>, T> value_type;
+
+      static inline size_t ID(const std::pair<size_t, T>& entry) { return entry.first; }
+      static inline std::pair<size_t, T> make(size_t ID) { return std::pair<size_t, T>(ID, T()); }
+      static inline value_type value(size_t ID, const std::pair<size_t, T>& entry) 
+      { return value_type(std::pair<size_t, size_t>(ID, entry.first), entry.second); }
+    };
+  }
+
+  /*! \brief A store of the captured pairs of particles used by the
+      ICapture Interactions.
+
+    Each pair is stored once, in an array belonging to the lower ID
+    particle, which holds its partners sorted by ID. A particle only
+    captures the handful of particles around it, so a look-up is a
+    short search of a contiguous array instead of a walk through the
+    nodes of a hash map, and each pair only costs the size of an \p
+    Entry. The first few partners of each particle are stored inline
+    in the particle's array, so capturing and releasing pairs rarely
+    allocates.
+
+    \tparam Entry Either size_t, when only the captured pairs are
+    stored, or std::pair<size_t, T> to also store a state of type T
+    for each pair.
+
+    Iterating over the map visits the pairs in ascending order of the
+    IDs, and gives a std::pair of the (lower, higher) IDs or, if there
+    are states, a std::pair of the IDs and the state.
+   */
+  template<class Entry>
+  class CaptureMap
+  {
+    typedef detail::CaptureEntryTraits<Entry> Traits;
+    //! A particle rarely captures more than a few partners.
+    typedef magnet::containers::SmallVector<Entry, 4> Partners;
+
+    struct IDCompare
+    {
+      inline bool operator()(const Entry& entry, size_t ID) const
+      { return Traits::ID(entry) < ID; }
+    };
+
+  public:
+    typedef typename Traits::value_type value_type;
+
+    class const_iterator
+    {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef typename Traits::value_type value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef const value_type* pointer;
+      typedef value_type reference;
+
+      const_iterator(): _map(NULL), _ID(0), _index(0) {}
+
+      inline value_type operator*() const
+      { return Traits::value(_ID, _map->_partners[_ID][_index]); }
+
+      inline const_iterator& operator++()
+      {
+	++_index;
+	skipEmpty();
+	return *this;
+      }
+
+      inline const_iterator operator++(int)
+      {
+	const_iterator retval(*this);
+	++(*this);
+	return retval;
+      }
+
+      inline bool operator==(const const_iterator& o) const
+      { return (_ID == o._ID) && (_index == o._index); }
+
+      inline bool operator!=(const const_iterator& o) const
+      { return !(*this == o); }
+
+    private:
+      friend class CaptureMap;
+
+      const_iterator(const CaptureMap* map, size_t ID):
+	_map(map), _ID(ID), _index(0)
+      { skipEmpty(); }
+
+      inline void skipEmpty()
+      {
+	while ((_ID < _map->_partners.size()) && (_index == _map->_partners[_ID].size()))
+	  { ++_ID; _index = 0; }
+      }
+
+      const CaptureMap* _map;
+      size_t _ID;
+      size_t _index;
+    };
+
+    typedef const_iterator iterator;
+
+    CaptureMap(): _size(0) {}
+
+    //! \brief The number of captured pairs.
+    inline size_t size() const { return _size; }
+
+    inline bool empty() const { return !_size; }
+
+    inline void clear() { _partners.clear(); _size = 0; }
+
+    inline const_iterator begin() const { return const_iterator(this, 0); }
+    inline const_iterator end() const { return const_iterator(this, _partners.size()); }
+
+    //! \brief Returns 1 if the pair is captured, otherwise 0.
+    inline size_t count(size_t ID1, size_t ID2) const { return find(ID1, ID2) != NULL; }
+
+    //! \brief Returns the entry of a pair, or NULL if it is not captured.
+    inline const Entry* find(size_t ID1, size_t ID2) const
+    {
+#ifdef DYNAMO_DEBUG
+      if (ID1 == ID2) M_throw() << "Particle ID's should not be equal!";
+#endif
+      const size_t low = std::min(ID1, ID2);
+      if (low >= _partners.size()) return NULL;
+
+      const size_t high = std::max(ID1, ID2);
+      const Partners& partners = _partners[low];
+      //The arrays are short, so a linear search is fastest
+      for (typename Partners::const_iterator it = partners.begin(); it != partners.end(); ++it)
+	if (Traits::ID(*it) >= high)
+	  return (Traits::ID(*it) == high) ? &(*it) : NULL;
+
+      return NULL;
+    }
+
+    inline Entry* find(size_t ID1, size_t ID2)
+    { return const_cast<Entry*>(static_cast<const CaptureMap&>(*this).find(ID1, ID2)); }
+
+    /*! \brief Adds a pair to the map, returning its entry.
+
+      If the pair is already captured, its existing entry is
+      returned. A new entry has a value initialised state. The
+      returned reference is invalidated by the next insertion.
+     */
+    inline Entry& insert(size_t ID1, size_t ID2)
+    {
+#ifdef DYNAMO_DEBUG
+      if (ID1 == ID2) M_throw() << "Particle ID's should not be equal!";
+#endif
+      const size_t low = std::min(ID1, ID2);
+      const size_t high = std::max(ID1, ID2);
+      if (low >= _partners.size()) _partners.resize(low + 1);
+
+      Partners& partners = _partners[low];
+      typename Partners::iterator it 
+	= std::lower_bound(partners.begin(), partners.end(), high, IDCompare());
+
+      if ((it != partners.end()) && (Traits::ID(*it) == high))
+	return *it;
+
+      ++_size;
+      return *partners.insert(it, Traits::make(high));
+    }
+
+    //! \brief Removes a pair from the map, returning 1 if it was captured.
+    inline size_t erase(size_t ID1, size_t ID2)
+    {
+      const size_t low = std::min(ID1, ID2);
+      if (low >= _partners.size()) return 0;
+
+      const size_t high = std::max(ID1, ID2);
+      Partners& partners = _partners[low];
+      typename Partners::iterator it 
+	= std::lower_bound(partners.begin(), partners.end(), high, IDCompare());
+
+      if ((it == partners.end()) || (Traits::ID(*it) != high))
+	return 0;
+
+      partners.erase(it);
+      --_size;
+      return 1;
+    }
+
+    //! \brief Preallocates the arrays for a number of particles.
+    inline void reserve(size_t N) { if (_partners.size() < N) _partners.resize(N); }
+    
+  private:
+    std::vector<Partners> _partners;
+    size_t _size;
+  };
+}
@@ -19,9 +19,11 @@
 #include <dynamo/particle.hpp>
 #include <dynamo/schedulers/scheduler.hpp>
 #include <dynamo/simulation.hpp>
+#include <dynamo/checkpoint.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <magnet/xmlreader.hpp>
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 
 namespace dynamo {
   void 
@@ -32,6 +34,10 @@ namespace dynamo {
   }   
 
 
+  std::string
+  ICapture::checkpointBlockName() const
+  { return "CaptureMap:" + boost::lexical_cast<std::string>(ID); }
+
   void 
   ICapture::initCaptureMap()
   {
@@ -40,9 +46,9 @@ namespace dynamo {
       {      
 	clear();
 
-	for (std::vector<Particle>::const_iterator iPtr1 = Sim->particles.begin();
+	for (ParticleContainer::const_iterator iPtr1 = Sim->particles.begin();
 	     iPtr1 != Sim->particles.end(); iPtr1++)
-	  for (std::vector<Particle>::const_iterator iPtr2 = iPtr1+1;
+	  for (ParticleContainer::const_iterator iPtr2 = iPtr1+1;
 	       iPtr2 != Sim->particles.end(); iPtr2++)
 	    //Check this interaction is the correct interaction for the pair
 	    if (Sim->getInteraction(*iPtr1, *iPtr2).get() == static_cast<const Interaction*>(this))
@@ -58,19 +64,51 @@ namespace dynamo {
 	noXmlLoad = false;
 	clear();
 
+	if (XML.getNode("CaptureMap").hasAttribute("Binary"))
+	  {
+	    if (!Sim->checkpointIn)
+	      M_throw() << "The capture map of the \"" << intName << "\" Interaction is stored in a binary checkpoint";
+
+	    size_t count;
+	    const boost::uint64_t* IDs
+	      = Sim->checkpointIn->getBlock<boost::uint64_t>
+	      (XML.getNode("CaptureMap").getAttribute("Binary").getValue(), count);
+	    for (size_t i(0); i + 1 < count; i += 2)
+	      captureMap.insert(IDs[i], IDs[i + 1]);
+	    return;
+	  }
+
 	for (magnet::xml::Node node = XML.getNode("CaptureMap").fastGetNode("Pair");
 	     node.valid(); ++node)
-	  captureMap.insert(cMapKey(node.getAttribute("ID1").as<size_t>(),
-				    node.getAttribute("ID2").as<size_t>()));
+	  captureMap.insert(node.getAttribute("ID1").as<size_t>(),
+			    node.getAttribute("ID2").as<size_t>());
       }
   }
 
   void 
   ISingleCapture::outputCaptureMap(magnet::xml::XmlStream& XML) const 
   {
+    if (Sim->checkpointOut)
+      {
+	std::vector<boost::uint64_t> IDs;
+	IDs.reserve(2 * captureMap.size());
+	BOOST_FOREACH(const captureMapType::value_type& key, captureMap)
+	  {
+	    IDs.push_back(key.first);
+	    IDs.push_back(key.second);
+	  }
+
+	const std::string block = checkpointBlockName();
+	Sim->checkpointOut->addBlock(block, IDs);
+	XML << magnet::xml::tag("CaptureMap")
+	    << magnet::xml::attr("Binary") << block
+	    << magnet::xml::endtag("CaptureMap");
+	return;
+      }
+
     XML << magnet::xml::tag("CaptureMap");
 
-    BOOST_FOREACH(const cMapKey& IDs, captureMap)
+    BOOST_FOREACH(const captureMapType::value_type& IDs, captureMap)
       XML << magnet::xml::tag("Pair")
 	  << magnet::xml::attr("ID1") << IDs.first
 	  << magnet::xml::attr("ID2") << IDs.second
@@ -86,7 +124,7 @@ namespace dynamo {
   IMultiCapture::testAddToCaptureMap(const Particle& p1, const size_t& p2) const
   {
     int capval = captureTest(p1, Sim->particles[p2]);
-    if (capval) captureMap[cMapKey(p1.getID(), p2)] = capval; 
+    if (capval) captureMap.insert(p1.getID(), p2).second = capval; 
   }
 
   void 
@@ -97,10 +135,25 @@ namespace dynamo {
 	noXmlLoad = false;
 	clear();
 
+	if (XML.getNode("CaptureMap").hasAttribute("Binary"))
+	  {
+	    if (!Sim->checkpointIn)
+	      M_throw() << "The capture map of the \"" << intName << "\" Interaction is stored in a binary checkpoint";
+
+	    //Each entry is stored as the two IDs followed by the value
+	    size_t count;
+	    const boost::uint64_t* entries
+	      = Sim->checkpointIn->getBlock<boost::uint64_t>
+	      (XML.getNode("CaptureMap").getAttribute("Binary").getValue(), count);
+	    for (size_t i(0); i + 2 < count; i += 3)
+	      captureMap.insert(entries[i], entries[i + 1]).second = entries[i + 2];
+	    return;
+	  }
+
 	for (magnet::xml::Node node = XML.getNode("CaptureMap").fastGetNode("Pair");
 	     node.valid(); ++node)
-	  captureMap[cMapKey(node.getAttribute("ID1").as<size_t>(),
-			     node.getAttribute("ID2").as<size_t>())]
+	  captureMap.insert(node.getAttribute("ID1").as<size_t>(),
+			    node.getAttribute("ID2").as<size_t>()).second
 	    = node.getAttribute("val").as<size_t>();
       }
   }
@@ -108,9 +161,28 @@ namespace dynamo {
   void 
   IMultiCapture::outputCaptureMap(magnet::xml::XmlStream& XML) const 
   {
-    XML << magnet::xml::tag("CaptureMap");
+    typedef captureMapType::value_type locpair;
+
+    if (Sim->checkpointOut)
+      {
+	std::vector<boost::uint64_t> entries;
+	entries.reserve(3 * captureMap.size());
+	BOOST_FOREACH(const locpair& IDs, captureMap)
+	  {
+	    entries.push_back(IDs.first.first);
+	    entries.push_back(IDs.first.second);
+	    entries.push_back(IDs.second);
+	  }
+
+	const std::string block = checkpointBlockName();
+	Sim->checkpointOut->addBlock(block, entries);
+	XML << magnet::xml::tag("CaptureMap")
+	    << magnet::xml::attr("Binary") << block
+	    << magnet::xml::endtag("CaptureMap");
+	return;
+      }
 
-    typedef std::pair<const cMapKey, int> locpair;
+    XML << magnet::xml::tag("CaptureMap");
 
     BOOST_FOREACH(const locpair& IDs, captureMap)
       XML << magnet::xml::tag("Pair")
@@ -126,7 +198,7 @@ namespace dynamo {
   ISingleCapture::validateState(bool textoutput, size_t max_reports) const
   {
     size_t retval(0);
-    BOOST_FOREACH(const cMapKey& IDs, captureMap)
+    BOOST_FOREACH(const captureMapType::value_type& IDs, captureMap)
       {
 	const Particle& p1(Sim->particles[IDs.first]);
 	const Particle& p2(Sim->particles[IDs.second]);
@@ -148,7 +220,7 @@ namespace dynamo {
   IMultiCapture::validateState(bool textoutput, size_t max_reports) const
   {
     size_t retval(0);
-    typedef std::pair<const dynamo::ICapture::cMapKey, int> mapdata;
+    typedef captureMapType::value_type mapdata;
     BOOST_FOREACH(const mapdata& IDs, captureMap)
       {
 	const Particle& p1(Sim->particles[IDs.first.first]);
@@ -19,10 +19,8 @@
 
 #include <dynamo/particle.hpp>
 #include <dynamo/interactions/interaction.hpp>
+#include <dynamo/interactions/capturemap.hpp>
 #include <magnet/exception.hpp>
-#include <boost/functional/hash.hpp>
-#include <tr1/unordered_set>
-#include <tr1/unordered_map>
 #include <vector>
 
 namespace dynamo {
@@ -69,26 +67,15 @@ namespace dynamo {
 
     virtual void testAddToCaptureMap(const Particle& p1, const size_t& p2) const = 0;
 
-    /*! \brief A key used to represent two particles.
-     
-      This key sorts the particle ID's into ascending order. This way
-      the keys can be compared and symmetric keys will compare equal.
-      \code assert(cMapKey(a,b) == cMapKey(b,a)); \endcode
+    /*! \brief The name of the binary checkpoint block holding the
+        capture map.
+
+      This is keyed by the Interaction ID, as the Interaction names
+      may be longer than the block names allowed in a checkpoint. The
+      name is also stored in the XML, so the ID is not needed when
+      the checkpoint is loaded.
      */
-    struct cMapKey: public std::pair<size_t,size_t>
-    {
-      inline cMapKey() {}
-    
-      //The ContactMap output plugin relies that the ID pair is sorted
-      //min,max
-      inline cMapKey(const size_t& a, const size_t& b):
-	std::pair<size_t,size_t>(std::min(a, b), std::max(a, b))
-      {
-#ifdef DYNAMO_DEBUG
-	if (a == b) M_throw() << "Particle ID's should not be equal!";
-#endif
-      }
-    };
+    std::string checkpointBlockName() const;
   };
 
   /*! \brief This base class is for Interaction classes which only
@@ -108,17 +95,19 @@ namespace dynamo {
     inline bool isCaptured(const Particle& p1, const Particle& p2) const { return isCaptured(p1.getID(), p2.getID()); }
 
     virtual bool isCaptured(const size_t p1, const size_t p2) const
-    { return captureMap.count(cMapKey(p1, p2)); }
+    { return captureMap.count(p1, p2); }
 
     virtual void clear() const { captureMap.clear(); }
 
     virtual size_t validateState(bool textoutput = true, size_t max_reports = std::numeric_limits<size_t>::max()) const;
 
-    const std::tr1::unordered_set<cMapKey, boost::hash<cMapKey> >& getMap() const { return captureMap; }
+    typedef CaptureMap<size_t> captureMapType;
+
+    const captureMapType& getMap() const { return captureMap; }
     
   protected:
 
-    mutable std::tr1::unordered_set<cMapKey, boost::hash<cMapKey> > captureMap;
+    mutable captureMapType captureMap;
 
     /*! \brief Test if two particles should be "captured".
     
@@ -148,23 +137,23 @@ namespace dynamo {
     void addToCaptureMap(const Particle& p1, const Particle& p2) const
     {
 #ifdef DYNAMO_DEBUG
-      if (captureMap.count(cMapKey(p1.getID(), p2.getID())))
+      if (captureMap.count(p1.getID(), p2.getID()))
 	M_throw() << "Insert found " << std::min(p1.getID(), p2.getID())
 		  << " and " << std::max(p1.getID(), p2.getID()) << " in the capture map";
 #endif
     
-      captureMap.insert(cMapKey(p1.getID(), p2.getID()));
+      captureMap.insert(p1.getID(), p2.getID());
     }
   
     //! \brief Remove a pair of particles to the capture map.
     void removeFromCaptureMap(const Particle& p1, const Particle& p2) const
     {
 #ifdef DYNAMO_DEBUG
-      if (captureMap.find(cMapKey(p1.getID(), p2.getID())) == captureMap.end())
+      if (!captureMap.count(p1.getID(), p2.getID()))
 	M_throw() << "Deleting a particle while its already gone!";
 #endif
 
-      captureMap.erase(cMapKey(p1.getID(), p2.getID()));
+      captureMap.erase(p1.getID(), p2.getID());
     } 
 
   };
@@ -182,7 +171,7 @@ namespace dynamo {
     inline bool isCaptured(const Particle& p1, const Particle& p2) const { return isCaptured(p1.getID(), p2.getID()); }
 
     virtual bool isCaptured(const size_t p1, const size_t p2) const
-    { return captureMap.count(cMapKey(p1, p2)); }
+    { return captureMap.count(p1, p2); }
 
     virtual void clear() const { captureMap.clear(); }
 
@@ -190,9 +179,15 @@ namespace dynamo {
 
   protected:
   
-    typedef std::tr1::unordered_map<cMapKey, int, boost::hash<cMapKey> > captureMapType;
-    typedef captureMapType::iterator cmap_it;
-    typedef captureMapType::const_iterator const_cmap_it;
+    /*! \brief The entries of the capture map, holding the ID of the
+        partner particle and the state of the pair.
+    */
+    typedef std::pair<size_t, int> captureEntry;
+    typedef CaptureMap<captureEntry> captureMapType;
+
+    //! \brief A pointer to an entry of the capture map, or NULL.
+    typedef captureEntry* cmap_it;
+    typedef const captureEntry* const_cmap_it;
 
     mutable captureMapType captureMap;
 
@@ -202,17 +197,18 @@ namespace dynamo {
 
     void outputCaptureMap(magnet::xml::XmlStream&) const;
 
+    //! \brief Returns the capture map entry of a pair, or NULL if it is not captured.
     inline cmap_it getCMap_it(const Particle& p1, const Particle& p2) const
-    { return captureMap.find(cMapKey(p1.getID(), p2.getID())); }
+    { return captureMap.find(p1.getID(), p2.getID()); }
 
     inline void addToCaptureMap(const Particle& p1, const Particle& p2) const
     {
 #ifdef DYNAMO_DEBUG
-      if (captureMap.find(cMapKey(p1.getID(), p2.getID())) != captureMap.end())
+      if (captureMap.count(p1.getID(), p2.getID()))
 	M_throw() << "Adding a particle while its already added!";
 #endif
     
-      captureMap[cMapKey(p1.getID(), p2.getID())] = 1;
+      captureMap.insert(p1.getID(), p2.getID()).second = 1;
     }
 
     //! \brief Add a pair of particles to the capture map
@@ -223,10 +219,10 @@ namespace dynamo {
     inline void delFromCaptureMap(const Particle& p1, const Particle& p2) const
     {
 #ifdef DYNAMO_DEBUG
-      if (captureMap.find(cMapKey(p1.getID(), p2.getID())) == captureMap.end())
+      if (!captureMap.count(p1.getID(), p2.getID()))
 	M_throw() << "Deleting a particle while its already gone!";
 #endif 
-      captureMap.erase(cMapKey(p1.getID(), p2.getID()));
+      captureMap.erase(p1.getID(), p2.getID());
     }
   };
 }
@@ -307,9 +307,7 @@ namespace dynamo {
     
     Sim->ptrScheduler->fullUpdate(p1, p2);
     
-    BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, 
-		  Sim->outputPlugins)
-      Ptr->eventUpdate(iEvent, retval);
+    Sim->signalEvent(iEvent, retval);
   }
    
   void 
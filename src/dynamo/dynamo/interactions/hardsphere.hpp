@@ -63,6 +63,8 @@ namespace dynamo {
 
     virtual bool validateState(const Particle& p1, const Particle& p2, bool textoutput = true) const;
 
+    const shared_ptr<Property>& getDiameter() const { return _diameter; }
+
   protected:
     shared_ptr<Property> _diameter;
     shared_ptr<Property> _e;
@@ -155,8 +155,7 @@ namespace dynamo {
 	  Sim->signalParticleUpdate(retVal);
 	  Sim->ptrScheduler->fullUpdate(p1, p2);
 	
-	  BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, Sim->outputPlugins)
-	    Ptr->eventUpdate(iEvent, retVal);
+	  Sim->signalEvent(iEvent, retVal);
 
 
 	  break;
@@ -173,9 +172,7 @@ namespace dynamo {
 	  //Now we're past the event, update the scheduler and plugins
 	  Sim->ptrScheduler->fullUpdate(p1, p2);
 	
-	  BOOST_FOREACH(shared_ptr<OutputPlugin>& Ptr, 
-			Sim->outputPlugins)
-	    Ptr->eventUpdate(iEvent, retVal);
+	  Sim->signalEvent(iEvent, retVal);
 
 	  break;
 	}
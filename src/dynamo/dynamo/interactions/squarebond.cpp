@@ -136,9 +136,9 @@ namespace dynamo {
   ISquareBond::validateState(bool textoutput, size_t max_reports) const
   {
     size_t retval(0);
-    for (std::vector<Particle>::const_iterator iPtr = Sim->particles.begin();
+    for (ParticleContainer::const_iterator iPtr = Sim->particles.begin();
 	 iPtr != Sim->particles.end(); ++iPtr)
-      for (std::vector<Particle>::const_iterator jPtr = iPtr + 1;
+      for (ParticleContainer::const_iterator jPtr = iPtr + 1;
 	   jPtr != Sim->particles.end(); ++jPtr)
 	{
 	  const Particle& p1 = *iPtr;
@@ -210,8 +210,7 @@ namespace dynamo {
     //Now we're past the event, update the scheduler and plugins
     Sim->ptrScheduler->fullUpdate(p1, p2);
   
-    BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, Sim->outputPlugins)
-      Ptr->eventUpdate(iEvent,EDat);
+    Sim->signalEvent(iEvent,EDat);
   }
     
   void 
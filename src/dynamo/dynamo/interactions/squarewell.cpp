@@ -195,8 +195,7 @@ namespace dynamo {
 	
 	  Sim->ptrScheduler->fullUpdate(p1, p2);
 	
-	  BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, Sim->outputPlugins)
-	    Ptr->eventUpdate(iEvent, retVal);
+	  Sim->signalEvent(iEvent, retVal);
 
 	  break;
 	}
@@ -210,8 +209,7 @@ namespace dynamo {
 	  Sim->ptrScheduler->fullUpdate(p1, p2);
 	  Sim->signalParticleUpdate(retVal);
 	
-	  BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, Sim->outputPlugins)
-	    Ptr->eventUpdate(iEvent, retVal);
+	  Sim->signalEvent(iEvent, retVal);
 
 
 	  break;
@@ -227,8 +225,7 @@ namespace dynamo {
 
 	  Sim->ptrScheduler->fullUpdate(p1, p2);
 	
-	  BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, Sim->outputPlugins)
-	    Ptr->eventUpdate(iEvent, retVal);
+	  Sim->signalEvent(iEvent, retVal);
 	  break;
 	}
       default:
@@ -69,6 +69,10 @@ namespace dynamo {
  
     virtual double getInternalEnergy(const Particle&, const Particle&) const;
 
+    const shared_ptr<Property>& getDiameter() const { return _diameter; }
+
+    const shared_ptr<Property>& getLambda() const { return _lambda; }
+
   protected:
     ISquareWell(dynamo::Simulation* tmp, IDPairRange* nR):
       ISingleCapture(tmp,nR) {}
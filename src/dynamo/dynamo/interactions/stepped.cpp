@@ -124,10 +124,7 @@ namespace dynamo {
     ID = nID;
     IMultiCapture::initCaptureMap();
   
-    dout << "Buckets in captureMap " << captureMap.bucket_count()
-	 << "\nMax bucket count " << captureMap.max_bucket_count()
-	 << "\nload Factor " << captureMap.load_factor()
-	 << "\nMax load Factor " << captureMap.max_load_factor() << std::endl;
+    dout << "Captured pairs " << captureMap.size() << std::endl;
   }
 
   int 
@@ -160,7 +157,7 @@ namespace dynamo {
     //Once the capture maps are loaded just iterate through that determining energies
     double Energy = 0.0;
 
-    typedef std::pair<const std::pair<size_t, size_t>, int> locpair;
+    typedef captureMapType::value_type locpair;
 
     BOOST_FOREACH(const locpair& IDs, captureMap)
       Energy += steps[IDs.second - 1].second 
@@ -174,7 +171,7 @@ namespace dynamo {
   IStepped::getInternalEnergy(const Particle& p1, const Particle& p2) const
   {
     const_cmap_it capstat = getCMap_it(p1,p2);
-    if (capstat == captureMap.end())
+    if (!capstat)
       return 0;
     else
       return steps[capstat->second - 1].second
@@ -203,7 +200,7 @@ namespace dynamo {
 
     IntEvent retval(p1, p2, HUGE_VAL, NONE, *this);
 
-    if (capstat == captureMap.end())
+    if (!capstat)
       {
 	double d = steps.front().first * _unitLength->getMaxValue();
 	double dt 
@@ -262,27 +259,21 @@ namespace dynamo {
 	  if (retVal.getType() != BOUNCE)
 	    if (!(--capstat->second))
 	      //capstat is zero so delete
-	      captureMap.erase(capstat);
+	      captureMap.erase(p1.getID(), p2.getID());
 
 	  Sim->signalParticleUpdate(retVal);
 
 	  Sim->ptrScheduler->fullUpdate(p1, p2);
 	
-	  BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, Sim->outputPlugins)
-	    Ptr->eventUpdate(iEvent, retVal);
+	  Sim->signalEvent(iEvent, retVal);
 	  break;
 	}
       case STEP_IN:
 	{
 	  cmap_it capstat = getCMap_it(p1, p2);
 	
-	  if (capstat == captureMap.end())
-	    capstat = captureMap.insert
-	      (captureMapType::value_type
-	       ((p1.getID() < p2.getID())
-		? cMapKey(p1.getID(), p2.getID())
-		: cMapKey(p2.getID(), p1.getID()),
-		0)).first;
+	  if (!capstat)
+	    capstat = &captureMap.insert(p1.getID(), p2.getID());
 	
 	  double d = steps[capstat->second].first * _unitLength->getMaxValue();
 	  double d2 = d * d;
@@ -297,14 +288,13 @@ namespace dynamo {
 	  if (retVal.getType() != BOUNCE)
 	    ++(capstat->second);
 	  else if (!capstat->second)
-	    captureMap.erase(capstat);
+	    captureMap.erase(p1.getID(), p2.getID());
 	
 	  Sim->signalParticleUpdate(retVal);
 	
 	  Sim->ptrScheduler->fullUpdate(p1, p2);
 	
-	  BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, Sim->outputPlugins)
-	    Ptr->eventUpdate(iEvent, retVal);
+	  Sim->signalEvent(iEvent, retVal);
 	    
 	  break;
 	}
@@ -319,7 +309,7 @@ namespace dynamo {
     const_cmap_it capstat = getCMap_it(p1, p2);
     int val = captureTest(p1, p2);
 
-    if (capstat == captureMap.end())
+    if (!capstat)
       {
 	if (val != 0)
 	  {
@@ -41,6 +41,25 @@ namespace dynamo {
     return range->isInRange(p1);
   }
 
+  std::pair<Vector, Vector>
+  Local::getPlaneBounds(const Vector& position, const Vector& normal, double distance)
+  {
+    std::pair<Vector, Vector> bounds(Vector(-HUGE_VAL, -HUGE_VAL, -HUGE_VAL), 
+				     Vector(HUGE_VAL, HUGE_VAL, HUGE_VAL));
+
+    size_t axis(NDIM), nonzero(0);
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      if (normal[iDim] != 0) { axis = iDim; ++nonzero; }
+
+    if (nonzero == 1)
+      {
+	bounds.first[axis] = position[axis] - distance;
+	bounds.second[axis] = position[axis] + distance;
+      }
+
+    return bounds;
+  }
+
   magnet::xml::XmlStream& operator<<(magnet::xml::XmlStream& XML, 
 				     const Local& g)
   {
@@ -21,6 +21,8 @@
 #include <dynamo/ranges/IDRange.hpp>
 #include <magnet/math/vector.hpp>
 #include <string>
+#include <utility>
+#include <cmath>
 
 namespace magnet { namespace xml { class Node; } }
 namespace xml { class XmlStream; }
@@ -35,8 +37,8 @@ namespace dynamo {
    * events, which are localized in space, to be inserted into a
    * neighbor list for efficiency.
    *
-   * To do this, the Local class provides the isInCell method, used by a
-   * GNeighbourList to check if this Local is in a certain cell.
+   * To do this, the Local class provides the getBounds method, used by
+   * a GNeighbourList to find the cells this Local is in.
    */
   class Local: public dynamo::SimBase
   {
@@ -49,9 +51,34 @@ namespace dynamo {
 
     bool isInteraction(const Particle&) const;
 
+    //! Returns the range of particles this Local applies to.
+    const shared_ptr<IDRange>& getRange() const { return range; }
+
     virtual LocalEvent getEvent(const Particle&) const = 0;
 
     virtual void runEvent(Particle&, const LocalEvent&) const = 0;
+
+    /*! \brief Tests if the event times of this Local are only scaled
+        when every velocity is scaled (see
+        Dynamics::eventTimesScaleWithVelocity).
+
+      This is false for Locals which move by themselves.
+     */
+    virtual bool eventTimesScaleWithVelocity() const { return true; }
+
+    /*! \brief Returns the lower and upper corners of an axis aligned
+        box, outside of which a particle cannot have an event with this
+        Local.
+
+      The box may be infinite in any dimension, and in periodic
+      systems every image of the box is used. The box is empty if the
+      lower corner is above the upper corner. The default is an
+      infinite box, so the Local is tested against every particle.
+      The box is for the unscaled contact distances, so it is not used
+      while DynCompression grows them.
+     */
+    virtual std::pair<Vector, Vector> getBounds() const
+    { return std::make_pair(Vector(-HUGE_VAL, -HUGE_VAL, -HUGE_VAL), Vector(HUGE_VAL, HUGE_VAL, HUGE_VAL)); }
   
     virtual void initialise(size_t nID)  { ID = nID; }
 
@@ -79,6 +106,13 @@ namespace dynamo {
   protected:
     virtual void outputXML(magnet::xml::XmlStream&) const = 0;
 
+    /*! \brief The bounds of the region within a distance of a plane.
+
+      This is only finite if the normal of the plane lies along an
+      axis, as otherwise the plane spans the system.
+     */
+    static std::pair<Vector, Vector> getPlaneBounds(const Vector& position, const Vector& normal, double distance);
+
     shared_ptr<IDRange> range;  
     std::string localName;
     size_t ID;
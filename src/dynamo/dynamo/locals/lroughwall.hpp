@@ -31,6 +31,9 @@ namespace dynamo {
     virtual LocalEvent getEvent(const Particle&) const;
 
     virtual void runEvent(Particle&, const LocalEvent&) const;
+
+    virtual std::pair<Vector, Vector> getBounds() const
+    { return getPlaneBounds(vPosition, vNorm, r); }
   
     virtual void operator<<(const magnet::xml::Node&);
 
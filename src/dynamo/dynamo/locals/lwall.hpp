@@ -45,6 +45,9 @@ namespace dynamo {
     virtual LocalEvent getEvent(const Particle&) const;
 
     virtual void runEvent(Particle&, const LocalEvent&) const;
+
+    virtual std::pair<Vector, Vector> getBounds() const
+    { return getPlaneBounds(vPosition, vNorm, 0.5 * _diameter->getMaxValue()); }
   
     virtual void operator<<(const magnet::xml::Node&);
 
@@ -93,8 +93,7 @@ namespace dynamo {
     //else
     Sim->ptrScheduler->rebuildList();
 
-    BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, Sim->outputPlugins)
-      Ptr->eventUpdate(iEvent, EDat);
+    Sim->signalEvent(iEvent, EDat);
   }
 
   void 
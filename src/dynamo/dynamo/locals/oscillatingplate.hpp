@@ -37,6 +37,9 @@ namespace dynamo {
     virtual LocalEvent getEvent(const Particle&) const;
 
     virtual void runEvent(Particle&, const LocalEvent&) const;
+
+    //! The plate oscillates at a fixed frequency
+    virtual bool eventTimesScaleWithVelocity() const { return false; }
   
     virtual void operator<<(const magnet::xml::Node&);
 
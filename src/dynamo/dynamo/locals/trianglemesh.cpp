@@ -17,6 +17,8 @@
 
 #include <dynamo/locals/trianglemesh.hpp>
 #include <dynamo/BC/BC.hpp>
+#include <dynamo/BC/None.hpp>
+#include <dynamo/BC/PBC.hpp>
 #include <dynamo/dynamics/dynamics.hpp>
 #include <dynamo/locals/localEvent.hpp>
 #include <dynamo/NparticleEventData.hpp>
@@ -30,6 +32,204 @@ namespace dynamo {
     Local(tmp, "LocalWall")
   { operator<<(XML); }
 
+  void
+  LTriangleMesh::initialise(size_t nID)
+  {
+    Local::initialise(nID);
+    buildTriangleGrid();
+  }
+
+  std::pair<Vector, Vector>
+  LTriangleMesh::getBounds() const
+  {
+    const double radius = 0.5 * _diameter->getMaxValue();
+    std::pair<Vector, Vector> bounds(Vector(HUGE_VAL, HUGE_VAL, HUGE_VAL),
+				     Vector(-HUGE_VAL, -HUGE_VAL, -HUGE_VAL));
+
+    BOOST_FOREACH(const Vector& vertex, _vertices)
+      for (size_t iDim(0); iDim < NDIM; ++iDim)
+	{
+	  bounds.first[iDim] = std::min(bounds.first[iDim], vertex[iDim] - radius);
+	  bounds.second[iDim] = std::max(bounds.second[iDim], vertex[iDim] + radius);
+	}
+
+    return bounds;
+  }
+
+  void
+  LTriangleMesh::buildTriangleGrid()
+  {
+    _cellStart.clear();
+    _cellTriangles.clear();
+
+    if (_elements.empty()) return;
+
+    _periodicGrid = std::tr1::dynamic_pointer_cast<BCPeriodic>(Sim->BCs)
+      && !std::tr1::dynamic_pointer_cast<BCPeriodicExceptX>(Sim->BCs)
+      && !std::tr1::dynamic_pointer_cast<BCPeriodicXOnly>(Sim->BCs);
+
+    //Other boundary conditions (e.g., sliding images) fall back to
+    //testing every triangle
+    if (!_periodicGrid && !std::tr1::dynamic_pointer_cast<BCNone>(Sim->BCs))
+      return;
+
+    _gridRadius = 0.5 * _diameter->getMaxValue();
+
+    //Each triangle is stored through its bounding box, with the
+    //image of the first vertex nearest the origin (as used in the
+    //event detection).
+    std::vector<std::pair<Vector, Vector> > bounds;
+    bounds.reserve(_elements.size());
+    double meanSize(0);
+    BOOST_FOREACH(const TriangleElements& elem, _elements)
+      {
+	Vector shift(_vertices[elem.get<0>()]);
+	if (_periodicGrid) Sim->BCs->applyBC(shift);
+	shift -= _vertices[elem.get<0>()];
+
+	Vector lower(_vertices[elem.get<0>()] + shift), upper(lower);
+	for (size_t iDim(0); iDim < NDIM; ++iDim)
+	  {
+	    lower[iDim] = std::min(lower[iDim], std::min(_vertices[elem.get<1>()][iDim], _vertices[elem.get<2>()][iDim]) + shift[iDim]);
+	    upper[iDim] = std::max(upper[iDim], std::max(_vertices[elem.get<1>()][iDim], _vertices[elem.get<2>()][iDim]) + shift[iDim]);
+	  }
+
+	meanSize += Vector(upper - lower).maxElement();
+	bounds.push_back(std::make_pair(lower - Vector(_gridRadius, _gridRadius, _gridRadius),
+					upper + Vector(_gridRadius, _gridRadius, _gridRadius)));
+      }
+    meanSize /= _elements.size();
+
+    Vector gridWidth;
+    if (_periodicGrid)
+      {
+	_gridOrigin = -0.5 * Sim->primaryCellSize;
+	gridWidth = Sim->primaryCellSize;
+      }
+    else
+      {
+	_gridOrigin = bounds.front().first;
+	Vector upper = bounds.front().second;
+	for (size_t id(1); id < bounds.size(); ++id)
+	  for (size_t iDim(0); iDim < NDIM; ++iDim)
+	    {
+	      _gridOrigin[iDim] = std::min(_gridOrigin[iDim], bounds[id].first[iDim]);
+	      upper[iDim] = std::max(upper[iDim], bounds[id].second[iDim]);
+	    }
+	gridWidth = upper - _gridOrigin;
+      }
+
+    //The cells are made about the size of a triangle (or a particle),
+    //but the total number of cells is kept comparable to the number
+    //of triangles.
+    double targetWidth = std::max(meanSize, 2 * _gridRadius);
+    const double maxCells = std::max(size_t(64), 4 * _elements.size());
+    size_t totalCells;
+    for (;;)
+      {
+	totalCells = 1;
+	for (size_t iDim(0); iDim < NDIM; ++iDim)
+	  {
+	    _cellCount[iDim] = _periodicGrid 
+	      ? size_t(gridWidth[iDim] / targetWidth)
+	      : std::max(size_t(1), size_t(std::ceil(gridWidth[iDim] / targetWidth)));
+	    totalCells *= std::max(_cellCount[iDim], size_t(1));
+	  }
+
+	if (totalCells <= maxCells) break;
+	targetWidth *= std::pow(totalCells / maxCells, 1.0 / 3.0) * 1.01;
+      }
+
+    //Periodic cells must be at most a third of the box, so the cell
+    //boundaries map uniquely through the boundary conditions.
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      if (_cellCount[iDim] < (_periodicGrid ? 3 : 1))
+	{
+	  dout << "The triangle mesh is too large for the primary image to be gridded, all triangles will be tested" << std::endl;
+	  return;
+	}
+
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      _cellWidth[iDim] = gridWidth[iDim] / _cellCount[iDim];
+
+    //Build the cell contents in a compressed row layout, first
+    //counting then filling the cells.
+    _cellStart.resize(totalCells + 1, 0);
+    for (size_t pass(0); pass < 2; ++pass)
+      {
+	std::vector<size_t> fill;
+	if (pass)
+	  {
+	    for (size_t id(0); id < totalCells; ++id)
+	      _cellStart[id + 1] += _cellStart[id];
+	    _cellTriangles.resize(_cellStart.back());
+	    fill.assign(_cellStart.begin(), _cellStart.end() - 1);
+	  }
+
+	for (size_t id(0); id < bounds.size(); ++id)
+	  {
+	    //Periodic images of the triangle must also be stored
+	    const int images = _periodicGrid ? 1 : 0;
+	    for (int ix(-images); ix <= images; ++ix)
+	      for (int iy(-images); iy <= images; ++iy)
+		for (int iz(-images); iz <= images; ++iz)
+		  {
+		    const Vector shift(ix * Sim->primaryCellSize[0], 
+				       iy * Sim->primaryCellSize[1], 
+				       iz * Sim->primaryCellSize[2]);
+		    
+		    int start[NDIM], end[NDIM];
+		    bool inside(true);
+		    for (size_t iDim(0); iDim < NDIM; ++iDim)
+		      {
+			start[iDim] = std::max(0, int(std::floor((bounds[id].first[iDim] + shift[iDim] - _gridOrigin[iDim]) / _cellWidth[iDim])));
+			end[iDim] = std::min(int(_cellCount[iDim]) - 1, int(std::floor((bounds[id].second[iDim] + shift[iDim] - _gridOrigin[iDim]) / _cellWidth[iDim])));
+			inside &= (start[iDim] <= end[iDim]);
+		      }
+
+		    if (!inside) continue;
+
+		    for (int x(start[0]); x <= end[0]; ++x)
+		      for (int y(start[1]); y <= end[1]; ++y)
+			for (int z(start[2]); z <= end[2]; ++z)
+			  {
+			    const size_t cell = x + _cellCount[0] * (y + _cellCount[1] * z);
+			    if (pass)
+			      _cellTriangles[fill[cell]++] = id;
+			    else
+			      ++_cellStart[cell + 1];
+			  }
+		  }
+	  }
+      }
+
+    dout << "Triangle mesh " << localName << " gridded into " 
+	 << _cellCount[0] << "x" << _cellCount[1] << "x" << _cellCount[2] 
+	 << " cells, with an average of " << double(_cellTriangles.size()) / totalCells 
+	 << " triangles per cell" << std::endl;
+  }
+
+  std::pair<double, size_t>
+  LTriangleMesh::getTriangleEvent(const Particle& part, double radius,
+				  const size_t* begin, const size_t* end) const
+  {
+    size_t triangleid = 0; //The id of the triangle for which the event is for
+    std::pair<double, size_t> tmin(HUGE_VAL, 0); //Default to no collision
+
+    for (const size_t* it = begin; it != end; ++it)
+      {
+	const size_t id = *it;
+	std::pair<double, size_t> t = Sim->dynamics->getSphereTriangleEvent(part,
+				  _vertices[_elements[id].get<0>()],
+				  _vertices[_elements[id].get<1>()],
+				  _vertices[_elements[id].get<2>()],
+				  radius);
+	if (t < tmin) { tmin = t; triangleid = id; }
+      }
+
+    return std::make_pair(tmin.first, Dynamics::T_COUNT * triangleid + tmin.second);
+  }
+
   LocalEvent 
   LTriangleMesh::getEvent(const Particle& part) const
   {
@@ -38,9 +238,71 @@ namespace dynamo {
       M_throw() << "Particle is not up to date";
 #endif
 
-    size_t triangleid = 0; //The id of the triangle for which the event is for
     double diam = 0.5 * _diameter->getProperty(part.getID());
 
+    if (!_cellStart.empty() && (diam <= _gridRadius))
+      {
+	//Find the cell of the particle, taking care to place particles
+	//on a cell boundary in the cell they are moving into.
+	Vector pos(part.getPosition());
+	Sim->BCs->applyBC(pos);
+	pos -= _gridOrigin;
+
+	int coords[NDIM];
+	bool inside(true);
+	for (size_t iDim(0); iDim < NDIM; ++iDim)
+	  {
+	    const double x = pos[iDim] / _cellWidth[iDim];
+	    coords[iDim] = int(std::floor(x));
+	    const double frac = x - coords[iDim];
+	    if ((frac < 1e-10) && (part.getVelocity()[iDim] < 0)) --coords[iDim];
+	    if ((frac > 1 - 1e-10) && (part.getVelocity()[iDim] > 0)) ++coords[iDim];
+	  }
+
+	Vector origin;
+	double tcell(0);
+	//A particle exactly leaving a cell is moved into the next
+	//cell (at most once per dimension).
+	for (size_t attempt(0); attempt <= NDIM; ++attempt)
+	  {
+	    for (size_t iDim(0); iDim < NDIM; ++iDim)
+	      {
+		if (_periodicGrid)
+		  coords[iDim] = (coords[iDim] + int(_cellCount[iDim])) % int(_cellCount[iDim]);
+		else 
+		  inside &= (coords[iDim] >= 0) && (coords[iDim] < int(_cellCount[iDim]));
+
+		origin[iDim] = _gridOrigin[iDim] + coords[iDim] * _cellWidth[iDim];
+	      }
+
+	    if (!inside) break;
+	    
+	    tcell = Sim->dynamics->getSquareCellCollision2(part, origin, _cellWidth);
+	    if (tcell > 0) break;
+
+	    const int dir = Sim->dynamics->getSquareCellCollision3(part, origin, _cellWidth);
+	    coords[std::abs(dir) - 1] += (dir > 0) ? 1 : -1;
+	  }
+
+	//Particles outside the grid may reach any triangle
+	if (inside)
+	  {
+	    const size_t cell = coords[0] + _cellCount[0] * (coords[1] + _cellCount[1] * coords[2]);
+	    const size_t* begin = (_cellTriangles.empty() ? NULL : &_cellTriangles[0]);
+
+	    std::pair<double, size_t> tmin
+	      = getTriangleEvent(part, diam, begin + _cellStart[cell], begin + _cellStart[cell + 1]);
+
+	    //If the particle leaves the cell first, the triangles are
+	    //retested then.
+	    if ((tmin.first > tcell) && (tcell != HUGE_VAL))
+	      return LocalEvent(part, tcell, CELL, *this);
+
+	    return LocalEvent(part, tmin.first, WALL, *this, tmin.second);
+	  }
+      }
+
+    size_t triangleid = 0; //The id of the triangle for which the event is for
     std::pair<double, size_t> tmin(HUGE_VAL, 0); //Default to no collision
 
     for (size_t id(0); id < _elements.size(); ++id)
@@ -53,12 +315,22 @@ namespace dynamo {
 	if (t < tmin) { tmin = t; triangleid = id; }
       }
 
-    return LocalEvent(part, tmin.first, WALL, *this, 8 * triangleid + tmin.second);
+    return LocalEvent(part, tmin.first, WALL, *this, Dynamics::T_COUNT * triangleid + tmin.second);
   }
 
   void
   LTriangleMesh::runEvent(Particle& part, const LocalEvent& iEvent) const
   { 
+    if (iEvent.getType() == CELL)
+      {
+	//The particle has left its cell of the triangle grid, so the
+	//next event with the mesh is found from its new cell
+	Sim->dynamics->updateParticle(part);
+	Sim->ptrScheduler->pushEvent(part, getEvent(part));
+	Sim->ptrScheduler->sort(part);
+	return;
+      }
+
     ++Sim->eventCount;
   
     const size_t triangleID = iEvent.getExtraData() / Dynamics::T_COUNT;
@@ -145,8 +417,7 @@ namespace dynamo {
     //Now we're past the event update the scheduler and plugins
     Sim->ptrScheduler->fullUpdate(part);
   
-    BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, Sim->outputPlugins)
-      Ptr->eventUpdate(iEvent, EDat);
+    Sim->signalEvent(iEvent, EDat);
   }
 
   void 
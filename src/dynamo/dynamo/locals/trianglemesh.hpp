@@ -43,9 +43,13 @@ namespace dynamo {
 
     virtual ~LTriangleMesh() {}
 
+    virtual void initialise(size_t nID);
+
     virtual LocalEvent getEvent(const Particle&) const;
 
     virtual void runEvent(Particle&, const LocalEvent&) const;
+
+    virtual std::pair<Vector, Vector> getBounds() const;
   
     virtual void operator<<(const magnet::xml::Node&);
 
@@ -63,11 +67,39 @@ namespace dynamo {
 
     virtual void outputXML(magnet::xml::XmlStream&) const;
 
+    /*! \brief Builds the uniform grid of triangles used to
+      accelerate the event detection.
+
+      Each cell of the grid stores (in a compressed row layout) the
+      triangles whose bounding box, enlarged by the largest particle
+      radius, overlaps the cell. The grid spans the bounding box of
+      the mesh for unbounded systems, or the primary image for
+      periodic systems (where the triangle images are also stored).
+     */
+    void buildTriangleGrid();
+
+    /*! \brief Tests for the earliest event between a particle and a
+      range of triangles.
+     */
+    std::pair<double, size_t> getTriangleEvent(const Particle&, double radius,
+					       const size_t* begin,
+					       const size_t* end) const;
+
     std::vector<Vector> _vertices;
 
     typedef boost::tuples::tuple<size_t, size_t, size_t> TriangleElements;
     std::vector<TriangleElements> _elements;
 
+    //The uniform grid of triangles, this is empty if the grid is
+    //not used
+    std::vector<size_t> _cellStart;
+    std::vector<size_t> _cellTriangles;
+    size_t _cellCount[NDIM];
+    Vector _cellWidth;
+    Vector _gridOrigin;
+    double _gridRadius;
+    bool _periodicGrid;
+
     shared_ptr<Property> _e;
     shared_ptr<Property> _diameter;
   };
@@ -21,18 +21,22 @@
 #include <dynamo/interactions/include.hpp>
 #include <boost/foreach.hpp>
 #include <magnet/xmlwriter.hpp>
+#include <algorithm>
+#include <limits>
 
 namespace dynamo {
   OPCollMatrix::OPCollMatrix(const dynamo::Simulation* tmp, const magnet::xml::Node&):
     OutputPlugin(tmp,"CollisionMatrix"),
-    totalCount(0)
+    totalCount(0),
+    _stride(0)
   {
   }
 
   void 
   OPCollMatrix::initialise()
   {
-    lastEvent.resize(Sim->N, lastEventData(Sim->systemTime, eventKey(classKey(0, NONE), NONE)));
+    _eventIndex.initialise(Sim);
+    lastEvent.resize(Sim->N, lastEventData(Sim->systemTime, std::numeric_limits<size_t>::max()));
   }
 
   OPCollMatrix::~OPCollMatrix()
@@ -103,19 +107,50 @@ namespace dynamo {
   void 
   OPCollMatrix::newEvent(const size_t& part, const EEventType& etype, const classKey& ck)
   {
-    if (lastEvent[part].second.first.second != NONE)
+    const size_t index = _eventIndex(ck, etype);
+    if (index >= _stride)
+      resizeCounters(index + 1);
+
+    if (lastEvent[part].second != std::numeric_limits<size_t>::max())
       {
-	counterData& refCount = counters[counterKey(eventKey(ck,etype), lastEvent[part].second)];
+	counterData& refCount = counters[index * _stride + lastEvent[part].second];
       
 	refCount.totalTime += Sim->systemTime - lastEvent[part].first;
 	++(refCount.count);
 	++(totalCount);
       }
     else
-      ++initialCounter[eventKey(ck,etype)];
+      ++initialCounter[index];
 
     lastEvent[part].first = Sim->systemTime;
-    lastEvent[part].second = eventKey(ck, etype);
+    lastEvent[part].second = index;
+  }
+
+  void
+  OPCollMatrix::reorderParticles(const std::vector<size_t>& order)
+  {
+    std::vector<lastEventData> newLastEvent;
+    newLastEvent.reserve(order.size());
+    for (std::vector<size_t>::const_iterator it = order.begin(); it != order.end(); ++it)
+      newLastEvent.push_back(lastEvent[*it]);
+    lastEvent.swap(newLastEvent);
+  }
+
+  void
+  OPCollMatrix::resizeCounters(size_t minStride)
+  {
+    size_t stride = std::max(_stride, size_t(8));
+    while (stride < minStride)
+      stride *= 2;
+
+    std::vector<counterData> newCounters(stride * stride);
+    for (size_t i(0); i < _stride; ++i)
+      std::copy(counters.begin() + i * _stride, counters.begin() + (i + 1) * _stride,
+		newCounters.begin() + i * stride);
+
+    counters.swap(newCounters);
+    initialCounter.resize(stride, 0);
+    _stride = stride;
   }
 
   void
@@ -126,6 +161,19 @@ namespace dynamo {
 	<< magnet::xml::tag("TransitionMatrix");
   
     std::map<eventKey, std::pair<size_t, double> > totmap;
+
+    //The counters are written in the order of their keys
+    std::map<counterKey, counterData> counterMap;
+    std::map<eventKey, size_t> initialMap;
+    for (size_t i(0); i < _eventIndex.size(); ++i)
+      {
+	if (initialCounter[i])
+	  initialMap[_eventIndex[i]] = initialCounter[i];
+
+	for (size_t j(0); j < _eventIndex.size(); ++j)
+	  if (counters[i * _stride + j].count)
+	    counterMap[counterKey(_eventIndex[i], _eventIndex[j])] = counters[i * _stride + j];
+      }
   
     typedef std::pair<const counterKey, counterData> locPair;
   
@@ -133,10 +181,10 @@ namespace dynamo {
     size_t initialsum(0);
   
     typedef std::pair<eventKey,size_t> npair;
-    BOOST_FOREACH(const npair& n, initialCounter)
+    BOOST_FOREACH(const npair& n, initialMap)
       initialsum += n.second;
   
-    BOOST_FOREACH(const locPair& ele, counters)
+    BOOST_FOREACH(const locPair& ele, counterMap)
       {
 	XML << magnet::xml::tag("Count")
 	    << magnet::xml::attr("Event") << ele.first.first.second
@@ -168,11 +216,11 @@ namespace dynamo {
 	  << magnet::xml::attr("Event") << mp1.first.second
 	  << magnet::xml::attr("Percent") 
 	  << 100.0 * (((double) mp1.second.first)
-		      +((double) initialCounter[mp1.first]))
+		      +((double) initialMap[mp1.first]))
       / (((double) totalCount) + ((double) initialsum))
-	  << magnet::xml::attr("Count") << mp1.second.first + initialCounter[mp1.first]
+	  << magnet::xml::attr("Count") << mp1.second.first + initialMap[mp1.first]
 	  << magnet::xml::attr("EventMeanFreeTime")
-	  << Sim->systemTime / ((mp1.second.first + initialCounter[mp1.first])
+	  << Sim->systemTime / ((mp1.second.first + initialMap[mp1.first])
 			      * Sim->units.unitTime())
 	  << magnet::xml::endtag("TotCount");
   
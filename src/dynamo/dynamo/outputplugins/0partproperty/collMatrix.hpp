@@ -49,9 +49,18 @@ namespace dynamo {
 
     //This is fine to replica exchange as the interaction, global and system lookups are done using names
     virtual void changeSystem(OutputPlugin* plug) { std::swap(Sim, static_cast<OPCollMatrix*>(plug)->Sim); }
+
+    virtual bool canReorderParticles() const { return true; }
+
+    virtual void reorderParticles(const std::vector<size_t>&);
   
   protected:
     void newEvent(const size_t&, const EEventType&, const classKey&);
+
+    /*! \brief Grows the rows of the counters to hold at least the
+      passed number of event indices.
+     */
+    void resizeCounters(size_t);
   
     struct counterData
     {
@@ -63,15 +72,26 @@ namespace dynamo {
   
     unsigned long totalCount;
 
-    typedef std::pair<classKey, EEventType> eventKey;
-
     typedef std::pair<eventKey, eventKey> counterKey;
+
+    EventKeyIndex _eventIndex;
+
+    /*! \brief The counters of each pair of events, indexed by
+      _eventIndex.
+
+      The counter of the event i following the event j is stored at
+      counters[i * _stride + j].
+     */
+    std::vector<counterData> counters;
+
+    //! \brief The length of each row of counters.
+    size_t _stride;
   
-    std::map<counterKey, counterData> counters;
-  
-    std::map<eventKey, size_t> initialCounter;
+    //! \brief The count of each first event of a particle, indexed by _eventIndex.
+    std::vector<size_t> initialCounter;
 
-    typedef std::pair<double, eventKey> lastEventData;
+    //! \brief The time and event index of the last event of a particle.
+    typedef std::pair<double, size_t> lastEventData;
 
     std::vector<lastEventData> lastEvent; 
   };
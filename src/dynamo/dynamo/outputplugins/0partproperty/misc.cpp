@@ -84,6 +84,8 @@ namespace dynamo {
   void
   OPMisc::initialise()
   {
+    _eventIndex.initialise(Sim);
+
     _KE.init(Sim->dynamics->getSystemKineticEnergy());
     _internalE.init(Sim->calcInternalEnergy());
 
@@ -376,7 +378,10 @@ namespace dynamo {
   void
   OPMisc::newEvent(const size_t& part, const EEventType& etype, const classKey& ck)
   {
-    ++_counters[EventKey(ck, etype)];
+    const size_t index = _eventIndex(ck, etype);
+    if (index >= _counters.size())
+      _counters.resize(index + 1, 0);
+    ++_counters[index];
   }
 
   void
@@ -492,8 +497,13 @@ namespace dynamo {
 	<< magnet::xml::endtag("Duration")
 	<< magnet::xml::tag("EventCounters");
   
-    typedef std::pair<EventKey, size_t> mappair;
-    BOOST_FOREACH(const mappair& mp1, _counters)
+    //The counters are written in the order of their keys
+    std::map<eventKey, size_t> counters;
+    for (size_t index(0); index < _counters.size(); ++index)
+      counters[_eventIndex[index]] = _counters[index];
+
+    typedef std::pair<eventKey, size_t> mappair;
+    BOOST_FOREACH(const mappair& mp1, counters)
       XML << magnet::xml::tag("Entry")
 	  << magnet::xml::attr("Type") << getClass(mp1.first.first)
 	  << magnet::xml::attr("Name") << getName(mp1.first.first, Sim)
@@ -22,6 +22,7 @@
 #include <magnet/math/timeaveragedproperty.hpp>
 #include <magnet/math/correlators.hpp>
 #include <map>
+#include <vector>
 #include <ctime>
 
 namespace dynamo {
@@ -52,6 +53,9 @@ namespace dynamo {
   
     void changeSystem(OutputPlugin*);
 
+    //! Only per-species data is stored, not per-particle data.
+    virtual bool canReorderParticles() const { return true; }
+
     double getEventsPerSecond() const;
     double getSimTimePerSecond() const;
 
@@ -68,8 +72,9 @@ namespace dynamo {
   protected:
     void newEvent(const size_t&, const EEventType&, const classKey&);
   
-    typedef std::pair<classKey, EEventType> EventKey;
-    std::map<EventKey, size_t> _counters;
+    EventKeyIndex _eventIndex;
+    //! \brief The number of each event, indexed by _eventIndex.
+    std::vector<size_t> _counters;
 
     void stream(double dt);
     void eventUpdate(const NEventData&);
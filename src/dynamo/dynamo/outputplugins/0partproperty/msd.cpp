@@ -40,6 +40,16 @@ namespace dynamo {
       initPos[ID] = Sim->particles[ID].getPosition();
   }
 
+  void
+  OPMSD::reorderParticles(const std::vector<size_t>& order)
+  {
+    std::vector<Vector> newPos;
+    newPos.reserve(order.size());
+    for (std::vector<size_t>::const_iterator it = order.begin(); it != order.end(); ++it)
+      newPos.push_back(initPos[*it]);
+    initPos.swap(newPos);
+  }
+
   void
   OPMSD::output(magnet::xml::XmlStream &XML)
   {
@@ -41,6 +41,10 @@ namespace dynamo {
 
     void output(magnet::xml::XmlStream &); 
 
+    virtual bool canReorderParticles() const { return true; }
+
+    virtual void reorderParticles(const std::vector<size_t>&);
+
     double calcMSD(const IDRange& range) const;
 
     double calcStructMSD(const Topology&) const;
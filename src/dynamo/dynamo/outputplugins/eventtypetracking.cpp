@@ -73,5 +73,15 @@ namespace dynamo {
     {
       return classKey(g.getLocalID(), LOCAL);
     }
+
+    void EventKeyIndex::initialise(const dynamo::Simulation* Sim)
+    {
+      const size_t counts[4] = {Sim->interactions.size(), Sim->globals.size(),
+				Sim->systems.size(), Sim->locals.size()};
+
+      for (size_t i(0); i < 4; ++i)
+	if (_tables[i].size() < counts[i] * FINAL_ENUM_TO_CATCH_THE_COMMA)
+	  _tables[i].resize(counts[i] * FINAL_ENUM_TO_CATCH_THE_COMMA, std::numeric_limits<size_t>::max());
+    }
   }
 }
@@ -19,6 +19,8 @@
 #include <dynamo/eventtypes.hpp>
 #include <utility>
 #include <string>
+#include <vector>
+#include <limits>
 
 namespace dynamo
 {
@@ -45,5 +47,69 @@ namespace dynamo
     classKey getClassKey(const GlobalEvent&);
 
     classKey getClassKey(const LocalEvent&);
+
+    //! The class which caused an event and the type of the event
+    typedef std::pair<classKey, EEventType> eventKey;
+
+    /*! \brief Numbers each eventKey densely, so that event counters
+      can be stored in flat arrays.
+
+      There is a lookup table for each class of event (Interaction,
+      Global, System and Local) with an entry for every ID and event
+      type, so finding the index of a key is two array lookups. The
+      indices are handed out in the order the keys are first seen.
+     */
+    class EventKeyIndex
+    {
+    public:
+      /*! \brief Sizes the lookup tables for the Interactions,
+        Globals, Systems and Locals of a Simulation.
+
+        The indices already handed out are kept.
+       */
+      void initialise(const dynamo::Simulation*);
+
+      //! \brief Returns the index of a key, adding it if it is new.
+      inline size_t operator()(const classKey& ck, EEventType etype)
+      {
+	std::vector<size_t>& table = _tables[getTableID(ck.second)];
+	const size_t entry = ck.first * FINAL_ENUM_TO_CATCH_THE_COMMA + etype;
+
+	//Classes may be added after the tables are sized
+	if (entry >= table.size())
+	  table.resize(entry + 1, std::numeric_limits<size_t>::max());
+
+	if (table[entry] == std::numeric_limits<size_t>::max())
+	  {
+	    table[entry] = _keys.size();
+	    _keys.push_back(eventKey(ck, etype));
+	  }
+
+	return table[entry];
+      }
+
+      //! \brief The number of keys which have been indexed.
+      size_t size() const { return _keys.size(); }
+
+      //! \brief The key of an index.
+      const eventKey& operator[](size_t index) const { return _keys[index]; }
+
+    private:
+      inline static size_t getTableID(EEventType eventClass)
+      {
+	switch (eventClass)
+	  {
+	  case INTERACTION: return 0;
+	  case GLOBAL: return 1;
+	  case SYSTEM: return 2;
+	  case LOCAL: return 3;
+	  default:
+	    M_throw() << "Collision matrix found an unknown event class";
+	  }
+      }
+
+      std::vector<size_t> _tables[4];
+      std::vector<eventKey> _keys;
+    };
   }
 }
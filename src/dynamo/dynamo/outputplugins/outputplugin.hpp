@@ -17,6 +17,7 @@
 
 #pragma once
 #include <dynamo/base.hpp>
+#include <vector>
 
 namespace magnet { namespace xml { class Node; class XmlStream; } }
 
@@ -65,6 +66,23 @@ namespace dynamo {
     { M_throw() << "This plugin hasn't been prepared for changes of system\n Plugin " <<  name; }
   
     virtual void temperatureRescale(const double&) {}
+
+    /*! \brief Tests if this plugin can follow a renumbering of the
+      particles (see Simulation::reorderParticles).
+
+      Plugins default to false, as they may hold data by particle
+      ID. Plugins which return true must permute any such data in
+      \ref reorderParticles.
+     */
+    virtual bool canReorderParticles() const { return false; }
+
+    /*! \brief Called when the particles are renumbered.
+     
+      \param order The new particle ID i is the old particle ID order[i].
+     */
+    virtual void reorderParticles(const std::vector<size_t>& order) {}
+
+    const std::string& getPluginName() const { return name; }
   
   protected:
     std::ostream& I_Pcout() const;
@@ -39,6 +39,8 @@ namespace dynamo {
   
     virtual void output(magnet::xml::XmlStream&);
 
+    virtual bool canReorderParticles() const { return true; }
+
     void operator<<(const magnet::xml::Node&);
 
     virtual void periodicOutput();
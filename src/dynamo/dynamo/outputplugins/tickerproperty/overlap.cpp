@@ -19,7 +19,10 @@
 #include <dynamo/include.hpp>
 #include <dynamo/simulation.hpp>
 #include <dynamo/dynamics/dynamics.hpp>
+#include <dynamo/particlecells.hpp>
+#include <magnet/thread/workstealing.hpp>
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
 
 namespace dynamo {
   OPOverlapTest::OPOverlapTest(const dynamo::Simulation* tmp, 
@@ -42,13 +45,72 @@ namespace dynamo {
     ticker();
   }
 
+  namespace {
+    //! \brief Tests the state of a particle and each particle visited.
+    struct OverlapTester
+    {
+      const Simulation* Sim;
+      const Particle* p1;
+      std::vector<std::pair<size_t, size_t> >* invalid;
+
+      inline void operator()(size_t ID2)
+      {
+	//Each pair is only tested once
+	if (ID2 <= p1->getID()) return;
+
+	const Particle& p2 = Sim->particles[ID2];
+	if (Sim->getInteraction(*p1, p2)->validateState(*p1, p2, false))
+	  invalid->push_back(std::make_pair(p1->getID(), ID2));
+      }
+    };
+
+    //! \brief Appends the pairs of b to a, for the parallel_reduce.
+    std::vector<std::pair<size_t, size_t> >
+    joinPairs(std::vector<std::pair<size_t, size_t> > a,
+	      const std::vector<std::pair<size_t, size_t> >& b)
+    {
+      a.insert(a.end(), b.begin(), b.end());
+      return a;
+    }
+  }
+
   void 
   OPOverlapTest::ticker()
   {
-    for (std::vector<Particle>::const_iterator iPtr = Sim->particles.begin();
-	 iPtr != Sim->particles.end(); ++iPtr)
-      for (std::vector<Particle>::const_iterator jPtr = iPtr + 1;
-	   jPtr != Sim->particles.end(); ++jPtr)
-	Sim->getInteraction(*iPtr, *jPtr)->validateState(*iPtr, *jPtr);
+    BOOST_FOREACH(const shared_ptr<Interaction>& interaction, Sim->interactions)
+      interaction->validateState();
+
+    _cells.reset(new ParticleCells(Sim, Sim->getLongestInteraction()));
+
+    const size_t N = Sim->particles.size();
+    IDPairs invalid;
+    if (Sim->threadPool && Sim->threadPool->getThreadCount())
+      invalid = Sim->threadPool->parallel_reduce
+	(0, N, IDPairs(), boost::bind(&OPOverlapTest::testParticle, this, _1, _2),
+	 &joinPairs);
+    else
+      for (size_t ID(0); ID < N; ++ID)
+	testParticle(ID, invalid);
+
+    _cells.reset();
+
+    //The threads test quietly, so the reports are written here, in order
+    typedef std::pair<size_t, size_t> IDPair;
+    BOOST_FOREACH(const IDPair& IDs, invalid)
+      {
+	const Particle& p1 = Sim->particles[IDs.first];
+	const Particle& p2 = Sim->particles[IDs.second];
+	Sim->getInteraction(p1, p2)->validateState(p1, p2);
+      }
+  }
+
+  void 
+  OPOverlapTest::testParticle(size_t ID, IDPairs& invalid) const
+  {
+    OverlapTester tester;
+    tester.Sim = Sim;
+    tester.p1 = &Sim->particles[ID];
+    tester.invalid = &invalid;
+    _cells->visitNeighbours(ID, tester);
   }
 }
@@ -18,8 +18,21 @@
 #pragma once
 
 #include <dynamo/outputplugins/tickerproperty/ticker.hpp>
+#include <vector>
+#include <utility>
 
 namespace dynamo {
+  class ParticleCells;
+
+  /*! \brief Tests the configuration for overlapping particles and
+      invalid Interaction states.
+
+    Like the Scheduler's validation, only the pairs closer than the
+    longest Interaction are tested (found using a ParticleCells grid),
+    and the Interactions themselves test any distant pairs they track
+    (e.g., in capture maps or bonds). The particles are split between
+    the threads of the Simulation.
+   */
   class OPOverlapTest: public OPTicker
   {
   public:
@@ -33,6 +46,17 @@ namespace dynamo {
   
     virtual void output(magnet::xml::XmlStream&);
 
+    virtual bool canReorderParticles() const { return true; }
+
   protected:
+    typedef std::vector<std::pair<size_t, size_t> > IDPairs;
+
+    /*! \brief Quietly tests the pairs of a particle, collecting the
+        invalid pairs.
+     */
+    void testParticle(size_t ID, IDPairs& invalid) const;
+
+    //! \brief The cell grid used while a test is run.
+    shared_ptr<ParticleCells> _cells;
   };
 }
@@ -19,9 +19,12 @@
 #include <dynamo/outputplugins/0partproperty/misc.hpp>
 #include <dynamo/include.hpp>
 #include <dynamo/dynamics/dynamics.hpp>
+#include <dynamo/particlecells.hpp>
+#include <magnet/thread/workstealing.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <magnet/xmlreader.hpp>
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
 
 namespace dynamo {
   OPRadialDistribution::OPRadialDistribution(const dynamo::Simulation* tmp, 
@@ -102,6 +105,42 @@ namespace dynamo {
     ticker();
   }
 
+  namespace {
+    /*! \brief Bins the separation of a particle from each of the
+        particles visited.
+    */
+    struct RDFBinner
+    {
+      const Simulation* Sim;
+      const Particle* p1;
+      unsigned long* counts;
+      double binWidth;
+      size_t length;
+
+      inline void operator()(size_t ID2)
+      {
+	const Particle& p2 = Sim->particles[ID2];
+	Vector  rij = p1->getPosition() - p2.getPosition();
+	
+	Sim->BCs->applyBC(rij);
+	
+	size_t i = (long) (((rij.nrm())/binWidth) + 0.5);
+	
+	if (i < length)
+	  ++counts[Sim->species[p2]->getID() * length + i];
+      }
+    };
+
+    //! \brief Adds the histogram b to a, for the parallel_reduce.
+    std::vector<unsigned long>
+    addCounts(std::vector<unsigned long> a, const std::vector<unsigned long>& b)
+    {
+      for (size_t i(0); i < a.size(); ++i)
+	a[i] += b[i];
+      return a;
+    }
+  }
+
   void 
   OPRadialDistribution::ticker()
   {
@@ -124,22 +163,46 @@ namespace dynamo {
       }
     
     ++sampleCount;
-  
-    BOOST_FOREACH(const shared_ptr<Species>& sp1, Sim->species)
-      BOOST_FOREACH(const shared_ptr<Species>& sp2, Sim->species)
-      BOOST_FOREACH(const size_t& p1, *sp1->getRange())
-      BOOST_FOREACH(const size_t& p2, *sp2->getRange())
+
+    //Pairs separated by length * binWidth or more are beyond the
+    //last bin
+    _cells.reset(new ParticleCells(Sim, length * binWidth));
+
+    const size_t nSpecies = Sim->species.size();
+    const size_t N = Sim->particles.size();
+    const std::vector<unsigned long> empty(nSpecies * nSpecies * length, 0);
+    std::vector<unsigned long> counts;
+    if (Sim->threadPool && Sim->threadPool->getThreadCount())
+      counts = Sim->threadPool->parallel_reduce
+	(0, N, empty, boost::bind(&OPRadialDistribution::sampleParticle, this, _1, _2),
+	 &addCounts);
+    else
       {
-	Vector  rij = Sim->particles[p1].getPosition()
-	  - Sim->particles[p2].getPosition();
-	
-	Sim->BCs->applyBC(rij);
-	
-	size_t i = (long) (((rij.nrm())/binWidth) + 0.5);
-	
-	if (i < length)
-	  ++data[sp1->getID()][sp2->getID()][i];
+	counts = empty;
+	for (size_t ID(0); ID < N; ++ID)
+	  sampleParticle(ID, counts);
       }
+
+    for (size_t sp1(0); sp1 < nSpecies; ++sp1)
+      for (size_t sp2(0); sp2 < nSpecies; ++sp2)
+	for (size_t i(0); i < length; ++i)
+	  data[sp1][sp2][i] += counts[(sp1 * nSpecies + sp2) * length + i];
+
+    _cells.reset();
+  }
+
+  void 
+  OPRadialDistribution::sampleParticle(size_t ID, std::vector<unsigned long>& counts) const
+  {
+    const size_t nSpecies = Sim->species.size();
+
+    RDFBinner binner;
+    binner.Sim = Sim;
+    binner.binWidth = binWidth;
+    binner.length = length;
+    binner.p1 = &Sim->particles[ID];
+    binner.counts = &counts[Sim->species[*binner.p1]->getID() * nSpecies * length];
+    _cells->visitNeighbours(ID, binner);
   }
 
   void
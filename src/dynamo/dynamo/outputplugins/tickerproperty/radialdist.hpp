@@ -22,6 +22,16 @@
 #include <vector>
 
 namespace dynamo {
+  class ParticleCells;
+
+  /*! \brief Samples the radial distribution function of each pair of
+      Species.
+
+    Only pairs of particles closer than the longest bin are sampled,
+    and these are found using a ParticleCells grid, so a sample costs
+    O(N) for short ranges. The particles are split between the
+    threads of the Simulation, each filling its own histogram.
+   */
   class OPRadialDistribution: public OPTicker
   {
   public:
@@ -36,14 +46,24 @@ namespace dynamo {
   
     virtual void output(magnet::xml::XmlStream&);
 
+    virtual bool canReorderParticles() const { return true; }
+
     void operator<<(const magnet::xml::Node&);
 
   protected:
+    /*! \brief Samples the pairs of a particle into a histogram,
+        indexed by the species pair and then the bin.
+     */
+    void sampleParticle(size_t ID, std::vector<unsigned long>& counts) const;
+
     double binWidth;
     size_t length;
     unsigned long sampleCount;
     double sample_energy; 
     double sample_energy_bin_width;
     std::vector<std::vector<std::vector<unsigned long> > > data;
+
+    //! \brief The cell grid used while a sample is taken.
+    shared_ptr<ParticleCells> _cells;
   };
 }
@@ -18,6 +18,11 @@
 #pragma once
 
 #include <magnet/math/vector.hpp>
+#include <magnet/memory/aligned_allocator.hpp>
+#include <magnet/exception.hpp>
+#include <boost/static_assert.hpp>
+#include <limits>
+#include <vector>
 
 namespace magnet { namespace xml { class Node; class XmlStream; } }
 
@@ -28,6 +33,13 @@ namespace dynamo {
   //! particle, such as its position, velocity, ID, and state
   //! flags. Other data is "attached" to this particle using
   //! Property classes stored in the PropertyStore.
+  //!
+  //! The members are packed so that a Particle occupies exactly one
+  //! 64 byte cache line (see \ref ParticleContainer). Nearly every
+  //! access in the event loop is to a single, randomly chosen
+  //! particle's position, velocity and peculiar time together, so
+  //! keeping them on one line is more important than a
+  //! structure-of-arrays layout for the rare bulk sweeps.
   class Particle
   {
   public:
@@ -55,16 +67,17 @@ namespace dynamo {
 		     const Vector  &velocity,
 		     const unsigned long& nID):
       _pos(position), _vel(velocity), 
-      _ID(nID), _peculiarTime(0.0),
+      _peculiarTime(0.0), _ID(nID),
       _state(DEFAULT)
-    {}
+    { checkID(nID); }
   
     //! \brief Constructor to build a particle from an XML node.
     Particle(const magnet::xml::Node& XML, unsigned long nID):
-      _ID(nID),
       _peculiarTime(0.0),
+      _ID(nID),
       _state(DEFAULT)
     {
+      checkID(nID);
       if (XML.hasAttribute("Static")) clearState(DYNAMIC);
     
       _pos << XML.getNode("P");
@@ -93,7 +106,7 @@ namespace dynamo {
     //! \brief ID accessor function.
     //! This ID is a unique value for each Particle in the Simulation
     //! and so it can also be used as a reference to a particle.
-    inline const unsigned long &getID() const { return _ID; };
+    inline unsigned long getID() const { return _ID; };
 
     //! \brief Const peculiar time accessor function.
     //! This value is used in the "delayed states" or "Time warp" algorithm.
@@ -122,10 +135,31 @@ namespace dynamo {
     inline void clearState(State nState) { _state &= (~nState); }  
 
   private:
+    //! Simulation::reorderParticles renumbers the particles.
+    friend class Simulation;
+
+    //! \brief Particle IDs are stored in 32 bits to keep the Particle
+    //! within a single cache line.
+    inline static void checkID(unsigned long nID)
+    {
+      if (nID > std::numeric_limits<unsigned int>::max())
+	M_throw() << "Particle ID " << nID << " is too large to be stored";
+    }
+
     Vector _pos;
     Vector _vel;
-    unsigned long _ID;
     double _peculiarTime;
+    unsigned int _ID;
     int _state;
   };
+
+  BOOST_STATIC_ASSERT(sizeof(Particle) == 64);
+
+  /*! \brief The container type used to store the particles of a
+    Simulation.
+
+    The storage is aligned to a cache line so that, together with the
+    64 byte Particle, no particle straddles two cache lines.
+   */
+  typedef std::vector<Particle, magnet::memory::AlignedAllocator<Particle, 64> > ParticleContainer;
 }
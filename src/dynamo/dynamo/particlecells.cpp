@@ -0,0 +1,70 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dynamo/particlecells.hpp>
+#include <dynamo/simulation.hpp>
+#include <dynamo/BC/LEBC.hpp>
+#include <cmath>
+
+namespace dynamo {
+  ParticleCells::ParticleCells(const Simulation* Sim, double range)
+  {
+    const bool sliding = std::tr1::dynamic_pointer_cast<BCLeesEdwards>(Sim->BCs);
+
+    size_t totalCells(1);
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      {
+	_cellCount[iDim] = 1;
+	if (!sliding && (range > 0))
+	  {
+	    const double count = std::floor(Sim->primaryCellSize[iDim] / range);
+	    if ((count >= 3) && (count < 1e6))
+	      _cellCount[iDim] = count;
+	  }
+	totalCells *= _cellCount[iDim];
+      }
+    
+    //Sort the particles into the cells with a counting sort
+    _particleCell.resize(Sim->particles.size());
+    _cellStart.assign(totalCells + 1, 0);
+    for (size_t ID(0); ID < Sim->particles.size(); ++ID)
+      {
+	const Vector& pos = Sim->particles[ID].getPosition();
+	size_t cell(0);
+	for (size_t iDim(NDIM); iDim-- > 0;)
+	  {
+	    const double L = Sim->primaryCellSize[iDim];
+	    //The position as a fraction of the primary image, in [0,1)
+	    double frac = pos[iDim] / L + 0.5;
+	    frac -= std::floor(frac);
+	    const size_t coord = std::min(size_t(frac * _cellCount[iDim]), _cellCount[iDim] - 1);
+	    cell = cell * _cellCount[iDim] + coord;
+	  }
+
+	_particleCell[ID] = cell;
+	++_cellStart[cell + 1];
+      }
+
+    for (size_t i(0); i < totalCells; ++i)
+      _cellStart[i + 1] += _cellStart[i];
+
+    _cellParticles.resize(Sim->particles.size());
+    std::vector<size_t> fill(_cellStart.begin(), _cellStart.end() - 1);
+    for (size_t ID(0); ID < Sim->particles.size(); ++ID)
+      _cellParticles[fill[_particleCell[ID]]++] = ID;
+  }
+}
@@ -0,0 +1,109 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <magnet/math/vector.hpp>
+#include <vector>
+#include <cstddef>
+
+namespace dynamo {
+  class Simulation;
+
+  /*! \brief A cell list of the particles of a Simulation, used to
+      find the pairs of particles closer than some range without
+      testing every pair.
+
+    The particles are sorted into a grid of cells which are at least
+    as wide as the range, so the partners of a particle within the
+    range are all in its cell or the cells surrounding it. The grid
+    wraps around the primary image, so periodic images are found for
+    the periodic boundary conditions, and nothing is missed for
+    systems without them.
+
+    The sliding boundary of the Lees-Edwards conditions moves images
+    out of the neighbouring cells, so there (and along any dimension
+    with fewer than three cells) a single cell is used and every pair
+    is visited.
+
+    This is a snapshot of the particle positions when it is built,
+    and is intended for output plugins which sample pairs of
+    particles.
+   */
+  class ParticleCells
+  {
+  public:
+    ParticleCells(const Simulation* Sim, double range);
+
+    /*! \brief Calls func(ID) for every particle in the cells
+        surrounding the particle ID1, including ID1 itself.
+
+      The distance of the particles is not tested, so this also visits
+      particles beyond the range.
+     */
+    template<class Func>
+    inline void visitNeighbours(size_t ID1, Func& func) const
+    {
+      const size_t cell = _particleCell[ID1];
+      size_t coords[NDIM];
+      for (size_t iDim(0), rem(cell); iDim < NDIM; ++iDim)
+	{
+	  coords[iDim] = rem % _cellCount[iDim];
+	  rem /= _cellCount[iDim];
+	}
+
+      size_t offset[NDIM] = {};
+      for (;;)
+	{
+	  size_t neighbour(0);
+	  for (size_t iDim(NDIM); iDim-- > 0;)
+	    {
+	      const size_t count = _cellCount[iDim];
+	      neighbour = neighbour * count 
+		+ ((count == 1) ? 0 : (coords[iDim] + count + offset[iDim] - 1) % count);
+	    }
+
+	  for (size_t i(_cellStart[neighbour]); i < _cellStart[neighbour + 1]; ++i)
+	    func(_cellParticles[i]);
+
+	  //Step to the next of the neighbouring cells
+	  size_t iDim(0);
+	  for (; iDim < NDIM; ++iDim)
+	    {
+	      if ((_cellCount[iDim] > 1) && (++offset[iDim] < 3)) break;
+	      offset[iDim] = 0;
+	    }
+
+	  if (iDim == NDIM) return;
+	}
+    }
+
+    //! \brief The number of cells in each dimension.
+    size_t getCellCount(size_t iDim) const { return _cellCount[iDim]; }
+
+  private:
+    size_t _cellCount[NDIM];
+
+    //! \brief The cell of each particle.
+    std::vector<size_t> _particleCell;
+
+    /*! \brief The particles of cell i are _cellParticles[j] for
+        _cellStart[i] <= j < _cellStart[i+1].
+     */
+    std::vector<size_t> _cellStart;
+    std::vector<size_t> _cellParticles;
+  };
+}
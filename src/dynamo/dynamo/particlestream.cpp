@@ -0,0 +1,404 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dynamo/particlestream.hpp>
+#include <magnet/exception.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace dynamo {
+  namespace {
+    const std::string particleDataTag("<ParticleData");
+
+    inline bool isSpace(char c)
+    { return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'); }
+
+    inline bool parseDouble(const std::string& str, double& value)
+    {
+      const char* begin = str.c_str();
+      char* end;
+      value = std::strtod(begin, &end);
+      if (end == begin) return false;
+      while (isSpace(*end)) ++end;
+      return *end == '\0';
+    }
+  }
+
+  ParticleStreamReader::ParticleStreamReader(size_t chunkSize):
+    _state(HEADER),
+    _chunkSize(std::max(chunkSize, size_t(1))),
+    _count(0),
+    _orientationCount(0),
+    _angularVelocityCount(0),
+    _outOfSequence(false),
+    _inParticle(false),
+    _hasPosition(false),
+    _hasVelocity(false),
+    _particle(Vector(0,0,0), Vector(0,0,0), 0)
+  {}
+
+  void
+  ParticleStreamReader::read(std::istream& in, std::string& xml)
+  {
+    std::vector<char> chunk(_chunkSize);
+    std::string buffer;
+    size_t pos(0);
+
+    for (bool eof(false); !eof;)
+      {
+	in.read(&chunk[0], chunk.size());
+	const size_t count = in.gcount();
+	eof = (count == 0);
+
+	buffer.erase(0, pos);
+	pos = 0;
+	buffer.append(&chunk[0], count);
+
+	for (bool waiting(false); !waiting;)
+	  switch (_state)
+	    {
+	    case HEADER:
+	      {
+		const size_t start = buffer.find(particleDataTag, pos);
+		if (start == std::string::npos)
+		  {
+		    //Keep enough of the buffer to find a tag split
+		    //between chunks
+		    size_t end = buffer.size();
+		    if (!eof)
+		      end = std::max(pos, end - std::min(end, particleDataTag.size()));
+		    xml.append(buffer, pos, end - pos);
+		    pos = end;
+		    waiting = true;
+		    break;
+		  }
+
+		xml.append(buffer, pos, start - pos);
+		pos = start;
+
+		size_t end;
+		if (!findTagEnd(buffer, start, end))
+		  {
+		    if (eof)
+		      M_throw() << "The XML file ends within the ParticleData tag";
+		    waiting = true;
+		    break;
+		  }
+
+		xml.append(buffer, start, end - start);
+		parseTag(buffer, start, end, _tag);
+		pos = end;
+
+		for (Attributes::const_iterator it = _tag.attributes.begin();
+		     it != _tag.attributes.end(); ++it)
+		  if (it->first == "N")
+		    {
+		      double N;
+		      if (parseDouble(it->second, N) && (N > 0))
+			_particles.reserve(static_cast<size_t>(N));
+		    }
+
+		_state = _tag.selfClosing ? TRAILER : PARTICLES;
+		break;
+	      }
+	    case PARTICLES:
+	      {
+		const size_t start = buffer.find('<', pos);
+		if (start == std::string::npos)
+		  {
+		    pos = buffer.size();
+		    if (eof)
+		      M_throw() << "The XML file ends within the ParticleData section";
+		    waiting = true;
+		    break;
+		  }
+
+		size_t end;
+		if (!findTagEnd(buffer, start, end))
+		  {
+		    pos = start;
+		    if (eof)
+		      M_throw() << "The XML file ends within the ParticleData section";
+		    waiting = true;
+		    break;
+		  }
+
+		pos = end;
+		//Skip comments
+		if (!buffer.compare(start, 4, "<!--")) break;
+
+		parseTag(buffer, start, end, _tag);
+		if (_tag.closing && (_tag.name == "ParticleData"))
+		  {
+		    if (_inParticle)
+		      M_throw() << "The ParticleData tag was closed within a Pt tag";
+		    xml.append("</ParticleData>");
+		    _state = TRAILER;
+		  }
+		else
+		  processTag(_tag);
+		break;
+	      }
+	    case TRAILER:
+	      xml.append(buffer, pos, std::string::npos);
+	      pos = buffer.size();
+	      waiting = true;
+	      break;
+	    }
+      }
+
+    if (_state == PARTICLES)
+      M_throw() << "The XML file ends within the ParticleData section";
+  }
+
+  bool
+  ParticleStreamReader::findTagEnd(const std::string& buffer, size_t start, size_t& end) const
+  {
+    if (!buffer.compare(start, 4, "<!--"))
+      {
+	end = buffer.find("-->", start + 4);
+	if (end == std::string::npos) return false;
+	end += 3;
+	return true;
+      }
+
+    char quote(0);
+    for (size_t i(start + 1); i < buffer.size(); ++i)
+      if (quote)
+	{ if (buffer[i] == quote) quote = 0; }
+      else if ((buffer[i] == '"') || (buffer[i] == '\''))
+	quote = buffer[i];
+      else if (buffer[i] == '>')
+	{
+	  end = i + 1;
+	  return true;
+	}
+
+    return false;
+  }
+
+  void
+  ParticleStreamReader::parseTag(const std::string& buffer, size_t start, size_t end, Tag& tag) const
+  {
+    //Skip the <
+    size_t i(start + 1);
+    tag.closing = (buffer[i] == '/');
+    if (tag.closing) ++i;
+
+    size_t nameStart = i;
+    while ((i < end) && !isSpace(buffer[i]) && (buffer[i] != '/') && (buffer[i] != '>')) ++i;
+    tag.name.assign(buffer, nameStart, i - nameStart);
+
+    //The attribute strings are reused to save on allocations
+    size_t nAttributes(0);
+    for (;;)
+      {
+	while ((i < end) && isSpace(buffer[i])) ++i;
+	if ((i >= end) || (buffer[i] == '/') || (buffer[i] == '>')) break;
+
+	size_t attrStart = i;
+	while ((i < end) && (buffer[i] != '=') && !isSpace(buffer[i])) ++i;
+	size_t attrEnd = i;
+	while ((i < end) && isSpace(buffer[i])) ++i;
+	if ((i >= end) || (buffer[i] != '='))
+	  M_throw() << "Malformed attribute in the <" << tag.name << "> tag of the ParticleData";
+	++i;
+	while ((i < end) && isSpace(buffer[i])) ++i;
+	const char quote = (i < end) ? buffer[i] : 0;
+	if ((quote != '"') && (quote != '\''))
+	  M_throw() << "Unquoted attribute in the <" << tag.name << "> tag of the ParticleData";
+	size_t valueStart = ++i;
+	while ((i < end) && (buffer[i] != quote)) ++i;
+	if (i >= end)
+	  M_throw() << "Unterminated attribute in the <" << tag.name << "> tag of the ParticleData";
+
+	if (nAttributes == tag.attributes.size())
+	  tag.attributes.resize(nAttributes + 1);
+	tag.attributes[nAttributes].first.assign(buffer, attrStart, attrEnd - attrStart);
+	tag.attributes[nAttributes].second.assign(buffer, valueStart, i - valueStart);
+	++nAttributes;
+	++i;
+      }
+
+    tag.attributes.resize(nAttributes);
+    tag.selfClosing = (i < end) && (buffer[i] == '/');
+  }
+
+  void
+  ParticleStreamReader::processTag(const Tag& tag)
+  {
+    if (tag.name == "Pt")
+      {
+	if (tag.closing)
+	  {
+	    if (!_inParticle)
+	      M_throw() << "Unmatched </Pt> tag in the ParticleData";
+	    endParticle();
+	    return;
+	  }
+
+	if (_inParticle)
+	  M_throw() << "Nested <Pt> tag found in the ParticleData";
+
+	startParticle(tag);
+	if (tag.selfClosing) endParticle();
+	return;
+      }
+
+    if (tag.closing) return;
+
+    if (!_inParticle)
+      M_throw() << "Found a <" << tag.name << "> tag outside of a <Pt> tag in the ParticleData";
+
+    if (tag.name == "P")
+      {
+	_particle.getPosition() = parseVector(tag);
+	_hasPosition = true;
+      }
+    else if (tag.name == "V")
+      {
+	_particle.getVelocity() = parseVector(tag);
+	_hasVelocity = true;
+      }
+    else if (tag.name == "U")
+      {
+	_orientations.resize(_particles.size() + 1, Vector(0,0,0));
+	_orientations.back() = parseVector(tag);
+	++_orientationCount;
+      }
+    else if (tag.name == "O")
+      {
+	_angularVelocities.resize(_particles.size() + 1, Vector(0,0,0));
+	_angularVelocities.back() = parseVector(tag);
+	++_angularVelocityCount;
+      }
+  }
+
+  void
+  ParticleStreamReader::startParticle(const Tag& tag)
+  {
+    const size_t ID = _particles.size();
+    _particle = Particle(Vector(0,0,0), Vector(0,0,0), ID);
+    _inParticle = true;
+    _hasPosition = false;
+    _hasVelocity = false;
+
+    bool hasID(false);
+    for (Attributes::const_iterator it = tag.attributes.begin();
+	 it != tag.attributes.end(); ++it)
+      {
+	double value;
+	const bool numeric = parseDouble(it->second, value);
+
+	if (it->first == "ID")
+	  {
+	    hasID = true;
+	    if (!numeric || (value != ID))
+	      _outOfSequence = true;
+	  }
+	else if (it->first == "Static")
+	  _particle.clearState(Particle::DYNAMIC);
+	else
+	  {
+	    AttributeValues& values = _attributes[it->first];
+	    if (values.values.size() < ID)
+	      values.values.resize(ID, 0);
+	    values.values.push_back(value);
+	    values.numeric = values.numeric && numeric;
+	    ++values.count;
+	  }
+      }
+
+    if (!hasID) _outOfSequence = true;
+  }
+
+  void
+  ParticleStreamReader::endParticle()
+  {
+    if (!_hasPosition || !_hasVelocity)
+      M_throw() << "The particle " << _particles.size()
+		<< " in the ParticleData is missing its " << (_hasPosition ? "V" : "P") << " tag";
+
+    _particles.push_back(_particle);
+    ++_count;
+    _inParticle = false;
+  }
+
+  Vector
+  ParticleStreamReader::parseVector(const Tag& tag) const
+  {
+    Vector vec(0,0,0);
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      {
+	//Components are named x, y, z or, in older files, 0, 1, 2
+	const char names[2] = {char('x' + iDim), char('0' + iDim)};
+	bool found(false);
+	for (size_t n(0); (n < 2) && !found; ++n)
+	  for (Attributes::const_iterator it = tag.attributes.begin();
+	       it != tag.attributes.end(); ++it)
+	    if ((it->first.size() == 1) && (it->first[0] == names[n]))
+	      {
+		if (!parseDouble(it->second, vec[iDim]))
+		  M_throw() << "Failed to parse the value \"" << it->second << "\" in the <"
+			    << tag.name << "> tag of particle " << _particles.size();
+		found = true;
+		break;
+	      }
+
+	if (!found)
+	  M_throw() << "The <" << tag.name << "> tag of particle " << _particles.size()
+		    << " is missing the " << names[0] << " component";
+      }
+    return vec;
+  }
+
+  std::vector<Vector>&
+  ParticleStreamReader::getOrientations()
+  {
+    if ((_orientationCount != _count) || (_orientations.size() != _count))
+      M_throw() << "Only " << _orientationCount << " of the " << _count
+		<< " particles have an orientation (U tag)";
+    return _orientations;
+  }
+
+  std::vector<Vector>&
+  ParticleStreamReader::getAngularVelocities()
+  {
+    if ((_angularVelocityCount != _count) || (_angularVelocities.size() != _count))
+      M_throw() << "Only " << _angularVelocityCount << " of the " << _count
+		<< " particles have an angular velocity (O tag)";
+    return _angularVelocities;
+  }
+
+  std::vector<double>&
+  ParticleStreamReader::getAttribute(const std::string& name)
+  {
+    std::map<std::string, AttributeValues>::iterator it = _attributes.find(name);
+    if (it == _attributes.end())
+      M_throw() << "None of the particles have the attribute \"" << name << "\"";
+
+    if ((it->second.count != _count) || (it->second.values.size() != _count))
+      M_throw() << "Only " << it->second.count << " of the " << _count
+		<< " particles have the attribute \"" << name << "\"";
+
+    if (!it->second.numeric)
+      M_throw() << "The particle attribute \"" << name << "\" has values which are not numbers";
+
+    return it->second.values;
+  }
+}
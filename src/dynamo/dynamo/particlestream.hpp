@@ -0,0 +1,139 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <dynamo/particle.hpp>
+#include <istream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dynamo {
+  /*! \brief Parses the ParticleData section of an XML configuration
+    as it is read, so that the particles never exist as a DOM tree.
+
+    The XML configuration is passed through \ref read in chunks. The
+    text outside of the ParticleData tag is copied out for parsing
+    into a magnet::xml::Document as usual, but the ParticleData tag is
+    left empty and the Pt tags within it are converted straight into
+    Particle-s and arrays of their attributes. The memory needed to
+    load a configuration is then close to that of the final particle
+    storage, instead of a multiple of the size of the XML.
+
+    The parser only understands the subset of XML written by DynamO
+    for the particle data: Pt tags with numeric attributes, holding
+    P, V, U and O tags with x, y and z attributes.
+   */
+  class ParticleStreamReader
+  {
+  public:
+    /*! \brief Constructor.
+
+      \param chunkSize The number of bytes taken from the stream at a
+      time.
+     */
+    ParticleStreamReader(size_t chunkSize = 1 << 20);
+
+    /*! \brief Reads the whole XML configuration from a stream.
+
+      \param xml The XML outside of the ParticleData tag is appended
+      to this string.
+     */
+    void read(std::istream& in, std::string& xml);
+
+    //! \brief The number of Pt tags read.
+    size_t size() const { return _count; }
+
+    /*! \brief The particles read, in the units of the file.
+
+      These are moved out of the reader by swapping the container.
+    */
+    ParticleContainer& getParticles() { return _particles; }
+
+    //! \brief Whether the ID attributes did not match the order of the Pt tags.
+    bool outOfSequence() const { return _outOfSequence; }
+
+    /*! \brief The orientations (U tags) of the particles.
+
+      An exception is thrown if any particle was missing its U tag.
+     */
+    std::vector<Vector>& getOrientations();
+
+    /*! \brief The angular velocities (O tags) of the particles.
+
+      An exception is thrown if any particle was missing its O tag.
+     */
+    std::vector<Vector>& getAngularVelocities();
+
+    /*! \brief The values of a Pt attribute for every particle.
+
+      An exception is thrown if any particle is missing the attribute
+      or it is not a number. The values may be moved out of the reader
+      by swapping the container.
+     */
+    std::vector<double>& getAttribute(const std::string& name);
+
+  private:
+    typedef std::vector<std::pair<std::string, std::string> > Attributes;
+
+    /*! \brief A parsed tag of the particle data. */
+    struct Tag
+    {
+      std::string name;
+      Attributes attributes;
+      bool closing;
+      bool selfClosing;
+    };
+
+    struct AttributeValues
+    {
+      AttributeValues(): count(0), numeric(true) {}
+      std::vector<double> values;
+      size_t count;
+      bool numeric;
+    };
+
+    bool findTagEnd(const std::string& buffer, size_t start, size_t& end) const;
+    void parseTag(const std::string& buffer, size_t start, size_t end, Tag& tag) const;
+    void processTag(const Tag& tag);
+    void startParticle(const Tag& tag);
+    void endParticle();
+    Vector parseVector(const Tag& tag) const;
+
+    enum State { HEADER, PARTICLES, TRAILER };
+    State _state;
+    size_t _chunkSize;
+
+    //! \brief The number of particles read, as they may be moved out.
+    size_t _count;
+    ParticleContainer _particles;
+    std::vector<Vector> _orientations;
+    std::vector<Vector> _angularVelocities;
+    size_t _orientationCount;
+    size_t _angularVelocityCount;
+    std::map<std::string, AttributeValues> _attributes;
+    bool _outOfSequence;
+
+    //! \brief The particle being read.
+    bool _inParticle;
+    bool _hasPosition;
+    bool _hasVelocity;
+    Particle _particle;
+    Tag _tag;
+  };
+}
@@ -0,0 +1,144 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dynamo/profiler.hpp>
+#include <dynamo/simulation.hpp>
+#include <dynamo/interactions/interaction.hpp>
+#include <dynamo/locals/local.hpp>
+#include <dynamo/globals/global.hpp>
+#include <dynamo/systems/system.hpp>
+#include <dynamo/outputplugins/outputplugin.hpp>
+#include <magnet/xmlwriter.hpp>
+#include <sstream>
+
+namespace dynamo {
+  EventProfiler::Cycles
+  EventProfiler::Histogram::binEdge(size_t b)
+  {
+    if (b < subBins) return b;
+    const size_t msb = b / subBins;
+    return Cycles(subBins + b % subBins) << (msb - 2);
+  }
+
+  EventProfiler::Cycles
+  EventProfiler::Histogram::percentile(double fraction) const
+  {
+    const double target = fraction * _count;
+    size_t sum(0);
+    for (size_t b(0); b < nBins; ++b)
+      {
+	sum += _bins[b];
+	if (sum && (sum >= target)) return binEdge(b);
+      }
+    return _max;
+  }
+
+  void
+  EventProfiler::Histogram::outputXML(magnet::xml::XmlStream& XML) const
+  {
+    XML << magnet::xml::attr("Count") << _count
+	<< magnet::xml::attr("TotalCycles") << _total
+	<< magnet::xml::attr("MeanCycles") << (_count ? double(_total) / _count : 0.0)
+	<< magnet::xml::attr("P50") << percentile(0.5)
+	<< magnet::xml::attr("P90") << percentile(0.9)
+	<< magnet::xml::attr("P99") << percentile(0.99)
+	<< magnet::xml::attr("Max") << _max;
+  }
+
+  namespace {
+    template<class T>
+    void outputHistograms(magnet::xml::XmlStream& XML, const char* tagName,
+			  const std::vector<EventProfiler::Histogram>& histograms,
+			  const std::vector<shared_ptr<T> >& objects)
+    {
+      XML << magnet::xml::tag(tagName);
+      for (size_t ID(0); ID < histograms.size(); ++ID)
+	if (histograms[ID].count())
+	  {
+	    XML << magnet::xml::tag("Timing")
+		<< magnet::xml::attr("Name") << objects[ID]->getName()
+		<< magnet::xml::attr("ID") << ID;
+	    histograms[ID].outputXML(XML);
+	    XML << magnet::xml::endtag("Timing");
+	  }
+      XML << magnet::xml::endtag(tagName);
+    }
+  }
+
+  void
+  EventProfiler::outputXML(magnet::xml::XmlStream& XML, const Simulation& sim) const
+  {
+    XML << magnet::xml::tag("Profile")
+	<< magnet::xml::attr("Units") << "Cycles";
+
+    XML << magnet::xml::tag("EventTypes");
+    for (size_t type(0); type < FINAL_ENUM_TO_CATCH_THE_COMMA; ++type)
+      if (_eventTypes[type].count())
+	{
+	  std::ostringstream os;
+	  os << EEventType(type);
+	  XML << magnet::xml::tag("Timing")
+	      << magnet::xml::attr("Name") << os.str();
+	  _eventTypes[type].outputXML(XML);
+	  XML << magnet::xml::endtag("Timing");
+	}
+    XML << magnet::xml::endtag("EventTypes");
+
+    XML << magnet::xml::tag("Sorter");
+    sorter.outputXML(XML);
+    XML << magnet::xml::endtag("Sorter")
+	<< magnet::xml::tag("Recalculation");
+    recalculation.outputXML(XML);
+    XML << magnet::xml::endtag("Recalculation");
+
+    outputHistograms(XML, "Interactions", _interactions, sim.interactions);
+    outputHistograms(XML, "Locals", _locals, sim.locals);
+    outputHistograms(XML, "Globals", _globals, sim.globals);
+    outputHistograms(XML, "Systems", _systems, sim.systems);
+
+    XML << magnet::xml::tag("Plugins");
+    for (size_t ID(0); ID < sim.outputPlugins.size(); ++ID)
+      {
+	XML << magnet::xml::tag("Plugin")
+	    << magnet::xml::attr("Name") << sim.outputPlugins[ID]->getPluginName();
+	if ((ID < _pluginEvents.size()) && _pluginEvents[ID].count())
+	  {
+	    XML << magnet::xml::tag("EventUpdate");
+	    _pluginEvents[ID].outputXML(XML);
+	    XML << magnet::xml::endtag("EventUpdate");
+	  }
+	if ((ID < _pluginPeriodic.size()) && _pluginPeriodic[ID].count())
+	  {
+	    XML << magnet::xml::tag("PeriodicOutput");
+	    _pluginPeriodic[ID].outputXML(XML);
+	    XML << magnet::xml::endtag("PeriodicOutput");
+	  }
+	XML << magnet::xml::endtag("Plugin");
+      }
+    XML << magnet::xml::endtag("Plugins");
+
+    XML << magnet::xml::tag("Counters")
+	<< magnet::xml::attr("LazyDeletions") << lazyDeletions
+	<< magnet::xml::attr("InteractionRejections") << interactionRejections
+	<< magnet::xml::attr("InteractionRejectionLimitHits") << interactionRejectionLimitHits
+	<< magnet::xml::attr("LocalRejections") << localRejections
+	<< magnet::xml::attr("LocalRejectionLimitHits") << localRejectionLimitHits
+	<< magnet::xml::endtag("Counters");
+
+    XML << magnet::xml::endtag("Profile");
+  }
+}
@@ -0,0 +1,192 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <dynamo/eventtypes.hpp>
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+
+#if defined(__i386__) || defined(__x86_64__)
+# include <x86intrin.h>
+#else
+# include <time.h>
+#endif
+
+namespace magnet { namespace xml { class XmlStream; } }
+
+namespace dynamo {
+  class Simulation;
+
+  /*! \brief Collects the cost of each part of the event loop.
+
+    This class is only used if DynamO is built with the DYNAMO_PROFILE
+    define (bjam dynamo-profile=yes). Every use of it is wrapped in
+    #ifdef DYNAMO_PROFILE blocks, so normal builds do not contain any
+    of the instrumentation.
+
+    The cost of each event is measured in cycles of the time stamp
+    counter and is collected per event type, per Interaction, Local,
+    Global and System, and per OutputPlugin. The results are written
+    into the output file by \ref Simulation::outputData.
+   */
+  class EventProfiler
+  {
+  public:
+    typedef unsigned long long Cycles;
+
+    //! \brief Reads the time stamp counter of the processor.
+    static inline Cycles cycles()
+    {
+#if defined(__i386__) || defined(__x86_64__)
+      return __rdtsc();
+#else
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return Cycles(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+#endif
+    }
+
+    /*! \brief A histogram of cycle counts, with logarithmically
+      spaced bins.
+
+      Each power of two is split into four bins, so the percentiles
+      are accurate to within 19%. Adding a sample only needs a bit
+      scan and an increment.
+     */
+    class Histogram
+    {
+    public:
+      Histogram(): _count(0), _total(0), _max(0) { std::fill(_bins, _bins + nBins, 0); }
+
+      inline void add(Cycles c)
+      {
+	++_bins[bin(c)];
+	++_count;
+	_total += c;
+	if (c > _max) _max = c;
+      }
+
+      size_t count() const { return _count; }
+      Cycles total() const { return _total; }
+      Cycles max() const { return _max; }
+
+      /*! \brief Returns the lower edge of the bin holding the
+          requested fraction of the samples.
+       */
+      Cycles percentile(double fraction) const;
+
+      /*! \brief Writes the statistics of the histogram as attributes
+          of the current XML tag.
+       */
+      void outputXML(magnet::xml::XmlStream&) const;
+
+    private:
+      static const size_t subBins = 4;
+      static const size_t nBins = 64 * subBins;
+
+      static inline size_t bin(Cycles c)
+      {
+	if (c < subBins) return c;
+	const size_t msb = 63 - __builtin_clzll(c);
+	return msb * subBins + ((c >> (msb - 2)) & (subBins - 1));
+      }
+
+      static Cycles binEdge(size_t b);
+
+      size_t _bins[nBins];
+      size_t _count;
+      Cycles _total;
+      Cycles _max;
+    };
+
+    /*! \brief Records the cycles spent between its construction and
+        destruction.
+
+      The time may also be attributed to a second histogram (e.g.,
+      the Interaction which ran the event) once it is known.
+     */
+    class Timer
+    {
+    public:
+      Timer(Histogram& h): _primary(h), _secondary(NULL), _start(cycles()) {}
+
+      ~Timer()
+      {
+	const Cycles elapsed = cycles() - _start;
+	_primary.add(elapsed);
+	if (_secondary) _secondary->add(elapsed);
+      }
+
+      void alsoRecord(Histogram& h) { _secondary = &h; }
+
+    private:
+      Histogram& _primary;
+      Histogram* _secondary;
+      Cycles _start;
+    };
+
+    EventProfiler():
+      lazyDeletions(0),
+      interactionRejections(0),
+      interactionRejectionLimitHits(0),
+      localRejections(0),
+      localRejectionLimitHits(0)
+    {}
+
+    Histogram& eventType(EEventType type) { return _eventTypes[type]; }
+    Histogram& interaction(size_t ID) { return get(_interactions, ID); }
+    Histogram& local(size_t ID) { return get(_locals, ID); }
+    Histogram& global(size_t ID) { return get(_globals, ID); }
+    Histogram& system(size_t ID) { return get(_systems, ID); }
+    Histogram& pluginEvents(size_t ID) { return get(_pluginEvents, ID); }
+    Histogram& pluginPeriodic(size_t ID) { return get(_pluginPeriodic, ID); }
+
+    //! \brief Time spent popping and updating the FEL before an event.
+    Histogram sorter;
+    //! \brief Time spent recalculating an event before running it.
+    Histogram recalculation;
+
+    //! \brief Number of out of date events removed by lazy deletion.
+    size_t lazyDeletions;
+    //! \brief Number of interaction events found to be late on recalculation.
+    size_t interactionRejections;
+    //! \brief Number of times the interaction rejection limit forced an event.
+    size_t interactionRejectionLimitHits;
+    //! \brief Number of local events found to be late on recalculation.
+    size_t localRejections;
+    //! \brief Number of times the local rejection limit forced an event.
+    size_t localRejectionLimitHits;
+
+    void outputXML(magnet::xml::XmlStream&, const Simulation&) const;
+
+  private:
+    static inline Histogram& get(std::vector<Histogram>& v, size_t ID)
+    {
+      if (ID >= v.size()) v.resize(ID + 1);
+      return v[ID];
+    }
+
+    Histogram _eventTypes[FINAL_ENUM_TO_CATCH_THE_COMMA];
+    std::vector<Histogram> _interactions;
+    std::vector<Histogram> _locals;
+    std::vector<Histogram> _globals;
+    std::vector<Histogram> _systems;
+    std::vector<Histogram> _pluginEvents;
+    std::vector<Histogram> _pluginPeriodic;
+  };
+}
@@ -15,12 +15,15 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #pragma once
+#include <dynamo/checkpoint.hpp>
+#include <dynamo/particlestream.hpp>
 #include <magnet/exception.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <magnet/xmlreader.hpp>
 #include <magnet/units.hpp>
 #include <vector>
 #include <string>
+#include <utility>
 #include <algorithm>
 #include <cmath>
 
@@ -40,6 +43,9 @@ namespace dynamo {
   public:
     typedef magnet::units::Units Units;
 
+    //! The names and per-particle values of a set of Property-s.
+    typedef std::vector<std::pair<std::string, std::vector<double> > > ParticleValues;
+
     inline Property(Units units): _units(units) {}
 
     //! Fetch the value of this property for a particle with a certain ID
@@ -68,6 +74,13 @@ namespace dynamo {
     //! Fetch the units of this property
     inline const Units& getUnits() const { return _units; }
 
+    /*! \brief Called whenever the particles are renumbered.
+
+      \param order The new particle ID i is given the value of the
+      old particle ID order[i].
+    */
+    inline virtual void reorder(const std::vector<size_t>& order) {}
+
     //! Helper to write out derived classes
     friend magnet::xml::XmlStream operator<<(magnet::xml::XmlStream& XML, const Property& prop)
     { prop.outputXML(XML); return XML; }
@@ -80,6 +93,27 @@ namespace dynamo {
     inline virtual void outputParticleXMLData(magnet::xml::XmlStream& XML, 
 					      const size_t pID) const {}
 
+    /*! Add any per-particle data of this Property to a binary
+      checkpoint.
+    */
+    inline virtual void outputParticleBinaryData(CheckpointWriter&) const {}
+
+    /*! Append a copy of any per-particle data of this Property, under
+      the name of its XML attribute.
+    */
+    inline virtual void snapshotParticleData(ParticleValues&) const {}
+
+    /*! Load any per-particle data of this Property from a binary
+      checkpoint.
+      \param N The number of particles in the checkpoint.
+    */
+    inline virtual void loadParticleBinaryData(const CheckpointReader&, size_t N) {}
+
+    /*! Load any per-particle data of this Property from the Pt
+      attributes collected while streaming an XML configuration.
+    */
+    inline virtual void loadParticleStreamData(ParticleStreamReader&) {}
+
   protected:
     virtual void outputXML(magnet::xml::XmlStream& XML) const 
     { M_throw() << "Unimplemented"; }
@@ -191,6 +225,35 @@ namespace dynamo {
 
     inline void outputParticleXMLData(magnet::xml::XmlStream& XML, const size_t pID) const
     { XML << magnet::xml::attr(_name) << getProperty(pID); }
+
+    //! \sa Property::outputParticleBinaryData
+    inline void outputParticleBinaryData(CheckpointWriter& checkpoint) const
+    { checkpoint.addBlock("Property:" + _name, _values); }
+
+    //! \sa Property::snapshotParticleData
+    inline void snapshotParticleData(ParticleValues& values) const
+    { values.push_back(ParticleValues::value_type(_name, _values)); }
+
+    //! \sa Property::loadParticleBinaryData
+    inline void loadParticleBinaryData(const CheckpointReader& checkpoint, size_t N)
+    {
+      const double* values = checkpoint.getBlock<double>("Property:" + _name, N, _name + " values");
+      _values.assign(values, values + N);
+    }
+
+    //! \sa Property::loadParticleStreamData
+    inline void loadParticleStreamData(ParticleStreamReader& stream)
+    { _values.swap(stream.getAttribute(_name)); }
+
+    //! \sa Property::reorder
+    inline virtual void reorder(const std::vector<size_t>& order)
+    {
+      Container values;
+      values.reserve(order.size());
+      for (std::vector<size_t>::const_iterator it = order.begin(); it != order.end(); ++it)
+	values.push_back(_values[*it]);
+      _values.swap(values);
+    }
   
   
   protected:
@@ -332,6 +395,18 @@ namespace dynamo {
 	(*iPtr)->rescaleUnit(dim, rescale);
     }
 
+    /*! \brief Renumber the particles of all Property-s.
+      
+      \param order The new particle ID i is given the values of the
+      old particle ID order[i].
+    */
+    inline void reorder(const std::vector<size_t>& order)
+    {  
+      for (iterator iPtr = _namedProperties.begin(); 
+	   iPtr != _namedProperties.end(); ++iPtr)
+	(*iPtr)->reorder(order);
+    }
+
     /*! \brief Write any XML attributes relevent to Property-s for a
       single particle.
     
@@ -345,6 +420,48 @@ namespace dynamo {
 	(*iPtr)->outputParticleXMLData(XML, pID);
     }
 
+    /*! \brief Add the per-particle data of all Property-s to a
+      binary checkpoint.
+    */
+    inline void outputParticleBinaryData(CheckpointWriter& checkpoint) const 
+    {
+      for (const_iterator iPtr = _namedProperties.begin(); 
+	   iPtr != _namedProperties.end(); ++iPtr)
+	(*iPtr)->outputParticleBinaryData(checkpoint);
+    }
+
+    /*! \brief Copy the per-particle data of all Property-s, in the
+      order their XML attributes are written.
+    */
+    inline void snapshotParticleData(Property::ParticleValues& values) const 
+    {
+      for (const_iterator iPtr = _namedProperties.begin(); 
+	   iPtr != _namedProperties.end(); ++iPtr)
+	(*iPtr)->snapshotParticleData(values);
+    }
+
+    /*! \brief Load the per-particle data of all Property-s from a
+      binary checkpoint.
+    
+      \param N The number of particles in the checkpoint.
+    */
+    inline void loadParticleBinaryData(const CheckpointReader& checkpoint, size_t N)
+    {
+      for (iterator iPtr = _namedProperties.begin(); 
+	   iPtr != _namedProperties.end(); ++iPtr)
+	(*iPtr)->loadParticleBinaryData(checkpoint, N);
+    }
+
+    /*! \brief Load the per-particle data of all Property-s from a
+      streamed XML configuration.
+    */
+    inline void loadParticleStreamData(ParticleStreamReader& stream)
+    {
+      for (iterator iPtr = _namedProperties.begin(); 
+	   iPtr != _namedProperties.end(); ++iPtr)
+	(*iPtr)->loadParticleStreamData(stream);
+    }
+
     /*! \brief Method for pushing constructed properties into the
       PropertyStore.
      
@@ -17,12 +17,14 @@
 
 #pragma once
 #include <tr1/memory>
+#include <vector>
 
 namespace magnet { namespace xml { class Node; class XmlStream; } }
 namespace dynamo { 
   using std::tr1::shared_ptr;
   class Simulation;
   class Particle;
+  class IDRange;
 
   class IDPairRange
   {
@@ -31,6 +33,18 @@ namespace dynamo {
  
     virtual bool isInRange(const Particle&, const Particle&) const = 0;
 
+    /*! \brief Collects the IDRange's this pair range is built from.
+
+      This is used to build the species lookup tables of the
+      Simulation. If a pair range returns true, whether a pair is in
+      range must depend only on whether each particle is in each of
+      the collected ranges.
+
+      \return false if the pair range depends on anything else (e.g.,
+      explicit pairs or the topology).
+     */
+    virtual bool getIDRanges(std::vector<const IDRange*>&) const { return false; }
+
     static IDPairRange* getClass(const magnet::xml::Node&, const dynamo::Simulation*);
     
     friend magnet::xml::XmlStream& operator<<(magnet::xml::XmlStream& XML,
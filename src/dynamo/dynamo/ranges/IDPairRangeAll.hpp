@@ -31,6 +31,8 @@ namespace dynamo {
 
     virtual bool isInRange(const Particle&, const Particle&) const
     { return true; }
+
+    virtual bool getIDRanges(std::vector<const IDRange*>&) const { return true; }
     
   protected:
     virtual void outputXML(magnet::xml::XmlStream& XML) const
@@ -57,6 +57,14 @@ namespace dynamo {
       return false;
     }
 
+    virtual bool getIDRanges(std::vector<const IDRange*>& idranges) const
+    {
+      BOOST_FOREACH(const shared_ptr<IDPairRange>& rPtr, ranges)
+	if (!rPtr->getIDRanges(idranges))
+	  return false;
+      return true;
+    }
+
     void addRange(IDPairRange* nRange)
     { ranges.push_back(shared_ptr<IDPairRange>(nRange)); }
   
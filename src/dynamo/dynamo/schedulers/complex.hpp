@@ -35,6 +35,10 @@ namespace dynamo {
     virtual std::auto_ptr<IDRange> getParticleNeighbours(const Particle&) const  { M_throw() << "Unimplemented"; }
     virtual std::auto_ptr<IDRange> getParticleNeighbours(const Vector&) const { M_throw() << "Unimplemented"; }
     virtual std::auto_ptr<IDRange> getParticleLocals(const Particle&) const { M_throw() << "Unimplemented"; }
+
+    virtual void getParticleNeighbourhood(const Particle&, const GNeighbourList::nbHoodFunc&) const { M_throw() << "Unimplemented"; }
+    virtual void getParticleNeighbourhood(const Vector&, const GNeighbourList::nbHoodFunc2&) const { M_throw() << "Unimplemented"; }
+    virtual void getLocalNeighbourhood(const Particle&, const GNeighbourList::nbHoodFunc&) const { M_throw() << "Unimplemented"; }
     
   protected:
     virtual void outputXML(magnet::xml::XmlStream&) const;
@@ -62,4 +62,28 @@ namespace dynamo {
   {
     return std::auto_ptr<IDRange>(new IDRangeRange(0, Sim->locals.size()));
   }
+
+  void
+  SDumb::getParticleNeighbourhood(const Particle& part,
+				  const GNeighbourList::nbHoodFunc& func) const
+  {
+    for (size_t id(0); id < Sim->particles.size(); ++id)
+      func(part, id);
+  }
+
+  void
+  SDumb::getParticleNeighbourhood(const Vector&,
+				  const GNeighbourList::nbHoodFunc2& func) const
+  {
+    for (size_t id(0); id < Sim->particles.size(); ++id)
+      func(id);
+  }
+
+  void
+  SDumb::getLocalNeighbourhood(const Particle& part,
+			       const GNeighbourList::nbHoodFunc& func) const
+  {
+    for (size_t id(0); id < Sim->locals.size(); ++id)
+      func(part, id);
+  }
 }
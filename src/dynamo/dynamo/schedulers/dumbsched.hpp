@@ -30,6 +30,10 @@ namespace dynamo {
     virtual std::auto_ptr<IDRange> getParticleNeighbours(const Vector&) const;
     virtual std::auto_ptr<IDRange> getParticleLocals(const Particle&) const;
 
+    virtual void getParticleNeighbourhood(const Particle&, const GNeighbourList::nbHoodFunc&) const;
+    virtual void getParticleNeighbourhood(const Vector&, const GNeighbourList::nbHoodFunc2&) const;
+    virtual void getLocalNeighbourhood(const Particle&, const GNeighbourList::nbHoodFunc&) const;
+
   protected:
     virtual void outputXML(magnet::xml::XmlStream&) const;
   };
@@ -26,7 +26,6 @@
 #include <dynamo/globals/neighbourList.hpp>
 #include <dynamo/locals/local.hpp>
 #include <dynamo/locals/localEvent.hpp>
-#include <dynamo/ranges/IDRangeRange.hpp>
 #include <magnet/xmlreader.hpp>
 #include <boost/bind.hpp>
 #include <boost/progress.hpp>
@@ -62,6 +61,7 @@ namespace dynamo {
 
     nblist->markAsUsedInScheduler();
     nblist->ConnectSigNewNeighbourNotify<Scheduler>(&Scheduler::addInteractionEvent, this);
+    nblist->ConnectSigNewLocalNotify<Scheduler>(&Scheduler::addLocalEvent, this);
     Scheduler::initialise();
   }
 
@@ -121,6 +121,52 @@ namespace dynamo {
   std::auto_ptr<IDRange> 
   SNeighbourList::getParticleLocals(const Particle& part) const
   {
-    return std::auto_ptr<IDRange>(new IDRangeRange(0, Sim->locals.size()));
+#ifdef DYNAMO_DEBUG
+    if (!std::tr1::dynamic_pointer_cast<GNeighbourList>(Sim->globals[NBListID]))
+      M_throw() << "Not a GNeighbourList!";
+#endif
+
+    return std::auto_ptr<IDRange>(new IDRangeList(static_cast<const GNeighbourList&>
+						  (*Sim->globals[NBListID])
+						  .getParticleLocals(part)));
+  }
+
+  void
+  SNeighbourList::getParticleNeighbourhood(const Particle& part,
+					   const GNeighbourList::nbHoodFunc& func) const
+  {
+#ifdef DYNAMO_DEBUG
+    if (!std::tr1::dynamic_pointer_cast<GNeighbourList>(Sim->globals[NBListID]))
+      M_throw() << "Not a GNeighbourList!";
+#endif
+
+    static_cast<const GNeighbourList&>(*Sim->globals[NBListID])
+      .getParticleNeighbourhood(part, func);
+  }
+
+  void
+  SNeighbourList::getParticleNeighbourhood(const Vector& vec,
+					   const GNeighbourList::nbHoodFunc2& func) const
+  {
+#ifdef DYNAMO_DEBUG
+    if (!std::tr1::dynamic_pointer_cast<GNeighbourList>(Sim->globals[NBListID]))
+      M_throw() << "Not a GNeighbourList!";
+#endif
+
+    static_cast<const GNeighbourList&>(*Sim->globals[NBListID])
+      .getParticleNeighbourhood(vec, func);
+  }
+
+  void
+  SNeighbourList::getLocalNeighbourhood(const Particle& part,
+					const GNeighbourList::nbHoodFunc& func) const
+  {
+#ifdef DYNAMO_DEBUG
+    if (!std::tr1::dynamic_pointer_cast<GNeighbourList>(Sim->globals[NBListID]))
+      M_throw() << "Not a GNeighbourList!";
+#endif
+
+    static_cast<const GNeighbourList&>(*Sim->globals[NBListID])
+      .getLocalNeighbourhood(part, func);
   }
 }
@@ -23,6 +23,7 @@
 #include <dynamo/locals/local.hpp>
 #include <dynamo/systems/system.hpp>
 #include <dynamo/dynamics/dynamics.hpp>
+#include <dynamo/BC/BC.hpp>
 #include <dynamo/simulation.hpp>
 #include <dynamo/units/units.hpp>
 
@@ -31,15 +32,18 @@
 #include <dynamo/NparticleEventData.hpp>
 #endif
 
+#include <magnet/thread/workstealing.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <magnet/xmlreader.hpp>
 #include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/bind.hpp>
 
 namespace dynamo {
   Scheduler::Scheduler(dynamo::Simulation* const tmp, const char * aName,
 			 FEL* nS):
     SimBase(tmp, aName),
     sorter(nS),
+    globalEventCount(0),
     _interactionRejectionCounter(0),
     _localRejectionCounter(0)
   {}
@@ -61,22 +65,30 @@ namespace dynamo {
 
     BOOST_FOREACH(const shared_ptr<Interaction>& interaction_ptr, Sim->interactions)
       warnings += interaction_ptr->validateState(warnings < 101, 101 - warnings);
-    
-    for (size_t id1(0); id1 < Sim->particles.size(); ++id1)
+
+    //The particles are tested quietly by the threads, then the invalid
+    //states are reported here, in the order of the serial test
+    InvalidStates invalid;
+    if (threaded())
+      invalid = Sim->threadPool->parallel_reduce
+	(0, Sim->N, InvalidStates(),
+	 boost::bind(&Scheduler::validateParticle, this, _1, _2),
+	 &InvalidStates::join);
+    else
+      for (size_t ID(0); ID < Sim->N; ++ID)
+	validateParticle(ID, invalid);
+
+    BOOST_FOREACH(const IDPair& IDs, invalid.pairs)
       {
-	std::auto_ptr<IDRange> ids(getParticleNeighbours(Sim->particles[id1]));
-	BOOST_FOREACH(const size_t id2, *ids)
-	  if (id2 > id1)
-	    if (Sim->getInteraction(Sim->particles[id1], Sim->particles[id2])
-		->validateState(Sim->particles[id1], Sim->particles[id2], (warnings < 101)))
-	      ++warnings;
-      }
-    
-    BOOST_FOREACH(const Particle& part, Sim->particles)
-      BOOST_FOREACH(const shared_ptr<Local>& lcl, Sim->locals)
-      if (lcl->isInteraction(part))
-	if (lcl->validateState(part, (warnings < 101)))
+	const Particle& p1 = Sim->particles[IDs.first];
+	const Particle& p2 = Sim->particles[IDs.second];
+	if (Sim->getInteraction(p1, p2)->validateState(p1, p2, (warnings < 101)))
 	  ++warnings;
+      }
+
+    BOOST_FOREACH(const IDPair& IDs, invalid.locals)
+      if (Sim->locals[IDs.second]->validateState(Sim->particles[IDs.first], (warnings < 101)))
+	++warnings;
     
     if (warnings > 100)
       derr << "Over 100 warnings of invalid states, further output was suppressed (total of " << warnings << " warnings detected)" << std::endl;
@@ -85,6 +97,43 @@ namespace dynamo {
     rebuildList();
   }
 
+  namespace {
+    //! \brief Collects the neighbours of a particle which are in an invalid state.
+    struct InvalidPairCollector
+    {
+      InvalidPairCollector(const Simulation* sim, std::vector<std::pair<size_t, size_t> >& pairs):
+	Sim(sim), invalid(pairs) {}
+
+      void test(const Particle& p1, const size_t& ID2) const
+      {
+	//Each pair is only tested once
+	if (ID2 <= p1.getID()) return;
+
+	const Particle& p2 = Sim->particles[ID2];
+	if (Sim->getInteraction(p1, p2)->validateState(p1, p2, false))
+	  invalid.push_back(std::make_pair(p1.getID(), ID2));
+      }
+
+      const Simulation* Sim;
+      std::vector<std::pair<size_t, size_t> >& invalid;
+    };
+  }
+
+  void
+  Scheduler::validateParticle(size_t ID, InvalidStates& invalid) const
+  {
+    InvalidPairCollector collector(Sim, invalid.pairs);
+
+    const Particle& part = Sim->particles[ID];
+    getParticleNeighbourhood(part, GNeighbourList::nbHoodFunc
+			     (&collector, &InvalidPairCollector::test));
+
+    for (size_t l(0); l < Sim->locals.size(); ++l)
+      if (Sim->locals[l]->isInteraction(part)
+	  && Sim->locals[l]->validateState(part, false))
+	invalid.locals.push_back(std::make_pair(ID, l));
+  }
+
   void
   Scheduler::rebuildList()
   {
@@ -94,35 +143,104 @@ namespace dynamo {
     eventCount.clear();
     eventCount.resize(Sim->N+1, 0);
 
-    BOOST_FOREACH(Particle& part, Sim->particles)
-      addEvents(part);
+    if (threaded())
+      {
+	//Every particle is brought up to date first, so the threads
+	//only read the other particles while each fills the event
+	//list of its own particle
+	BOOST_FOREACH(Particle& part, Sim->particles)
+	  Sim->dynamics->updateParticle(part);
+
+	Sim->threadPool->parallel_for
+	  (0, Sim->N, boost::bind(&Scheduler::addParticleEvents, this, _1));
+      }
+    else
+      BOOST_FOREACH(Particle& part, Sim->particles)
+	addEvents(part);
   
     sorter->init();
 
     rebuildSystemEvents();
   }
 
+  void
+  Scheduler::addParticleEvents(size_t ID) const
+  {
+    const Particle& part = Sim->particles[ID];
+    addGlobalAndLocalEvents(part);
+    getParticleNeighbourhood(part, GNeighbourList::nbHoodFunc
+			     (this, &Scheduler::addUpToDateInteractionEvent));
+  }
+
+  bool
+  Scheduler::threaded() const
+  { return Sim->threadPool && Sim->threadPool->getThreadCount(); }
+
+  void
+  Scheduler::velocitiesRescaled(double factor)
+  {
+    if (!Sim->dynamics->eventTimesScaleWithVelocity()
+	|| !Sim->BCs->eventTimesScaleWithVelocity())
+      {
+	rebuildList();
+	return;
+      }
+
+    //Every interaction and ballistic event time is divided by the factor
+    sorter->rescaleTimes(1.0 / factor);
+
+    //Only the particles with a global or local whose events do not
+    //scale need to be recalculated
+    std::vector<const Global*> globals;
+    BOOST_FOREACH(const shared_ptr<Global>& glob, Sim->globals)
+      if (!glob->eventTimesScaleWithVelocity())
+	globals.push_back(glob.get());
+
+    std::vector<const Local*> locals;
+    BOOST_FOREACH(const shared_ptr<Local>& local, Sim->locals)
+      if (!local->eventTimesScaleWithVelocity())
+	locals.push_back(local.get());
+
+    if (!globals.empty() || !locals.empty())
+      {
+	BOOST_FOREACH(Particle& part, Sim->particles)
+	  {
+	    bool update(false);
+	    BOOST_FOREACH(const Global* glob, globals)
+	      update = update || glob->isInteraction(part);
+	    BOOST_FOREACH(const Local* local, locals)
+	      update = update || local->isInteraction(part);
+
+	    if (update) fullUpdate(part);
+	  }
+      }
+
+    rebuildSystemEvents();
+  }
 
   void 
   Scheduler::addEvents(Particle& part)
   {  
     Sim->dynamics->updateParticle(part);
 
+    addGlobalAndLocalEvents(part);
+
+    //Now add the interaction events
+    getParticleNeighbourhood(part, GNeighbourList::nbHoodFunc
+			     (this, &Scheduler::addInteractionEvent));
+  }
+
+  void
+  Scheduler::addGlobalAndLocalEvents(const Particle& part) const
+  {
     //Add the global events
     BOOST_FOREACH(const shared_ptr<Global>& glob, Sim->globals)
       if (glob->isInteraction(part))
-	sorter->push(glob->getEvent(part), part.getID());
+	sorter->push(Event(glob->getEvent(part), globalEventCount), part.getID());
   
     //Add the local cell events
-    std::auto_ptr<IDRange> ids(getParticleLocals(part));
-    
-    BOOST_FOREACH(const size_t id2, *ids)
-      addLocalEvent(part, id2);
-
-    //Now add the interaction events
-    ids = getParticleNeighbours(part);
-    BOOST_FOREACH(const size_t id2, *ids)
-      addInteractionEvent(part, id2);
+    getLocalNeighbourhood(part, GNeighbourList::nbHoodFunc
+			  (this, &Scheduler::addLocalEvent));
   }
 
   shared_ptr<Scheduler>
@@ -160,6 +278,23 @@ namespace dynamo {
     sorter->update(Sim->N);
   }
 
+  void
+  Scheduler::rebuildGlobalEvents()
+  {
+    ++globalEventCount;
+
+    BOOST_FOREACH(Particle& part, Sim->particles)
+      {
+	Sim->dynamics->updateParticle(part);
+
+	BOOST_FOREACH(const shared_ptr<Global>& glob, Sim->globals)
+	  if (glob->isInteraction(part))
+	    pushEvent(part, glob->getEvent(part));
+
+	sorter->update(part.getID());
+      }
+  }
+
   void 
   Scheduler::popNextEvent()
   {
@@ -173,6 +308,13 @@ namespace dynamo {
     sorter->push(newevent, part.getID());
   }
 
+  void 
+  Scheduler::pushEvent(const Particle& part,
+		       const GlobalEvent& newevent)
+  {
+    sorter->push(Event(newevent, globalEventCount), part.getID());
+  }
+
   void 
   Scheduler::sort(const Particle& part)
   {
@@ -260,6 +402,11 @@ namespace dynamo {
     */
     const size_t rejectionLimit = 10;
 
+#ifdef DYNAMO_PROFILE
+    EventProfiler::Timer timer(Sim->profiler.eventType(sorter->next_type()));
+    EventProfiler::Cycles start = EventProfiler::cycles();
+#endif
+
     switch (sorter->next_type())
       {
       case INTERACTION:
@@ -273,9 +420,18 @@ namespace dynamo {
 	  sorter->sort();	
 	  lazyDeletionCleanup();
 
+#ifdef DYNAMO_PROFILE
+	  Sim->profiler.sorter.add(EventProfiler::cycles() - start);
+	  start = EventProfiler::cycles();
+#endif
+
 	  //Now recalculate the FEL event
 	  Sim->dynamics->updateParticlePair(p1, p2);       
 	  IntEvent Event(Sim->getEvent(p1, p2));
+
+#ifdef DYNAMO_PROFILE
+	  Sim->profiler.recalculation.add(EventProfiler::cycles() - start);
+#endif
 	
 #ifdef DYNAMO_DEBUG
 	  if (sorter->nextPELEmpty())
@@ -286,10 +442,20 @@ namespace dynamo {
 	      || ((Event.getdt() > sorter->next_dt()) 
 		  && (++_interactionRejectionCounter < rejectionLimit)))
 	    {
+#ifdef DYNAMO_PROFILE
+	      if (Event.getType() != NONE)
+		++Sim->profiler.interactionRejections;
+#endif
 	      this->fullUpdate(p1, p2);
 	      return;
 	    }
 
+#ifdef DYNAMO_PROFILE
+	  if (_interactionRejectionCounter >= rejectionLimit)
+	    ++Sim->profiler.interactionRejectionLimitHits;
+	  timer.alsoRecord(Sim->profiler.interaction(Event.getInteractionID()));
+#endif
+
 	  //Reset the rejection watchdog, we will run an interaction event now
 	  _interactionRejectionCounter = 0;
 		
@@ -334,6 +500,9 @@ namespace dynamo {
 	  //optimise this (they dont need it).
 
 	  //We also don't recheck Global events! (Check, some events might rely on this behavior)
+#ifdef DYNAMO_PROFILE
+	  timer.alsoRecord(Sim->profiler.global(sorter->next_p2()));
+#endif
 	  Sim->globals[sorter->next_p2()]
 	    ->runEvent(Sim->particles[sorter->next_ID()], sorter->next_dt());       	
 	  break;	           
@@ -351,9 +520,18 @@ namespace dynamo {
 	  sorter->sort();
 	  lazyDeletionCleanup();
 
+#ifdef DYNAMO_PROFILE
+	  Sim->profiler.sorter.add(EventProfiler::cycles() - start);
+	  start = EventProfiler::cycles();
+#endif
+
 	  Sim->dynamics->updateParticle(part);
 	  LocalEvent iEvent(Sim->locals[localID]->getEvent(part));
 
+#ifdef DYNAMO_PROFILE
+	  Sim->profiler.recalculation.add(EventProfiler::cycles() - start);
+#endif
+
 	  double next_dt = sorter->next_dt();
 
 	  //Check the recalculated event is valid and not later than
@@ -361,10 +539,20 @@ namespace dynamo {
 	  if ((iEvent.getType() == NONE)
 	      || ((iEvent.getdt() > next_dt) && (++_localRejectionCounter < rejectionLimit)))
 	    {
+#ifdef DYNAMO_PROFILE
+	      if (iEvent.getType() != NONE)
+		++Sim->profiler.localRejections;
+#endif
 	      this->fullUpdate(part);
 	      return;
 	    }
 
+#ifdef DYNAMO_PROFILE
+	  if (_localRejectionCounter >= rejectionLimit)
+	    ++Sim->profiler.localRejectionLimitHits;
+	  timer.alsoRecord(Sim->profiler.local(localID));
+#endif
+
 	  _localRejectionCounter = 0;
 
 #ifdef DYNAMO_DEBUG 
@@ -389,6 +577,9 @@ namespace dynamo {
 	}
       case SYSTEM:
 	{
+#ifdef DYNAMO_PROFILE
+	  timer.alsoRecord(Sim->profiler.system(sorter->next_p2()));
+#endif
 	  Sim->systems[sorter->next_p2()]
 	    ->runEvent();
 	  //This saves the system events rebuilding themselves
@@ -430,6 +621,18 @@ namespace dynamo {
       sorter->push(Event(eevent, eventCount[id]), part1.getID());
   }
 
+  void 
+  Scheduler::addUpToDateInteractionEvent(const Particle& part, 
+					 const size_t& id) const
+  {
+    if (part.getID() == id) return;
+
+    const IntEvent eevent(Sim->getEvent(part, Sim->particles[id]));
+
+    if (eevent.getType() != NONE)
+      sorter->push(Event(eevent, eventCount[id]), part.getID());
+  }
+
   void 
   Scheduler::addLocalEvent(const Particle& part, 
 			   const size_t& id) const
@@ -441,11 +644,17 @@ namespace dynamo {
   void 
   Scheduler::lazyDeletionCleanup()
   {
-    while ((sorter->next_type() == INTERACTION)
-	   && (sorter->next_collCounter2()
-	       != eventCount[sorter->next_p2()]))
+    while (((sorter->next_type() == INTERACTION)
+	    && (sorter->next_collCounter2()
+		!= static_cast<unsigned int>(eventCount[sorter->next_p2()])))
+	   || ((sorter->next_type() == GLOBAL)
+	       && (sorter->next_collCounter2()
+		   != static_cast<unsigned int>(globalEventCount))))
       {
 	//Not valid, update the list
+#ifdef DYNAMO_PROFILE
+	++Sim->profiler.lazyDeletions;
+#endif
 	sorter->popNextEvent();
 	sorter->update(sorter->next_ID());
 	sorter->sort();
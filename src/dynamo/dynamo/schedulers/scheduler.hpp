@@ -20,9 +20,11 @@
 #include <dynamo/schedulers/sorters/sorter.hpp>
 #include <dynamo/interactions/intEvent.hpp>
 #include <dynamo/globals/globEvent.hpp>
+#include <dynamo/globals/neighbourList.hpp>
 #include <magnet/function/delegate.hpp>
 #include <dynamo/ranges/IDRange.hpp>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace magnet { namespace xml { class Node; } }
@@ -80,6 +82,11 @@ namespace dynamo {
     void popNextEvent();
 
     void pushEvent(const Particle&, const Event&);
+
+    /*! \brief Pushes an event of a \ref Global, stamping it with the
+      current global event counter.
+     */
+    void pushEvent(const Particle&, const GlobalEvent&);
   
     void stream(const double& dt) {  sorter->stream(dt); }
   
@@ -94,10 +101,31 @@ namespace dynamo {
   
     void rescaleTimes(const double& scale) { sorter->rescaleTimes(scale); }
 
+    /*! \brief Updates the event list after every particle velocity
+        has been multiplied by a common factor.
+
+      If the dynamics and boundary conditions allow it, the event
+      times are rescaled in place and only the events which do not
+      scale with the velocity are recalculated, otherwise the event
+      list is rebuilt. The particles must have been brought up to date
+      before their velocities were rescaled.
+     */
+    void velocitiesRescaled(double factor);
+
     const shared_ptr<FEL>& getSorter() const { return sorter; }
 
     void rebuildSystemEvents() const;
 
+    /*! \brief Replaces the events of every \ref Global for every
+      particle, leaving all other events in place.
+
+      The global events already in the event lists are lazily deleted
+      by incrementing the global event counter. This is used when a
+      neighbour list changes its cells without the full rebuild of
+      \ref rebuildList (see \ref GNeighbourList::regrid).
+     */
+    void rebuildGlobalEvents();
+
     void addInteractionEvent(const Particle&, const size_t&) const;
     
     void addLocalEvent(const Particle&, const size_t&) const;
@@ -105,6 +133,27 @@ namespace dynamo {
     virtual std::auto_ptr<IDRange> getParticleNeighbours(const Particle&) const = 0;
     virtual std::auto_ptr<IDRange> getParticleNeighbours(const Vector&) const = 0;
     virtual std::auto_ptr<IDRange> getParticleLocals(const Particle&) const = 0;
+
+    /*! \brief Calls the passed function for every particle which may
+      interact with the passed \ref Particle.
+
+      This is the allocation free equivalent of \ref
+      getParticleNeighbours and is the form used in the event loop.
+     */
+    virtual void getParticleNeighbourhood(const Particle&, 
+					  const GNeighbourList::nbHoodFunc&) const = 0;
+
+    /*! \brief Calls the passed function for every particle in the
+      neighbourhood of a point.
+     */
+    virtual void getParticleNeighbourhood(const Vector&, 
+					  const GNeighbourList::nbHoodFunc2&) const = 0;
+
+    /*! \brief Calls the passed function for the ID of every \ref
+      Local which may interact with the passed \ref Particle.
+     */
+    virtual void getLocalNeighbourhood(const Particle&, 
+				       const GNeighbourList::nbHoodFunc&) const = 0;
     
     const std::vector<size_t>& getEventCounts() const { return eventCount; }
 
@@ -114,12 +163,65 @@ namespace dynamo {
      *
      * This is the lazy deletion scheme for interaction events. Any
      * event whose event counter mismatches the particles current event
-     * counter is out of date and should be deleted.
+     * counter is out of date and should be deleted. Global events
+     * are likewise deleted if they are from before the last \ref
+     * rebuildGlobalEvents.
      */
     void lazyDeletionCleanup();
 
+    typedef std::pair<size_t, size_t> IDPair;
+
+    /*! \brief The invalid states found by part of \ref initialise.
+     */
+    struct InvalidStates
+    {
+      //! \brief The pairs of particle IDs in an invalid state.
+      std::vector<IDPair> pairs;
+      //! \brief The (particle ID, Local ID) pairs in an invalid state.
+      std::vector<IDPair> locals;
+
+      //! \brief Appends the states of b to a, for the parallel_reduce.
+      static InvalidStates join(InvalidStates a, const InvalidStates& b)
+      {
+	a.pairs.insert(a.pairs.end(), b.pairs.begin(), b.pairs.end());
+	a.locals.insert(a.locals.end(), b.locals.begin(), b.locals.end());
+	return a;
+      }
+    };
+
+    /*! \brief Quietly validates the state of a particle with its
+      neighbours and Locals, recording the invalid states.
+     */
+    void validateParticle(size_t ID, InvalidStates& invalid) const;
+
+    /*! \brief Adds the events of a particle, as part of the
+      parallel_for of \ref rebuildList.
+
+      Every particle must already be up to date. Only the event list
+      of this particle is written.
+     */
+    void addParticleEvents(size_t ID) const;
+
+    /*! \brief Tests if the \ref Simulation::threadPool has threads
+      to split the work over.
+     */
+    bool threaded() const;
+
+    /*! \brief Adds the events of a particle with the Globals and
+      Locals.
+     */
+    void addGlobalAndLocalEvents(const Particle&) const;
+
+    /*! \brief Neighbourhood callback used by \ref addParticleEvents,
+      which (unlike \ref addInteractionEvent) does not update the
+      neighbour.
+     */
+    void addUpToDateInteractionEvent(const Particle&, const size_t&) const;
+
     mutable shared_ptr<FEL> sorter;
     mutable std::vector<size_t> eventCount;
+    //! \brief The number of times every global event has been invalidated.
+    size_t globalEventCount;
   
     size_t _interactionRejectionCounter;
     size_t _localRejectionCounter;
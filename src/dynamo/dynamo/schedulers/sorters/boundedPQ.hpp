@@ -262,14 +262,20 @@ namespace dynamo {
 
     inline void rescaleTimes(const double& factor)
     {
+      //Scaling the calendar with the events would leave it
+      //calibrated for the old event rate, so the events are instead
+      //sorted into a newly calibrated calendar.
       BOOST_FOREACH(eventQEntry& dat, Min)
-	dat.data.rescaleTimes(factor);
-
-      pecTime *= factor;
-    
-      scale /= factor;
-      listWidth = nlists/scale;
+	{
+	  dat.data.stream(pecTime);
+	  dat.data.rescaleTimes(factor);
+	}
 
+      pecTime = 0;
+      currentIndex = 0;
+      NP = 0;
+      linearLists.clear();
+      rebuild();
     }
 
   private:
@@ -22,7 +22,9 @@
 #include <dynamo/locals/localEvent.hpp>
 #include <dynamo/globals/global.hpp>
 #include <boost/foreach.hpp>
+#include <boost/static_assert.hpp>
 #include <algorithm>
+#include <limits>
 
 namespace dynamo {
   /*! \brief A generic event type, which the more specialised events
@@ -36,46 +38,54 @@ namespace dynamo {
       events cause the system to be moved forward in time and the
       events for the particle are recalculated. This can all be
       handled by the scheduler.
+
+      The event counter and partner ID are stored as 32 bit values to
+      pack the Event into 24 bytes. The event counter is only tested
+      for equality by the lazy deletion scheme (see \ref
+      Scheduler::lazyDeletionCleanup), so only its low 32 bits are
+      kept. Global events store the global event counter of the
+      Scheduler instead of a particle's event counter.
    */
   class Event
   {
   public:   
     inline Event():
       dt(HUGE_VAL),
-      collCounter2(std::numeric_limits<unsigned long>::max()),
-      type(NONE),
-      p2(std::numeric_limits<size_t>::max())    
+      collCounter2(std::numeric_limits<unsigned int>::max()),
+      p2(std::numeric_limits<unsigned int>::max()),
+      type(NONE)
     {}
 
     inline Event(const double& ndt, const EEventType& nT, 
 		 const size_t& nID2, const unsigned long & nCC2) throw():
       dt(ndt),
       collCounter2(nCC2),
-      type(nT),
-      p2(nID2)
+      p2(nID2),
+      type(nT)
     {}
 
     inline Event(const IntEvent& coll, const unsigned long& nCC2) throw():
       dt(coll.getdt()),
       collCounter2(nCC2),
-      type(INTERACTION),
-      p2(coll.getParticle2ID())
+      p2(coll.getParticle2ID()),
+      type(INTERACTION)
     {
       if (coll.getType() == RECALCULATE) type = RECALCULATE;
     }
 
-    inline Event(const GlobalEvent& coll) throw():
+    inline Event(const GlobalEvent& coll, const unsigned long& nCC2) throw():
       dt(coll.getdt()),
-      type(GLOBAL),
-      p2(coll.getGlobalID())
+      collCounter2(nCC2),
+      p2(coll.getGlobalID()),
+      type(GLOBAL)
     {
       if (coll.getType() == RECALCULATE) type = RECALCULATE;
     }
 
     inline Event(const LocalEvent& coll) throw():
       dt(coll.getdt()),
-      type(LOCAL),
-      p2(coll.getLocalID())
+      p2(coll.getLocalID()),
+      type(LOCAL)
     {
       if (coll.getType() == RECALCULATE) type = RECALCULATE;
     }
@@ -89,8 +99,10 @@ namespace dynamo {
     inline void stream(const double& ndt) throw() { dt -= ndt; }
 
     mutable double dt;
-    unsigned long collCounter2;
+    unsigned int collCounter2;
+    unsigned int p2;
     EEventType type;
-    size_t p2;  
   };
+
+  BOOST_STATIC_ASSERT(sizeof(Event) == 24);
 }
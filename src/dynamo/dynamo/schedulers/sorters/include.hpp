@@ -17,5 +17,7 @@
 
 #include <dynamo/schedulers/sorters/cbt.hpp>
 #include <dynamo/schedulers/sorters/boundedPQ.hpp>
+#include <dynamo/schedulers/sorters/ladderQueue.hpp>
+#include <dynamo/schedulers/sorters/pooledCBT.hpp>
 #include <dynamo/schedulers/sorters/MinMaxHeapPEL.hpp>
 #include <dynamo/schedulers/sorters/singleeventPEL.hpp>
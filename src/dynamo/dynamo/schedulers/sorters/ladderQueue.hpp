@@ -0,0 +1,611 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <dynamo/schedulers/sorters/event.hpp>
+#include <dynamo/schedulers/sorters/sorter.hpp>
+#include <dynamo/schedulers/sorters/heapPEL.hpp>
+#include <dynamo/units/units.hpp>
+#include <dynamo/simulation.hpp>
+#include <magnet/exception.hpp>
+#include <magnet/xmlwriter.hpp>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+#ifdef DYNAMO_DEBUG
+#include <boost/math/special_functions/fpclassify.hpp>
+#endif
+
+namespace dynamo {
+  /*! \brief An adaptive ladder queue Future Event List.
+
+    This is an implementation of the ladder queue of Tang, Goh and
+    Thng (ACM TOMACS 15, 175 (2005)), adapted to sort the Particle
+    Event Lists. Unlike \ref FELBoundedPQ, the bucket widths are not
+    fixed by a snapshot of the queue taken in init(). Instead, every
+    "epoch" the queue sizes its buckets from the events it actually
+    contains, and any bucket that becomes overfull is split into a
+    finer "rung" of buckets. This keeps the push/pop cost O(1)
+    amortised even when the event rate drifts strongly during the
+    simulation (compression, cooling granular gases, gravity).
+
+    The queue is made up of three parts:
+
+    - The top: an unsorted list of the events furthest in the
+      future (beyond \ref _topStart).
+
+    - The ladder: a stack of rungs of buckets (unsorted linked
+      lists), each rung covering one bucket of the rung above it.
+
+    - The bottom: a complete binary tree holding the events of the
+      bucket currently being processed.
+
+    Events are stored against absolute times, so stream() is O(1).
+    The times are renormalised once per epoch, when the ladder is
+    rebuilt from the top list.
+   */
+  template<typename T = PELHeap>
+  class FELLadderQueue: public FEL
+  {
+  private:
+    //! \brief Location flags stored in eventQEntry::rung.
+    enum { BOTTOM = -1, TOP = -2, INFINITE = -3, BOTTOM_INFINITE = -4 };
+
+    //! \brief The maximum number of rungs which can be spawned.
+    static const size_t maxRungs = 8;
+
+    /*! \brief The maximum number of events in a bucket before it is
+      split into a new rung instead of being sorted in the bottom.
+     */
+    static const size_t bucketThreshold = 50;
+
+    struct eventQEntry
+    {
+      T data;
+      int next;
+      int previous;
+      int rung;
+      size_t bucket;
+    };
+
+    struct Rung
+    {
+      double start;
+      double width;
+      size_t current;
+      size_t nbuckets;
+      std::vector<int> heads;
+      std::vector<size_t> counts;
+    };
+
+    std::vector<eventQEntry> Min;
+
+    //Top list
+    int _topHead;
+    size_t _topCount;
+    double _topStart;
+
+    //Events with no finite time are kept out of the ladder entirely
+    int _infHead;
+    bool _infInBottom;
+
+    //Ladder
+    std::vector<Rung> _rungs;
+    size_t _nRungs;
+
+    //Bottom (binary tree) variables
+    std::vector<unsigned long> CBT;
+    std::vector<unsigned long> Leaf;
+    size_t NP, N;
+
+    double pecTime;
+
+    //Scratch space used to size the first rung
+    std::vector<double> _times;
+
+    //Statistics
+    size_t _epochs;
+    size_t _rungsSpawned;
+    size_t _maxRungsUsed;
+
+  public:
+    FELLadderQueue(const dynamo::Simulation* const& SD):
+      FEL(SD, "LadderQueue"),
+      _rungs(maxRungs),
+      _epochs(0),
+      _rungsSpawned(0),
+      _maxRungsUsed(0)
+    { clear(); }
+
+    ~FELLadderQueue()
+    {
+      dout << "Epochs = " << _epochs
+	   << ", Rungs spawned = " << _rungsSpawned
+	   << ", Maximum rung depth = " << _maxRungsUsed << std::endl;
+    }
+
+    void resize(const size_t& a)
+    {
+      clear();
+      N = a;
+      CBT.resize(2 * N);
+      Leaf.resize(N + 1);
+      Min.resize(N + 1);
+    }
+
+    void clear()
+    {
+      CBT.clear();
+      Leaf.clear();
+      Min.clear();
+      N = 0;
+      pecTime = 0.0;
+      resetQueue();
+    }
+
+    inline void stream(const double& ndt) { pecTime += ndt; }
+
+    void init()
+    {
+      dout << "Sorting all events, please wait..." << std::endl;
+      rebuild();
+      dout << "Ready for simulation." << std::endl;
+    }
+
+    void rebuild()
+    {
+      resetQueue();
+
+      for (unsigned long i = 1; i <= N; i++)
+	insertInEventQ(i);
+
+      orderNextEvent();
+    }
+
+    inline void push(const Event& tmpVal, const size_t& pID)
+    {
+#ifdef DYNAMO_DEBUG
+      if (boost::math::isnan(tmpVal.dt))
+	M_throw() << "NaN value pushed into the sorter! Should be Inf I guess?";
+#endif
+
+      tmpVal.dt += pecTime;
+      Min[pID + 1].data.push(tmpVal);
+    }
+
+    inline void update(const size_t& pID)
+    {
+      deleteFromEventQ(pID + 1);
+      insertInEventQ(pID + 1);
+    }
+
+    inline void clearPEL(const size_t& ID) { Min[ID+1].data.clear(); }
+    inline void popNextPELEvent(const size_t& ID) { Min[ID+1].data.pop(); }
+    inline void popNextEvent() { Min[CBT[1]].data.pop(); }
+    inline bool nextPELEmpty() const { return Min[CBT[1]].data.empty(); }
+
+    inline size_t next_ID() const { return CBT[1] - 1; }
+    inline EEventType next_type() const { return Min[CBT[1]].data.top().type; }
+    inline unsigned long next_collCounter2() const { return Min[CBT[1]].data.top().collCounter2; }
+    inline size_t next_p2() const { return Min[CBT[1]].data.top().p2; }
+
+    inline double next_dt() const { return Min[CBT[1]].data.getdt() - pecTime; }
+
+    inline void sort() { orderNextEvent(); }
+
+    /*! \brief Rescales the event times.
+
+      All bucket boundaries are invalidated by the rescaling, so the
+      ladder is rebuilt from scratch.
+     */
+    inline void rescaleTimes(const double& factor)
+    {
+      BOOST_FOREACH(eventQEntry& dat, Min)
+	dat.data.rescaleTimes(factor);
+
+      pecTime *= factor;
+      rebuild();
+    }
+
+  private:
+    //! \brief Empties the ladder structure, without touching the PELs.
+    void resetQueue()
+    {
+      _topHead = -1;
+      _topCount = 0;
+      _topStart = -HUGE_VAL;
+      _infHead = -1;
+      _infInBottom = false;
+      _nRungs = 0;
+      NP = 0;
+      if (!CBT.empty()) CBT[1] = 0;
+    }
+
+    inline void linkIn(int& head, int p)
+    {
+      Min[p].previous = -1;
+      Min[p].next = head;
+      if (head != -1) Min[head].previous = p;
+      head = p;
+    }
+
+    inline void unlink(int& head, int p)
+    {
+      const int prev = Min[p].previous, next = Min[p].next;
+      if (prev == -1)
+	head = next;
+      else
+	Min[prev].next = next;
+
+      if (next != -1)
+	Min[next].previous = prev;
+    }
+
+    inline void insertInRung(size_t r, int p, double t)
+    {
+      Rung& rung = _rungs[r];
+      double box = (t - rung.start) / rung.width;
+      const size_t b = (box < rung.current) ? rung.current : ((box >= rung.nbuckets) ? (rung.nbuckets - 1) : size_t(box));
+      Min[p].rung = r;
+      Min[p].bucket = b;
+      linkIn(rung.heads[b], p);
+      ++rung.counts[b];
+    }
+
+    inline void insertInEventQ(int p)
+    {
+      const double t = Min[p].data.getdt();
+
+      if (t == HUGE_VAL)
+	{
+	  linkIn(_infHead, p);
+	  if (_infInBottom)
+	    {
+	      Min[p].rung = BOTTOM_INFINITE;
+	      Insert(p);
+	    }
+	  else
+	    Min[p].rung = INFINITE;
+	  return;
+	}
+
+      //A real event has arrived, the infinite events cannot stay in
+      //the bottom
+      if (_infInBottom) removeInfiniteFromBottom();
+
+      if (t >= _topStart)
+	{
+	  Min[p].rung = TOP;
+	  linkIn(_topHead, p);
+	  ++_topCount;
+	  return;
+	}
+
+      for (size_t r(0); r < _nRungs; ++r)
+	if (t >= _rungs[r].start + _rungs[r].current * _rungs[r].width)
+	  {
+	    insertInRung(r, p, t);
+	    return;
+	  }
+
+      Min[p].rung = BOTTOM;
+      Insert(p);
+    }
+
+    inline void deleteFromEventQ(int p)
+    {
+      switch (Min[p].rung)
+	{
+	case BOTTOM:
+	  Delete(p);
+	  break;
+	case TOP:
+	  unlink(_topHead, p);
+	  --_topCount;
+	  break;
+	case BOTTOM_INFINITE:
+	  Delete(p);
+	  unlink(_infHead, p);
+	  break;
+	case INFINITE:
+	  unlink(_infHead, p);
+	  break;
+	default:
+	  {
+	    Rung& rung = _rungs[Min[p].rung];
+	    unlink(rung.heads[Min[p].bucket], p);
+	    --rung.counts[Min[p].bucket];
+	  }
+	}
+    }
+
+    void removeInfiniteFromBottom()
+    {
+      for (int p = _infHead; p != -1; p = Min[p].next)
+	{
+	  Delete(p);
+	  Min[p].rung = INFINITE;
+	}
+      _infInBottom = false;
+    }
+
+    /*! \brief Start a new epoch by building the first rung from the
+      top list.
+
+      The events are also renormalised here, as the ladder and
+      bottom are empty.
+     */
+    void buildFirstRung()
+    {
+      ++_epochs;
+
+      if (pecTime != 0)
+	{
+	  BOOST_FOREACH(eventQEntry& dat, Min)
+	    dat.data.stream(pecTime);
+	  pecTime = 0;
+	}
+
+      _times.clear();
+      double minVal(HUGE_VAL), maxVal(-HUGE_VAL);
+      for (int p = _topHead; p != -1; p = Min[p].next)
+	{
+	  const double t = Min[p].data.getdt();
+	  _times.push_back(t);
+	  minVal = std::min(minVal, t);
+	  maxVal = std::max(maxVal, t);
+	}
+
+      //The rung is sized using the median event time rather than the
+      //latest. Some events are scheduled at enormous (but finite)
+      //times, which would otherwise stretch every bucket.
+      std::nth_element(_times.begin(), _times.begin() + (_times.size() - 1) / 2, _times.end());
+      const double median = _times[(_times.size() - 1) / 2];
+      const double span = (median > minVal) ? std::min(maxVal - minVal, 4 * (median - minVal)) : (maxVal - minVal);
+
+      int p = _topHead;
+      _topHead = -1;
+      const size_t count = _topCount;
+      _topCount = 0;
+
+      const double width = span / count;
+
+      if (!(width > 0) || (minVal + width == minVal))
+	{
+	  //All the events are effectively simultaneous, just sort
+	  //them in the bottom
+	  _topStart = maxVal;
+	  while (p != -1)
+	    {
+	      const int next = Min[p].next;
+	      Min[p].rung = BOTTOM;
+	      Insert(p);
+	      p = next;
+	    }
+	  return;
+	}
+
+      Rung& rung = _rungs[0];
+      rung.start = minVal;
+      rung.width = width;
+      rung.current = 0;
+      rung.nbuckets = count + 1;
+      rung.heads.assign(rung.nbuckets, -1);
+      rung.counts.assign(rung.nbuckets, 0);
+      _nRungs = 1;
+      _topStart = rung.start + rung.nbuckets * rung.width;
+
+      while (p != -1)
+	{
+	  const int next = Min[p].next;
+	  const double t = Min[p].data.getdt();
+	  if (t >= _topStart)
+	    {
+	      //Outliers are left for a later epoch
+	      Min[p].rung = TOP;
+	      linkIn(_topHead, p);
+	      ++_topCount;
+	    }
+	  else
+	    insertInRung(0, p, t);
+	  p = next;
+	}
+    }
+
+    /*! \brief Split a bucket of the lowest rung into a new rung.
+
+      \return false if the bucket cannot be split further.
+     */
+    bool spawnRung(size_t b)
+    {
+      if (_nRungs == maxRungs) return false;
+
+      Rung& parent = _rungs[_nRungs - 1];
+      const size_t count = parent.counts[b];
+      const double start = parent.start + b * parent.width;
+      const double width = parent.width / count;
+
+      if (!(width > 0) || (start + width == start)) return false;
+
+      Rung& rung = _rungs[_nRungs];
+      rung.start = start;
+      rung.width = width;
+      rung.current = 0;
+      rung.nbuckets = count;
+      rung.heads.assign(rung.nbuckets, -1);
+      rung.counts.assign(rung.nbuckets, 0);
+
+      int p = parent.heads[b];
+      parent.heads[b] = -1;
+      parent.counts[b] = 0;
+      parent.current = b + 1;
+
+      const size_t r = _nRungs++;
+      while (p != -1)
+	{
+	  const int next = Min[p].next;
+	  insertInRung(r, p, Min[p].data.getdt());
+	  p = next;
+	}
+
+      ++_rungsSpawned;
+      _maxRungsUsed = std::max(_maxRungsUsed, _nRungs);
+      return true;
+    }
+
+    /*! \brief Makes sure the bottom contains the next events.
+     */
+    inline void orderNextEvent()
+    {
+      while (NP == 0)
+	{
+	  if (!_nRungs)
+	    {
+	      if (_topCount)
+		{
+		  buildFirstRung();
+		  continue;
+		}
+
+	      //The queue only holds events which will never happen. Put
+	      //them in the bottom so that the scheduler can see this.
+	      if ((_infHead != -1) && !_infInBottom)
+		{
+		  for (int p = _infHead; p != -1; p = Min[p].next)
+		    {
+		      Min[p].rung = BOTTOM_INFINITE;
+		      Insert(p);
+		    }
+		  _infInBottom = true;
+		}
+	      return;
+	    }
+
+	  Rung& rung = _rungs[_nRungs - 1];
+	  while ((rung.current < rung.nbuckets) && (rung.heads[rung.current] == -1))
+	    ++rung.current;
+
+	  if (rung.current == rung.nbuckets)
+	    {
+	      --_nRungs;
+	      continue;
+	    }
+
+	  const size_t b = rung.current;
+	  if ((rung.counts[b] > bucketThreshold) && spawnRung(b))
+	    continue;
+
+	  //Transfer the bucket to the bottom
+	  int p = rung.heads[b];
+	  rung.heads[b] = -1;
+	  rung.counts[b] = 0;
+	  ++rung.current;
+
+	  while (p != -1)
+	    {
+	      const int next = Min[p].next;
+	      Min[p].rung = BOTTOM;
+	      Insert(p);
+	      p = next;
+	    }
+
+	  //Exhausted rungs are removed straight away, so that inserts
+	  //never land in a bucket behind the current one
+	  while (_nRungs && (_rungs[_nRungs - 1].current == _rungs[_nRungs - 1].nbuckets))
+	    --_nRungs;
+	}
+    }
+
+    ///////////////////////////BINARY TREE IMPLEMENTATION
+    inline void UpdateCBT(const unsigned int& i)
+    {
+      unsigned int f = Leaf[i] / 2;
+
+      for(; (f > 0) && (CBT[f] == i); f /= 2)
+	{
+	  unsigned int l = CBT[f*2],
+	    r = CBT[f*2+1];
+	  CBT[f] = (Min[r].data > Min[l].data) ? l : r;
+	}
+
+      //Walk up finding the winners till it doesn't change or you hit
+      //the top of the tree
+      for( ; f>0; f /= 2)
+	{
+	  unsigned int w = CBT[f], /* old winner */
+	    l = CBT[f*2],
+	    r = CBT[f*2+1];
+
+	  CBT[f] = (Min[r].data > Min[l].data) ? l : r;
+
+	  if (CBT[f] == w) return; /* end of the event time comparisons */
+	}
+    }
+
+    inline void Insert(const unsigned int& i)
+    {
+      if (NP)
+	{
+	  int j = CBT[NP];
+	  CBT [NP*2] = j;
+	  CBT [NP*2+1] = i;
+	  Leaf[j] = NP*2;
+	  Leaf[i]= NP*2+1;
+	  ++NP;
+	  UpdateCBT(j);
+	}
+      else
+	{
+	  CBT[1]=i;
+	  ++NP;
+	}
+    }
+
+    inline void Delete(const unsigned int& i)
+    {
+      if (NP < 2) { CBT[1]=0; Leaf[0]=1; --NP; return; }
+
+      int l = NP * 2 - 1;
+
+      if (CBT[l-1] == i)
+	{
+	  Leaf[CBT[l]] = l/2;
+	  CBT[l/2] =CBT[l];
+	  UpdateCBT(CBT[l]);
+	  --NP;
+	  return;
+	}
+
+      Leaf[CBT[l-1]] = l/2;
+      CBT[l/2] = CBT[l-1];
+      UpdateCBT(CBT[l-1]);
+
+      if (CBT[l] != i)
+	{
+	  CBT[Leaf[i]] = CBT[l];
+	  Leaf[CBT[l]] = Leaf[i];
+	  UpdateCBT(CBT[l]);
+	}
+
+      --NP;
+    }
+
+    virtual void outputXML(magnet::xml::XmlStream& XML) const
+    { XML << magnet::xml::attr("Type") << "LadderQueue"; }
+  };
+}
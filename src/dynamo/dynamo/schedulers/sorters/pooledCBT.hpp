@@ -0,0 +1,254 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <dynamo/schedulers/sorters/event.hpp>
+#include <dynamo/schedulers/sorters/sorter.hpp>
+#include <magnet/memory/aligned_allocator.hpp>
+#include <magnet/exception.hpp>
+#include <magnet/xmlwriter.hpp>
+#include <vector>
+#include <cmath>
+
+#ifdef DYNAMO_DEBUG
+#include <boost/math/special_functions/fpclassify.hpp>
+#endif
+
+namespace dynamo {
+  /*! \brief A Future Event List which stores all of the Particle
+    Event Lists in a single pooled slab.
+
+    Each particle owns a fixed slot of Size events in one contiguous
+    array. The events of a slot are kept sorted, so the next event of
+    a particle is always the first entry of its slot. If a slot
+    overflows, the latest event is discarded and the last remaining
+    event is marked as a RECALCULATE event (as in \ref PELMinMax).
+    The particles are then sorted using a complete binary tree of
+    their slots. Clearing and pushing events never allocates memory.
+
+    The event times are stored as absolute times, \f$t\f$, related
+    to the time until the event by \f$dt=(t-t_{origin})\,s\f$. This
+    makes stream() and rescaleTimes() O(1) operations, as they only
+    alter the origin, \f$t_{origin}\f$, and scale, \f$s\f$. The
+    stored times are renormalised once every N streams to limit
+    round off error.
+
+    \tparam Size The number of events stored for each particle.
+   */
+  template<size_t Size = 4>
+  class FELPooledCBT: public FEL
+  {
+  private:
+    typedef std::vector<Event, magnet::memory::AlignedAllocator<Event, 64> > Slab;
+
+    Slab _slab;
+    std::vector<unsigned char> _count;
+    std::vector<unsigned long> CBT;
+    std::vector<unsigned long> Leaf;
+    unsigned long NP, N, nUpdate;
+
+    double _origin;
+    double _scale;
+
+  public:
+    FELPooledCBT(const dynamo::Simulation* const& SD):
+      FEL(SD, "PooledCBT")
+    { clear(); }
+
+    void resize(const size_t& a)
+    {
+      clear();
+      N = a;
+      CBT.resize(2 * N);
+      Leaf.resize(N + 1);
+      _slab.resize((N + 1) * Size);
+      _count.resize(N + 1);
+      for (size_t i(0); i <= N; ++i)
+	clearSlot(i);
+    }
+
+    void clear()
+    {
+      _slab.clear();
+      _count.clear();
+      CBT.clear();
+      Leaf.clear();
+      N = 0;
+      NP = 0;
+      nUpdate = 0;
+      _origin = 0;
+      _scale = 1;
+    }
+
+    void init()
+    {
+      NP = 0;
+      for (unsigned long i = 1; i <= N; i++)
+	Insert(i);
+    }
+
+    void rebuild() { init(); }
+
+    inline void stream(const double& dt)
+    {
+      _origin += dt / _scale;
+
+      if (N && !(++nUpdate % N))
+	renormalise();
+    }
+
+    inline void push(const Event& tmpVal, const size_t& pID)
+    {
+#ifdef DYNAMO_DEBUG
+      if (boost::math::isnan(tmpVal.dt))
+	M_throw() << "NaN value pushed into the sorter! Should be Inf I guess?";
+#endif
+
+      if (tmpVal.type == NONE) return;
+
+      Event newEvent(tmpVal);
+      newEvent.dt = _origin + newEvent.dt / _scale;
+
+      const size_t slot = pID + 1;
+      Event* const begin = &_slab[slot * Size];
+      size_t j = _count[slot];
+      const bool full = (j == Size);
+
+      if (full)
+	{
+	  //The slot is full, so the latest event is lost and the
+	  //particle must be recalculated once the slot is exhausted
+	  if (!(newEvent.dt < begin[Size - 1].dt))
+	    {
+	      begin[Size - 1].type = RECALCULATE;
+	      return;
+	    }
+	  --j;
+	}
+      else
+	++_count[slot];
+
+      for (; (j > 0) && (begin[j - 1].dt > newEvent.dt); --j)
+	begin[j] = begin[j - 1];
+
+      begin[j] = newEvent;
+
+      if (full) begin[Size - 1].type = RECALCULATE;
+    }
+
+    inline void update(const size_t& a) { UpdateCBT(a + 1); }
+
+    inline void clearPEL(const size_t& ID) { clearSlot(ID + 1); }
+    inline void popNextPELEvent(const size_t& ID) { popSlot(ID + 1); }
+    inline void popNextEvent() { popSlot(CBT[1]); }
+    inline bool nextPELEmpty() const { return !_count[CBT[1]]; }
+
+    inline size_t next_ID() const { return CBT[1] - 1; }
+    inline EEventType next_type() const { return top(CBT[1]).type; }
+    inline unsigned long next_collCounter2() const { return top(CBT[1]).collCounter2; }
+    inline size_t next_p2() const { return top(CBT[1]).p2; }
+
+    inline double next_dt() const { return (top(CBT[1]).dt - _origin) * _scale; }
+
+    inline void sort() {}
+
+    inline void rescaleTimes(const double& factor) { _scale *= factor; }
+
+  private:
+    inline const Event& top(size_t slot) const { return _slab[slot * Size]; }
+
+    inline void clearSlot(size_t slot)
+    {
+      _count[slot] = 0;
+      _slab[slot * Size].dt = HUGE_VAL;
+    }
+
+    inline void popSlot(size_t slot)
+    {
+      Event* const begin = &_slab[slot * Size];
+      const size_t n = --_count[slot];
+      for (size_t j(0); j < n; ++j)
+	begin[j] = begin[j + 1];
+
+      if (!n) begin[0].dt = HUGE_VAL;
+    }
+
+    /*! \brief Convert the stored times back to times relative to the
+      current time.
+
+      This is a monotonic transformation of every stored time, so
+      the binary tree remains valid.
+     */
+    void renormalise()
+    {
+      for (size_t slot(0); slot <= N; ++slot)
+	for (size_t j(0); j < _count[slot]; ++j)
+	  {
+	    Event& event = _slab[slot * Size + j];
+	    event.dt = (event.dt - _origin) * _scale;
+	  }
+
+      _origin = 0;
+      _scale = 1;
+    }
+
+    inline bool later(unsigned long a, unsigned long b) const
+    { return _slab[a * Size].dt > _slab[b * Size].dt; }
+
+    ///////////////////////////BINARY TREE IMPLEMENTATION
+    inline void UpdateCBT(unsigned int i)
+    {
+      unsigned int f = Leaf[i]/2,l,r,w;
+
+      //While i is at the top we must keep walking up, cause i could win
+      //or could not
+      for(; f > 0; f = f / 2)
+	{
+	  if (CBT[f] != i) break; /* jumps to the next "for" */
+	  l = CBT[f*2];
+	  r = CBT[f*2+1];
+	  CBT[f] = later(r, l) ? l : r;
+	}
+
+      //Walk up finding the winners till it doesn't change or you hit
+      //the top of the tree
+      for( ; f>0; f=f/2)
+	{
+	  w = CBT[f]; /* old winner */
+	  l = CBT[f*2];
+	  r = CBT[f*2+1];
+	  CBT[f] = later(r, l) ? l : r;
+	  if (CBT[f] == w ) return; /* end of the event time comparisons */
+	}
+    }
+
+    inline void Insert(unsigned int i)
+    {
+      if (NP == 0) {CBT[1]=i; NP++; return;}
+      int j = CBT[NP];
+      CBT [NP*2] = j;
+      CBT [NP*2+1] = i;
+      Leaf[j] = NP*2;
+      Leaf[i]= NP*2+1;
+      ++NP;
+      UpdateCBT (j);
+    }
+
+    virtual void outputXML(magnet::xml::XmlStream& XML) const
+    { XML << magnet::xml::attr("Type") << "PooledCBT"; }
+  };
+}
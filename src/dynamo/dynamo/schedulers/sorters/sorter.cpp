@@ -48,6 +48,10 @@ namespace dynamo {
       return shared_ptr<FEL>(new FELBoundedPQ<PELMinMax<8> >(Sim));
     else if (std::string(XML.getAttribute("Type")) == std::string("CBT"))
       return shared_ptr<FEL>(new FELCBT(Sim));
+    else if (std::string(XML.getAttribute("Type")) == std::string("LadderQueue"))
+      return shared_ptr<FEL>(new FELLadderQueue<>(Sim));
+    else if (std::string(XML.getAttribute("Type")) == std::string("PooledCBT"))
+      return shared_ptr<FEL>(new FELPooledCBT<>(Sim));
     else 
       M_throw() << "Unknown type of Sorter encountered";
   }
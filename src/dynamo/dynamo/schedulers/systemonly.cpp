@@ -95,4 +95,19 @@ namespace dynamo {
   {
     return std::auto_ptr<IDRange>(new IDRangeNone());
   }
+
+  void
+  SSystemOnly::getParticleNeighbourhood(const Particle&,
+					const GNeighbourList::nbHoodFunc&) const
+  {}
+
+  void
+  SSystemOnly::getParticleNeighbourhood(const Vector&,
+					const GNeighbourList::nbHoodFunc2&) const
+  {}
+
+  void
+  SSystemOnly::getLocalNeighbourhood(const Particle&,
+				     const GNeighbourList::nbHoodFunc&) const
+  {}
 }
@@ -29,15 +29,23 @@
 #include <dynamo/interactions/interaction.hpp>
 #include <dynamo/outputplugins/0partproperty/misc.hpp>
 #include <dynamo/globals/PBCSentinel.hpp>
+#include <dynamo/ranges/IDRange.hpp>
+#include <dynamo/ranges/IDPairRange.hpp>
+#include <dynamo/checkpoint.hpp>
+#include <dynamo/particlestream.hpp>
+#include <dynamo/asyncwriter.hpp>
+#include <dynamo/eventkernel.hpp>
+#include <magnet/stream/bzip2.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/iostreams/device/file.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
-#include <boost/iostreams/filter/bzip2.hpp>
 #include <boost/iostreams/chain.hpp>
 #include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <dynamo/BC/BC.hpp>
 #include <iomanip>
+#include <limits>
 
 //! The configuration file version, a version mismatch prevents an XML file load.
 static const std::string configFileVersion("1.5.0");
@@ -53,13 +61,15 @@ namespace dynamo
     nextPrintEvent(0),
     N(0),
     primaryCellSize(1,1,1),
+    threadPool(NULL),
     ranGenerator(static_cast<unsigned>(std::time(0))),
     normal_sampler(ranGenerator, boost::normal_distribution<double>()),
     uniform_sampler(ranGenerator, boost::uniform_01<double>()),
     lastRunMFT(0.0),
     simID(0),
     replexExchangeNumber(0),
-    status(START)
+    status(START),
+    _firstUnresolvedInteraction(0)
   {}
 
   namespace {
@@ -76,6 +86,50 @@ namespace dynamo
 	return (*lhs) < (*rhs);
       }
     };
+
+    /*! \brief A configuration queued by
+        Simulation::writeXMLfileAsync.
+
+      The XML outside of the particle data is read from many objects
+      but is small, so it is formatted before the simulation carries
+      on. The particle data is copied and only formatted by the
+      AsyncWriter.
+     */
+    struct ConfigSnapshot: public AsyncWriter::Source
+    {
+      //! The XML before the ParticleData tag.
+      std::string head;
+      Dynamics::ParticleSnapshot particles;
+      //! The precision the head was written with.
+      std::streamsize precision;
+
+      size_t size() const
+      {
+	return head.size()
+	  + particles.particles.size() * sizeof(Particle)
+	  + particles.orientationData.size() * sizeof(Dynamics::rotData)
+	  + particles.properties.size() * particles.particles.size() * sizeof(double);
+      }
+
+      void write(std::ostream& os) const
+      {
+	os << head;
+
+	std::ostringstream xml;
+	{
+	  magnet::xml::XmlStream XML(xml);
+	  XML.setFormatXML(true);
+	  //The DynamOconfig tag is already in the head. It is opened
+	  //again, and its text discarded, so that the particle data is
+	  //indented to match and the tag is closed after it.
+	  XML << std::scientific << std::setprecision(precision)
+	      << magnet::xml::tag("DynamOconfig") << magnet::xml::chardata();
+	  xml.str("");
+	  Dynamics::outputParticleSnapshot(XML, particles);
+	}
+	os << xml.str();
+      }
+    };
   }
 
   void
@@ -103,21 +157,12 @@ namespace dynamo
     BOOST_FOREACH(shared_ptr<Species>& ptr, species)
       ptr->initialise();
 
-    unsigned int count = 0;
-    //Now confirm that every species has only one species type!
-    BOOST_FOREACH(const Particle& part, particles)
-      {
-	BOOST_FOREACH(shared_ptr<Species>& ptr, species)
-	  if (ptr->isSpecies(part)) { count++; break; }
-	
-	if (count < 1)
-	  M_throw() << "Particle ID=" << part.getID() << " has no species";
-	
-	if (count > 1)
-	  M_throw() << "Particle ID=" << part.getID() << " has more than one species";
-	count = 0;
-      }
-    
+    //Build the species/interaction tables, this also confirms that
+    //every particle has only one species type!
+    rebuildLookupTables();
+    _particleAddedToSim.connect(boost::bind(&Simulation::rebuildLookupTables, this));
+    _particleRemovedFromSim.connect(boost::bind(&Simulation::rebuildLookupTables, this));
+
     //Now confirm that there are not more counts from each species
     //than there are particles
     {
@@ -161,6 +206,10 @@ namespace dynamo
 	}
     }
 
+    _eventKernel = EventKernel::getKernel(this);
+    if (_eventKernel)
+      dout << "Using a specialised kernel to predict the Interaction events" << std::endl;
+
     {
       size_t ID=0;
       //Must be initialised before globals. Neighbour lists are
@@ -202,11 +251,20 @@ namespace dynamo
   IntEvent 
   Simulation::getEvent(const Particle& p1, const Particle& p2) const
   {
-    BOOST_FOREACH(const shared_ptr<Interaction>& ptr, interactions)
-      if (ptr->isInteraction(p1,p2))
-	return ptr->getEvent(p1,p2);
-    
-    M_throw() << "Could not find the right interaction to test for";
+    if (_eventKernel && _eventKernel->isValid())
+      {
+	const IntEvent event = _eventKernel->getEvent(p1, p2);
+#ifdef DYNAMO_DEBUG
+	const IntEvent generic = getInteraction(p1, p2)->getEvent(p1, p2);
+	if ((event.getType() != generic.getType()) || (event.getdt() != generic.getdt()))
+	  M_throw() << "The event kernel predicted a " << event.getType() << " event in " << event.getdt()
+		    << ", but the Interaction predicted a " << generic.getType() << " event in " << generic.getdt()
+		    << " for particles " << p1.getID() << " and " << p2.getID();
+#endif
+	return event;
+      }
+
+    return getInteraction(p1, p2)->getEvent(p1, p2);
   }
 
   void 
@@ -235,9 +293,20 @@ namespace dynamo
   const shared_ptr<Interaction>&
   Simulation::getInteraction(const Particle& p1, const Particle& p2) const 
   {
-    BOOST_FOREACH(const shared_ptr<Interaction>& ptr, interactions)
-      if (ptr->isInteraction(p1,p2))
-	return ptr;
+    size_t i(0);
+
+    if (!_interactionLookup.empty())
+      {
+	i = _interactionLookup[species.getSpeciesIndex(p1) * species.size() 
+			       + species.getSpeciesIndex(p2)];
+	
+	if (i < _firstUnresolvedInteraction)
+	  return interactions[i];
+      }
+
+    for (; i < interactions.size(); ++i)
+      if (interactions[i]->isInteraction(p1,p2))
+	return interactions[i];
   
     M_throw() << "Could not find an Interaction between particles " << p1.getID() << " and " << p2.getID() << ". All particle pairings must have a corresponding Interaction defined.";
   }
@@ -245,13 +314,134 @@ namespace dynamo
   const shared_ptr<Species>& 
   Simulation::SpeciesContainer::operator[](const Particle& p1) const 
   {
-    BOOST_FOREACH(const shared_ptr<Species>& ptr, *this)
-      if (ptr->isSpecies(p1)) return ptr;
+    return Base::operator[](getSpeciesIndex(p1));
+  }
+
+  size_t
+  Simulation::SpeciesContainer::getSpeciesIndex(const Particle& p1) const
+  {
+    if (p1.getID() < _particleSpecies.size())
+      return _particleSpecies[p1.getID()];
+
+    for (size_t i(0); i < size(); ++i)
+      if (Base::operator[](i)->isSpecies(p1)) return i;
     
     M_throw() << "Could not find the species corresponding to particle ID=" 
 	      << p1.getID(); 
   }
 
+  void
+  Simulation::SpeciesContainer::buildParticleIndex(const ParticleContainer& particles)
+  {
+    const size_t unassigned = std::numeric_limits<size_t>::max();
+    _particleSpecies.clear();
+    std::vector<size_t> index(particles.size(), unassigned);
+
+    for (size_t i(0); i < size(); ++i)
+      BOOST_FOREACH(const size_t& ID, *(Base::operator[](i)->getRange()))
+	{
+	  if (ID >= particles.size())
+	    M_throw() << "Species \"" << Base::operator[](i)->getName() 
+		      << "\" contains the particle ID=" << ID
+		      << " which does not exist";
+
+	  if (index[ID] != unassigned)
+	    M_throw() << "Particle ID=" << ID << " has more than one species";
+
+	  index[ID] = i;
+	}
+
+    for (size_t ID(0); ID < index.size(); ++ID)
+      if (index[ID] == unassigned)
+	M_throw() << "Particle ID=" << ID << " has no species";
+
+    _particleSpecies.swap(index);
+  }
+
+  void
+  Simulation::rebuildLookupTables()
+  {
+    species.buildParticleIndex(particles);
+
+    const size_t nSpecies = species.size();
+
+    //Take the first particle of each species as representative of
+    //the species
+    std::vector<const Particle*> representative(nSpecies, NULL);
+    BOOST_FOREACH(const Particle& part, particles)
+      {
+	const size_t sp = species.getSpeciesIndex(part);
+	if (!representative[sp]) representative[sp] = &part;
+      }
+
+    //Find how many of the interactions can be resolved by species
+    //alone. Their ranges must contain either all or none of the
+    //particles of each species.
+    std::vector<char> inRange(N);
+    for (_firstUnresolvedInteraction = 0; 
+	 _firstUnresolvedInteraction < interactions.size(); 
+	 ++_firstUnresolvedInteraction)
+      {
+	std::vector<const IDRange*> ranges;
+	if (!interactions[_firstUnresolvedInteraction]->getRange()->getIDRanges(ranges))
+	  break;
+
+	bool aligned(true);
+	BOOST_FOREACH(const IDRange* range, ranges)
+	  {
+	    std::fill(inRange.begin(), inRange.end(), false);
+	    BOOST_FOREACH(const size_t& ID, *range)
+	      if (ID < N) inRange[ID] = true;
+
+	    BOOST_FOREACH(const Particle& part, particles)
+	      if (inRange[part.getID()] 
+		  != inRange[representative[species.getSpeciesIndex(part)]->getID()])
+		aligned = false;
+	  }
+
+	if (!aligned) break;
+      }
+
+    _interactionLookup.assign(nSpecies * nSpecies, 0);
+    for (size_t sp1(0); sp1 < nSpecies; ++sp1)
+      for (size_t sp2(0); sp2 < nSpecies; ++sp2)
+	if (representative[sp1] && representative[sp2])
+	  {
+	    size_t i(0);
+	    while ((i < _firstUnresolvedInteraction) 
+		   && !interactions[i]->isInteraction(*representative[sp1], *representative[sp2]))
+	      ++i;
+
+	    _interactionLookup[sp1 * nSpecies + sp2] = i;
+	  }
+  }
+
+  void
+  Simulation::reorderParticles(const std::vector<size_t>& order)
+  {
+    if (order.size() != particles.size())
+      M_throw() << "The new particle order does not contain every particle";
+
+    dynamics->updateAllParticles();
+
+    ParticleContainer newParticles;
+    newParticles.reserve(particles.size());
+    for (size_t ID(0); ID < order.size(); ++ID)
+      {
+	newParticles.push_back(particles[order[ID]]);
+	newParticles.back()._ID = ID;
+      }
+
+    particles.swap(newParticles);
+    _properties.reorder(order);
+    dynamics->reorderParticles(order);
+
+    BOOST_FOREACH(shared_ptr<OutputPlugin>& Ptr, outputPlugins)
+      Ptr->reorderParticles(order);
+
+    rebuildLookupTables();
+  }
+
   void Simulation::addSpecies(shared_ptr<Species> sp)
   {
     if (status >= INITIALISED)
@@ -286,25 +476,37 @@ namespace dynamo
     if (!boost::filesystem::exists(fileName))
       M_throw() << "Could not find the XML file named " << fileName
 		<< "\nPlease check the file exists.";
-    { //This scopes out the file objects
+
+    if (isCheckpointFile(fileName))
+      {
+	//The particle data is left in the mapped file, only the XML
+	//header is copied for parsing
+	checkpointIn.reset(new CheckpointReader(fileName));
+	doc.getStoredXMLData().assign(checkpointIn->xmlData(), checkpointIn->xmlLength());
+      }
+    else
+      { //This scopes out the file objects
       
-      //We use the boost iostreams library to load the file into a
-      //string which may be compressed.
+	//We use the boost iostreams library to load the file into a
+	//string which may be compressed.
       
-      //We make our filtering iostream
-      io::filtering_istream inputFile;
+	//We make our filtering iostream
+	io::filtering_istream inputFile;
       
-      //Now check if we should add a decompressor filter
-      if (std::string(fileName.end()-8, fileName.end()) == ".xml.bz2")
-	inputFile.push(io::bzip2_decompressor());
-      else if (!(std::string(fileName.end()-4, fileName.end()) == ".xml"))
-	M_throw() << "Unrecognized extension for xml file";
-
-      //Finally, add the file as a source
-      inputFile.push(io::file_source(fileName));
-	  
-      io::copy(inputFile, io::back_inserter(doc.getStoredXMLData()));
-    }
+	//Now check if we should add a decompressor filter
+	if (std::string(fileName.end()-8, fileName.end()) == ".xml.bz2")
+	  inputFile.push(magnet::stream::ParallelBzip2Decompressor(threadPool));
+	else if (!(std::string(fileName.end()-4, fileName.end()) == ".xml"))
+	  M_throw() << "Unrecognized extension for xml file";
+
+	//Finally, add the file as a source
+	inputFile.push(io::file_source(fileName));
+
+	//The particle data is converted as it is decompressed, only
+	//the rest of the XML is stored for parsing
+	particleStreamIn.reset(new ParticleStreamReader);
+	particleStreamIn->read(inputFile, doc.getStoredXMLData());
+      }
 
     dout << "Parsing the XML" << std::endl;
     try {
@@ -338,6 +540,15 @@ namespace dynamo
 
     _properties << mainNode;
 
+    //The Interactions and Locals read the per-particle Property
+    //values as they load, so these are taken from the checkpoint or
+    //the stream before the particles are
+    if (checkpointIn)
+      _properties.loadParticleBinaryData
+	(*checkpointIn, mainNode.getNode("ParticleData").getAttribute("N").as<size_t>());
+    else if (particleStreamIn)
+      _properties.loadParticleStreamData(*particleStreamIn);
+
     //Load the Primary cell's size
     primaryCellSize << simNode.getNode("SimulationSize");
     primaryCellSize /= units.unitLength();
@@ -392,6 +603,10 @@ namespace dynamo
     ptrScheduler = Scheduler::getClass(simNode.getNode("Scheduler"), this);
 
     dynamics->loadParticleXMLData(mainNode);
+
+    //Release the mapping of the checkpoint file
+    checkpointIn.reset();
+    particleStreamIn.reset();
   
     //Fixes or conversions once system is loaded
     lastRunMFT *= units.unitTime();
@@ -417,26 +632,100 @@ namespace dynamo
     namespace io = boost::iostreams;
     io::filtering_ostream coutputFile;
 
-    if (std::string(fileName.end()-4, fileName.end()) == ".bz2")
-      coutputFile.push(io::bzip2_compressor());
-  
-    coutputFile.push(io::file_sink(fileName));
+    checkpointOut.reset();
+    if (isCheckpointFile(fileName))
+      {
+	checkpointOut.reset(new CheckpointWriter(fileName));
+	coutputFile.push(checkpointOut->xmlStream());
+      }
+    else
+      {
+	if (std::string(fileName.end()-4, fileName.end()) == ".bz2")
+	  coutputFile.push(magnet::stream::ParallelBzip2Compressor(threadPool));
   
-    magnet::xml::XmlStream XML(coutputFile);
-    XML.setFormatXML(true);
+	coutputFile.push(io::file_sink(fileName));
+      }
+
+    writeXMLconfig(coutputFile, applyBC, round);
+
+    if (checkpointOut)
+      {
+	coutputFile.flush();
+	checkpointOut->close();
+	checkpointOut.reset();
+      }
+
+    dout << "Config written to " << fileName << std::endl;
+  }
+
+  void
+  Simulation::writeXMLfileAsync(AsyncWriter& writer, std::string fileName, bool applyBC)
+  {
+    //Checkpoints are not compressed, so they are quick to write
+    if (isCheckpointFile(fileName))
+      {
+	writeXMLfile(fileName, applyBC);
+	return;
+      }
+
+    if (status < INITIALISED || status == ERROR)
+      M_throw() << "Cannot write out configuration in this state";
+
+    shared_ptr<ConfigSnapshot> snapshot(new ConfigSnapshot);
 
     dynamics->updateAllParticles();
+    rescaleProperties(true);
+
+    {
+      std::ostringstream os;
+      magnet::xml::XmlStream XML(os);
+      XML.setFormatXML(true);
+      writeXMLheader(XML, false);
+      //Taken before the XmlStream closes the DynamOconfig tag
+      snapshot->head = os.str();
+      snapshot->precision = os.precision();
+    }
 
-    //Rescale the properties to the configuration file units
+    dynamics->snapshotParticleData(snapshot->particles, applyBC);
+    rescaleProperties(false);
+
+    writer.write(fileName, snapshot);
+
+    dout << "Config queued for writing to " << fileName << std::endl;
+  }
+
+  void
+  Simulation::rescaleProperties(bool toFileUnits)
+  {
     _properties.rescaleUnit(Property::Units::L, 
-			    1.0 / units.unitLength());
+			    toFileUnits ? 1.0 / units.unitLength() : units.unitLength());
 
     _properties.rescaleUnit(Property::Units::T, 
-			    1.0 / units.unitTime());
+			    toFileUnits ? 1.0 / units.unitTime() : units.unitTime());
 
     _properties.rescaleUnit(Property::Units::M, 
-			    1.0 / units.unitMass());
+			    toFileUnits ? 1.0 / units.unitMass() : units.unitMass());
+  }
+
+  void
+  Simulation::writeXMLconfig(std::ostream& os, bool applyBC, bool round)
+  {
+    magnet::xml::XmlStream XML(os);
+    XML.setFormatXML(true);
+
+    dynamics->updateAllParticles();
+    rescaleProperties(true);
 
+    writeXMLheader(XML, round);
+    dynamics->outputParticleXMLData(XML, applyBC);
+    XML << magnet::xml::endtag("DynamOconfig");
+
+    rescaleProperties(false);
+  }
+
+  void
+  Simulation::writeXMLheader(magnet::xml::XmlStream& XML, bool round)
+  {
     XML << std::scientific
       //This has a minus one due to the digit in front of the decimal
       //An extra one is added if we're rounding
@@ -512,22 +801,6 @@ namespace dynamo
 	<< magnet::xml::endtag("Dynamics")
 	<< magnet::xml::endtag("Simulation")
 	<< _properties;
-
-    dynamics->outputParticleXMLData(XML, applyBC);
-
-    XML << magnet::xml::endtag("DynamOconfig");
-
-    dout << "Config written to " << fileName << std::endl;
-
-    //Rescale the properties back to the simulation units
-    _properties.rescaleUnit(Property::Units::L, 
-			    units.unitLength());
-
-    _properties.rescaleUnit(Property::Units::T, 
-			    units.unitTime());
-
-    _properties.rescaleUnit(Property::Units::M, 
-			    units.unitMass());
   }
   
   void 
@@ -538,6 +811,54 @@ namespace dynamo
       func(pdat);
   }
 
+  void
+  Simulation::signalEvent(const IntEvent& event, const PairEventData& data)
+  {
+    for (size_t i(0); i < outputPlugins.size(); ++i)
+      {
+#ifdef DYNAMO_PROFILE
+	EventProfiler::Timer timer(profiler.pluginEvents(i));
+#endif
+	outputPlugins[i]->eventUpdate(event, data);
+      }
+  }
+
+  void
+  Simulation::signalEvent(const GlobalEvent& event, const NEventData& data)
+  {
+    for (size_t i(0); i < outputPlugins.size(); ++i)
+      {
+#ifdef DYNAMO_PROFILE
+	EventProfiler::Timer timer(profiler.pluginEvents(i));
+#endif
+	outputPlugins[i]->eventUpdate(event, data);
+      }
+  }
+
+  void
+  Simulation::signalEvent(const LocalEvent& event, const NEventData& data)
+  {
+    for (size_t i(0); i < outputPlugins.size(); ++i)
+      {
+#ifdef DYNAMO_PROFILE
+	EventProfiler::Timer timer(profiler.pluginEvents(i));
+#endif
+	outputPlugins[i]->eventUpdate(event, data);
+      }
+  }
+
+  void
+  Simulation::signalEvent(const System& event, const NEventData& data, const double& dt)
+  {
+    for (size_t i(0); i < outputPlugins.size(); ++i)
+      {
+#ifdef DYNAMO_PROFILE
+	EventProfiler::Timer timer(profiler.pluginEvents(i));
+#endif
+	outputPlugins[i]->eventUpdate(event, data, dt);
+      }
+  }
+
   void 
   Simulation::replexerSwap(Simulation& other)
   {
@@ -563,20 +884,13 @@ namespace dynamo
     double scale1(sqrt(other.ensemble->getEnsembleVals()[2]
 		       / ensemble->getEnsembleVals()[2]));
     
-    BOOST_FOREACH(Particle& part, particles)
-      part.getVelocity() *= scale1;
-    
-    other.ptrScheduler->rescaleTimes(scale1);
+    dynamics->rescaleSystemKineticEnergy(scale1 * scale1);
+    ptrScheduler->velocitiesRescaled(scale1);
     
     double scale2(1.0 / scale1);
 
-    BOOST_FOREACH(Particle& part, other.particles)
-      part.getVelocity() *= scale2;
-    
-    ptrScheduler->rescaleTimes(scale2);
-    
-    ptrScheduler->rebuildSystemEvents();
-    other.ptrScheduler->rebuildSystemEvents();    
+    other.dynamics->rescaleSystemKineticEnergy(scale2 * scale2);
+    other.ptrScheduler->velocitiesRescaled(scale2);
 
     //Globals?
 #ifdef DYNAMO_DEBUG
@@ -629,12 +943,20 @@ namespace dynamo
  
     long double sumMass(0);
 
+    //Only the sliding boundaries change the velocity of an image
+    const bool shearing(std::tr1::dynamic_pointer_cast<BCLeesEdwards>(BCs));
+
     //Determine the discrepancy VECTOR
-    BOOST_FOREACH(Particle & Part, particles)
+    const ParticleContainer::iterator end = particles.end();
+    for (ParticleContainer::iterator it = particles.begin(); it != end; ++it)
       {
-	Vector  pos(Part.getPosition()), vel(Part.getVelocity());
-	BCs->applyBC(pos,vel);
-	double mass = species[Part]->getMass(Part.getID());
+	Vector vel(it->getVelocity());
+	if (shearing)
+	  {
+	    Vector pos(it->getPosition());
+	    BCs->applyBC(pos, vel);
+	  }
+	double mass = species[*it]->getMass(it->getID());
 	//Note we sum the negatives!
 	sumMV -= vel * mass;
 	sumMass += mass;
@@ -644,8 +966,8 @@ namespace dynamo
   
     sumMV += COMVelocity;
 
-    BOOST_FOREACH(Particle & Part, particles)
-      Part.getVelocity() =  Part.getVelocity() + sumMV;
+    for (ParticleContainer::iterator it = particles.begin(); it != end; ++it)
+      it->getVelocity() += sumMV;
   }
 
   void 
@@ -691,7 +1013,7 @@ namespace dynamo
   {
     dynamics->updateAllParticles();
 
-    std::vector<Particle>::const_iterator iPtr1, iPtr2;
+    ParticleContainer::const_iterator iPtr1, iPtr2;
   
     BOOST_FOREACH(const shared_ptr<Interaction>& interaction_ptr, interactions)
       interaction_ptr->validateState();
@@ -715,11 +1037,32 @@ namespace dynamo
     io::filtering_ostream coutputFile;
   
     if (std::string(filename.end()-4, filename.end()) == ".bz2")
-      coutputFile.push(io::bzip2_compressor());
+      coutputFile.push(magnet::stream::ParallelBzip2Compressor(threadPool));
   
     coutputFile.push(io::file_sink(filename));
-  
-    magnet::xml::XmlStream XML(coutputFile);
+
+    writeOutputData(coutputFile);
+
+    dout << "Output written to " << filename << std::endl;
+  }
+
+  void
+  Simulation::outputDataAsync(AsyncWriter& writer, std::string filename)
+  {
+    if (status < INITIALISED || status == ERROR)
+      M_throw() << "Cannot output data when not initialised!";
+
+    std::ostringstream os;
+    writeOutputData(os);
+    writer.write(filename, os.str());
+
+    dout << "Output queued for writing to " << filename << std::endl;
+  }
+
+  void
+  Simulation::writeOutputData(std::ostream& os)
+  {
+    magnet::xml::XmlStream XML(os);
     XML.setFormatXML(true);
   
     XML << std::setprecision(std::numeric_limits<double>::digits10)
@@ -728,10 +1071,12 @@ namespace dynamo
     //Output the data and delete the outputplugins
     BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, outputPlugins)
       Ptr->output(XML);
+
+#ifdef DYNAMO_PROFILE
+    profiler.outputXML(XML, *this);
+#endif
   
     XML << magnet::xml::endtag("OutputData");
-
-    dout << "Output written to " << filename << std::endl;
   }
 
   void 
@@ -786,8 +1131,13 @@ namespace dynamo
 	if ((eventCount >= _nextPrint) && !silentMode && outputPlugins.size())
 	  {
 	    //Print the screen data plugins
-	    BOOST_FOREACH(shared_ptr<OutputPlugin> & Ptr, outputPlugins)
-	      Ptr->periodicOutput();
+	    for (size_t i(0); i < outputPlugins.size(); ++i)
+	      {
+#ifdef DYNAMO_PROFILE
+		EventProfiler::Timer timer(profiler.pluginPeriodic(i));
+#endif
+		outputPlugins[i]->periodicOutput();
+	      }
 	    
 	    _nextPrint = eventCount + eventPrintInterval;
 	    std::cout << std::endl;
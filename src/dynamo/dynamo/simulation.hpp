@@ -30,6 +30,12 @@
 #include <boost/random/normal_distribution.hpp>
 #include <vector>
 
+#ifdef DYNAMO_PROFILE
+#include <dynamo/profiler.hpp>
+#endif
+
+namespace magnet { namespace thread { class WorkStealingPool; } }
+
 namespace dynamo
 {  
   class Scheduler;
@@ -53,6 +59,12 @@ namespace dynamo
   class IDRange;
   class IDPairRange;
 
+  class CheckpointReader;
+  class CheckpointWriter;
+  class ParticleStreamReader;
+  class AsyncWriter;
+  class EventKernel;
+
 
   //! \brief Holds the different phases of the simulation initialisation
   typedef enum 
@@ -111,6 +123,22 @@ namespace dynamo
       using Base::operator[];
 
       const shared_ptr<Species>& operator[](const Particle& p1) const;
+
+      /*! \brief Returns the index of the Species of a particle.
+
+	Once \ref buildParticleIndex has been called this is a table
+	look-up, otherwise every Species is tested in turn.
+       */
+      size_t getSpeciesIndex(const Particle& p1) const;
+
+      /*! \brief Builds the table of the Species index of every
+	particle, checking that every particle has exactly one
+	Species.
+       */
+      void buildParticleIndex(const ParticleContainer&);
+
+    private:
+      std::vector<size_t> _particleSpecies;
     };
 
   public:
@@ -139,6 +167,26 @@ namespace dynamo
     IntEvent getEvent(const Particle& p1, const Particle& p2) const;
     double getLongestInteraction() const;
 
+    /*! \brief Rebuilds the tables used to look up the Species of a
+        particle and the Interaction between two particles.
+
+      This is called during initialisation and whenever a particle is
+      added to or removed from the Simulation.
+     */
+    void rebuildLookupTables();
+
+    /*! \brief Renumbers the particles of the Simulation.
+
+      The particles, their properties, the Dynamics data and the
+      data of the output plugins are permuted, so that the new
+      particle ID i is the old particle ID order[i]. Every output
+      plugin must support this (see
+      OutputPlugin::canReorderParticles). Anything else holding
+      particle IDs (the scheduler and neighbour lists) must be
+      rebuilt afterwards.
+     */
+    void reorderParticles(const std::vector<size_t>& order);
+
     Container<Local> locals;
 
     Container<Global> globals;
@@ -213,16 +261,28 @@ namespace dynamo
     
       \param filename The path to the XML file to write (this file
       will either be created or overwritten). The filename must end in
-      either ".xml" for uncompressed xml files or ".bz2" for bzip2
-      compressed configuration files.
+      either ".xml" for uncompressed xml files, ".bz2" for bzip2
+      compressed configuration files or ".dynbin" for binary
+      checkpoints.
     */
     void outputData(std::string filename = "output.xml.bz2");
 
+    /*! \brief Captures the output data and queues it to be
+        compressed and written by an AsyncWriter.
+
+      The simulation may continue as soon as this returns. The output
+      plugins still format their XML on the calling thread, as they
+      read the live simulation state; only the compression and the
+      file write are moved to the background.
+    */
+    void outputDataAsync(AsyncWriter& writer, std::string filename);
+
     /*! \brief Loads a Simulation from the passed XML file.
 
       \param filename The path to the XML file to load. The filename
-     must end in either ".xml" for uncompressed xml files or ".bz2"
-     for bzip2 compressed configuration files.
+     must end in either ".xml" for uncompressed xml files, ".bz2"
+     for bzip2 compressed configuration files or ".dynbin" for binary
+     checkpoints (see \ref CheckpointHeader).
     */
     void loadXMLfile(std::string filename);
     
@@ -230,8 +290,9 @@ namespace dynamo
 
       \param filename The path to the XML file to write (this file
       will either be created or overwritten). The filename must end in
-      either ".xml" for uncompressed xml files or ".bz2" for bzip2
-      compressed configuration files.
+      either ".xml" for uncompressed xml files, ".bz2" for bzip2
+      compressed configuration files or ".dynbin" for binary
+      checkpoints.
 
       \param round If true, the data in the XML file will be written
       out at 2 s.f. lower precision to round all the values. This is
@@ -240,6 +301,18 @@ namespace dynamo
     */
     void writeXMLfile(std::string filename, bool applyBC = true, bool round = false);
 
+    /*! \brief Captures the configuration and queues it to be
+        formatted, compressed and written by an AsyncWriter.
+
+      Only the XML outside of the particle data is generated on the
+      calling thread. The particle data is copied (see
+      Dynamics::snapshotParticleData) and formatted in the background.
+
+      Binary checkpoints are written immediately, as they do not need
+      compressing or formatting.
+    */
+    void writeXMLfileAsync(AsyncWriter& writer, std::string filename, bool applyBC = true);
+
     /*! \brief The Ensemble of the Simulation. */
     shared_ptr<Ensemble> ensemble;
 
@@ -309,7 +382,7 @@ namespace dynamo
     size_t N;
     
     /*! \brief The Particle's of the system. */
-    std::vector<Particle> particles;  
+    ParticleContainer particles;  
     
     /*! \brief A ptr to the Scheduler of the system. */
     shared_ptr<Scheduler> ptrScheduler;
@@ -320,6 +393,17 @@ namespace dynamo
     /*! \brief The size of the primary image/cell of the simulation. */
     Vector  primaryCellSize;
 
+    /*! \brief A pool of threads which may be used to parallelise
+        the building of the event lists, the output plugins and the
+        compression of bzip2 files, or NULL if the simulation must
+        run serially.
+
+      This is only set by engines running a single Simulation, as
+      other engines use the threads to run several simulations at
+      once.
+     */
+    magnet::thread::WorkStealingPool* threadPool;
+
     /*! \brief The random number generator of the system. */
     mutable baseRNG ranGenerator;
 
@@ -357,6 +441,37 @@ namespace dynamo
 
     Units units;
 
+    /*! \brief The binary checkpoint being loaded by \ref loadXMLfile.
+
+      This is only set while the configuration is being loaded, so
+      that classes with bulk data (e.g., capture maps) may read it
+      from the checkpoint instead of the XML.
+     */
+    shared_ptr<CheckpointReader> checkpointIn;
+
+    /*! \brief The particle data streamed out of the XML file being
+        loaded by \ref loadXMLfile.
+
+      This is only set while an XML configuration is being loaded. The
+      ParticleData tag of the parsed XML is then empty, and the
+      particles and their attributes must be taken from here.
+     */
+    shared_ptr<ParticleStreamReader> particleStreamIn;
+
+    /*! \brief The binary checkpoint being written by \ref
+        writeXMLfile.
+
+      This is only set while the configuration is being written,
+      classes with bulk data should then add it to the checkpoint
+      instead of writing it into the XML.
+     */
+    shared_ptr<CheckpointWriter> checkpointOut;
+
+#ifdef DYNAMO_PROFILE
+    /*! \brief The costs of the events executed by the Simulation. */
+    EventProfiler profiler;
+#endif
+
     /*! \brief Register a callback for particle changes.*/
     void registerParticleUpdateFunc(const particleUpdateFunc& func) const
     { _particleUpdateNotify.push_back(func); }
@@ -366,6 +481,17 @@ namespace dynamo
     */
     void signalParticleUpdate(const NEventData&) const;
 
+    /*! \brief Passes an executed event to every OutputPlugin.
+
+      The Interaction, Local, Global and System classes call these
+      once they have run an event, instead of looping over \ref
+      outputPlugins themselves.
+    */
+    void signalEvent(const IntEvent&, const PairEventData&);
+    void signalEvent(const GlobalEvent&, const NEventData&);
+    void signalEvent(const LocalEvent&, const NEventData&);
+    void signalEvent(const System&, const NEventData&, const double&);
+
     void replexerSwap(Simulation&);
     
     boost::signals2::signal<void (size_t)>& particle_added_signal()
@@ -375,11 +501,41 @@ namespace dynamo
     { return _particleRemovedFromSim; }
 
   private:    
+    void writeXMLconfig(std::ostream&, bool applyBC, bool round);
+    //! Writes the configuration up to the ParticleData tag.
+    void writeXMLheader(magnet::xml::XmlStream&, bool round);
+    /*! \brief Rescales the Property-s from the simulation units to
+        those of the configuration file, or back again.
+     */
+    void rescaleProperties(bool toFileUnits);
+    void writeOutputData(std::ostream&);
+
     mutable std::vector<particleUpdateFunc> _particleUpdateNotify;
     mutable boost::signals2::signal<void (size_t)> _particleAddedToSim;
     mutable boost::signals2::signal<void (size_t)> _particleRemovedFromSim;
 
     size_t _nextPrint;
+
+    /*! \brief The index of the first Interaction which may be used
+        between a pair of Species, stored as a Species by Species
+        matrix.
+
+      Only the Interaction's preceding \ref
+      _firstUnresolvedInteraction are resolved by Species. If an entry
+      is equal to or beyond this index, the remaining Interaction's
+      must still be tested in turn starting from that entry.
+     */
+    std::vector<size_t> _interactionLookup;
+
+    /*! \brief The index of the first Interaction whose range cannot
+        be described by Species alone.
+    */
+    size_t _firstUnresolvedInteraction;
+
+    /*! \brief A specialised predictor of the Interaction events,
+        used by \ref getEvent if the Simulation matches one.
+    */
+    shared_ptr<EventKernel> _eventKernel;
   };
 
 }
@@ -96,8 +96,7 @@ namespace dynamo {
  
     size_t nmax = static_cast<size_t>(Event);
   
-    BOOST_FOREACH(shared_ptr<OutputPlugin>& Ptr, Sim->outputPlugins)
-      Ptr->eventUpdate(*this, NEventData(), locdt);
+    Sim->signalEvent(*this, NEventData(), locdt);
 
     if (Sim->uniform_sampler() < fracpart)
       ++nmax;
@@ -133,8 +132,7 @@ namespace dynamo {
   
 	    Sim->ptrScheduler->fullUpdate(p1, p2);
 	  
-	    BOOST_FOREACH(shared_ptr<OutputPlugin>& Ptr, Sim->outputPlugins)
-	      Ptr->eventUpdate(*this, SDat, 0.0);
+	    Sim->signalEvent(*this, SDat, 0.0);
 	  }
       }
 
@@ -38,6 +38,9 @@ namespace dynamo {
     double getReducedTemperature() const;
     void setTemperature(double nT) { Temp = nT; sqrtTemp = std::sqrt(Temp); }
     void setReducedTemperature(double nT);
+
+    //! Returns the range of particles which are thermostatted.
+    const shared_ptr<IDRange>& getRange() const { return range; }
   
   protected:
     virtual void outputXML(magnet::xml::XmlStream&) const;
@@ -23,6 +23,8 @@
 #include <dynamo/NparticleEventData.hpp>
 #include <dynamo/schedulers/scheduler.hpp>
 #include <dynamo/outputplugins/outputplugin.hpp>
+#include <algorithm>
+#include <cmath>
 
 #ifdef DYNAMO_DEBUG 
 #include <boost/math/special_functions/fpclassify.hpp>
@@ -32,7 +34,11 @@ namespace dynamo {
   SysNBListCompressionFix::SysNBListCompressionFix(dynamo::Simulation* nSim, double nGR, size_t nblistID):
     System(nSim),
     growthRate(nGR),
-    cellID(nblistID)
+    cellID(nblistID),
+    _growth(0.1),
+    _lastRange(0),
+    _lastEventCount(0),
+    _regridFraction(1.0)
   {
     sysName = "GlobalCellsCompressionHack";
     type = NON_EVENT;
@@ -52,6 +58,8 @@ namespace dynamo {
     GNeighbourList& nblist(dynamic_cast<GNeighbourList&>(*Sim->globals[cellID]));
 
     initialSupportedRange = nblist.getMaxInteractionRange();
+    _lastRange = initialSupportedRange * (1.0 + growthRate * Sim->systemTime);
+    _lastEventCount = Sim->eventCount;
       
     dt = (nblist.getMaxSupportedInteractionLength() / initialSupportedRange - 1.0) 
       / growthRate - Sim->systemTime;
@@ -93,7 +101,25 @@ namespace dynamo {
 	 << "\nNColl = " << Sim->eventCount
 	 << "\nSys t = " << Sim->systemTime / Sim->units.unitTime() << std::endl;
   
-    nblist.setMaxInteractionRange(nblist.getMaxSupportedInteractionLength() * 1.1);
+    //The cells are grown in steps of g. Each regrid costs about
+    //f N predictions, where f is the fraction of the pairs which are
+    //new neighbours. Between regrids the oversized cells add about
+    //1.5 g of extra neighbours to each event, and the number of
+    //events between regrids is proportional to g. Balancing the two
+    //costs with the step and event count of the last cycle gives
+    //the step to use. Work is counted instead of timed, so the
+    //schedule (and the trajectory) is reproducible.
+    const double lastGrowth = nblist.getMaxSupportedInteractionLength() / _lastRange - 1.0;
+    const size_t events = Sim->eventCount - _lastEventCount;
+    if ((lastGrowth > 0) && events)
+      _growth = std::min(0.25, std::max(0.01, std::sqrt(_regridFraction * Sim->N * lastGrowth 
+							 / (1.5 * events))));
+
+    dout << "Growing the cells by " << _growth * 100 << "%" << std::endl;
+
+    _lastRange = nblist.getMaxSupportedInteractionLength();
+    _lastEventCount = Sim->eventCount;
+    _regridFraction = nblist.regrid(_lastRange * (1.0 + _growth));
   
     dt = (nblist.getMaxSupportedInteractionLength()
 	  / initialSupportedRange - 1.0) / growthRate - Sim->systemTime;
@@ -102,8 +128,7 @@ namespace dynamo {
 
     Sim->signalParticleUpdate(SDat);
     
-    BOOST_FOREACH(shared_ptr<OutputPlugin>& Ptr, Sim->outputPlugins)
-      Ptr->eventUpdate(*this, SDat, locdt); 
+    Sim->signalEvent(*this, SDat, locdt); 
   }
 
   void 
@@ -38,5 +38,14 @@ namespace dynamo {
     double growthRate;
     double initialSupportedRange;
     size_t cellID;
+
+    //! \brief The fractional growth of the next regrid.
+    mutable double _growth;
+    //! \brief The interaction range at the last regrid.
+    mutable double _lastRange;
+    //! \brief The event count at the last regrid.
+    mutable size_t _lastEventCount;
+    //! \brief The fraction of the neighbour pairs predicted by the last regrid.
+    mutable double _regridFraction;
   };
 }
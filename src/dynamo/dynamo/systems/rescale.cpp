@@ -98,7 +98,8 @@ namespace dynamo {
       SDat.L1partChanges.push_back(ParticleEventData(Sim->particles[partID], *species, RESCALE));
 
     Sim->dynamics->updateAllParticles();
-    Sim->dynamics->rescaleSystemKineticEnergy(_kT / currentkT);
+    const double scale(_kT / currentkT);
+    Sim->dynamics->rescaleSystemKineticEnergy(scale);
 
     RealTime += (Sim->systemTime - LastTime) / std::exp(0.5 * scaleFactor);
     
@@ -108,19 +109,16 @@ namespace dynamo {
 
     Sim->signalParticleUpdate(SDat);
   
-    //Only 1ParticleEvents occur
-    BOOST_FOREACH(const ParticleEventData& PDat, SDat.L1partChanges)
-      Sim->ptrScheduler->fullUpdate(Sim->particles[PDat.getParticleID()]);
-  
-    BOOST_FOREACH(shared_ptr<OutputPlugin>& Ptr, Sim->outputPlugins)
-      Ptr->eventUpdate(*this, SDat, locdt); 
+    Sim->signalEvent(*this, SDat, locdt); 
 
     BOOST_FOREACH(shared_ptr<OutputPlugin>& Ptr, Sim->outputPlugins)
       Ptr->temperatureRescale(1.0/currentkT);
 
     dt = _timestep;
-  
-    Sim->ptrScheduler->rebuildList();
+
+    //Every velocity was scaled by the same factor, so the event list
+    //can be rescaled instead of being rebuilt
+    Sim->ptrScheduler->velocitiesRescaled(std::sqrt(scale));
   }
 
   void 
@@ -29,10 +29,11 @@
 #endif
 
 namespace dynamo {
-  SSnapshot::SSnapshot(dynamo::Simulation* nSim, double nPeriod, std::string nName, bool applyBC):
+  SSnapshot::SSnapshot(dynamo::Simulation* nSim, double nPeriod, std::string nName, bool applyBC, size_t maxBytes):
     System(nSim),
     _applyBC(applyBC),
-    _saveCounter(0)
+    _saveCounter(0),
+    _writer(new AsyncWriter(maxBytes))
 
   {
     if (nPeriod <= 0.0)
@@ -72,14 +73,13 @@ namespace dynamo {
     //This is done here as most ticker properties require it
     Sim->dynamics->updateAllParticles();
 
-    BOOST_FOREACH(shared_ptr<OutputPlugin>& Ptr, Sim->outputPlugins)
-      Ptr->eventUpdate(*this, NEventData(), locdt);
+    Sim->signalEvent(*this, NEventData(), locdt);
   
     std::string filename = magnet::string::search_replace("Snapshot.%i.xml.bz2", "%i", boost::lexical_cast<std::string>(_saveCounter));
-    Sim->writeXMLfile(filename, _applyBC);
+    Sim->writeXMLfileAsync(*_writer, filename, _applyBC);
     
     filename = magnet::string::search_replace("Snapshot.output.%i.xml.bz2", "%i", boost::lexical_cast<std::string>(_saveCounter++));
-    Sim->outputData(filename);
+    Sim->outputDataAsync(*_writer, filename);
   }
 
   void 
@@ -17,13 +17,24 @@
 
 #pragma once
 #include <dynamo/systems/system.hpp>
+#include <dynamo/asyncwriter.hpp>
 
 namespace dynamo {
-  //! \brief A System Event which periodically saves the state of the system.
+  /*! \brief A System Event which periodically saves the state of the system.
+
+    The snapshots are captured in memory and handed to an AsyncWriter,
+    so the simulation continues while they are formatted, compressed
+    and written. Only the copy of the particle data and the XML
+    outside of it pause the simulation.
+   */
   class SSnapshot: public System
   {
   public:
-    SSnapshot(dynamo::Simulation*, double, std::string, bool);
+    /*! \param maxBytes The maximum size of the snapshots held in
+        memory waiting to be written. The simulation blocks if this is
+        exceeded.
+     */
+    SSnapshot(dynamo::Simulation*, double, std::string, bool, size_t maxBytes = 256 * 1024 * 1024);
   
     virtual void runEvent() const;
 
@@ -44,5 +55,6 @@ namespace dynamo {
     double _period;
     bool _applyBC;
     mutable size_t _saveCounter;
+    shared_ptr<AsyncWriter> _writer;
   };
 }
@@ -61,8 +61,7 @@ namespace dynamo {
 
     Sim->signalParticleUpdate(SDat);
     
-    BOOST_FOREACH(shared_ptr<OutputPlugin>& Ptr, Sim->outputPlugins)
-      Ptr->eventUpdate(*this, SDat, locdt); 
+    Sim->signalEvent(*this, SDat, locdt); 
   
     Sim->nextPrintEvent = Sim->endEventCount = Sim->eventCount;
   }
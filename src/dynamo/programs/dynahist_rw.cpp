@@ -17,12 +17,12 @@
 
 #include <magnet/xmlreader.hpp>
 #include <magnet/exception.hpp>
+#include <magnet/stream/bzip2.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/foreach.hpp>
 #include <boost/iostreams/device/file.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
-#include <boost/iostreams/filter/bzip2.hpp>
 #include <boost/iostreams/chain.hpp>
 #include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/copy.hpp>
@@ -81,7 +81,7 @@ struct SimulationData
       
       //Now check if we should add a decompressor filter
       if (std::string(fileName.end()-8, fileName.end()) == ".xml.bz2")
-	inputFile.push(io::bzip2_decompressor());
+	inputFile.push(magnet::stream::ParallelBzip2Decompressor());
       else if (!(std::string(fileName.end()-4, fileName.end()) == ".xml"))
 	M_throw() << "Unrecognized extension for xml file";
 
@@ -21,6 +21,7 @@
 #include <dynamo/schedulers/include.hpp>
 #include <dynamo/inputplugins/include.hpp>
 #include <magnet/exception.hpp>
+#include <magnet/thread/workstealing.hpp>
 #include <boost/program_options.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/lexical_cast.hpp>
@@ -36,6 +37,7 @@ main(int argc, char *argv[])
 	    << "under certain conditions. See the licence you obtained with\n"
 	    << "the code\n";
 
+  magnet::thread::WorkStealingPool threads;
   dynamo::Simulation sim;
 
   ////////////////////////PROGRAM OPTIONS!!!!!!!!!!!!!!!!!!!!!!!
@@ -49,9 +51,11 @@ main(int argc, char *argv[])
 	("help,h", "Produces this message OR if --pack-mode/-m is set, it lists the specific options available for that packer mode.")
 	("out-config-file,o", 
 	 po::value<string>()->default_value("config.out.xml.bz2"), 
-	 "Configuration output file.")
+	 "Configuration output file. Use a \".dynbin\" extension to write a binary checkpoint.")
 	("random-seed,s", po::value<unsigned int>(),
 	 "Seed value for the random number generator.")
+	("n-threads,N", po::value<unsigned int>(),
+	 "Number of threads used to compress and decompress bzip2 configuration files.")
 	("rescale-T,r", po::value<double>(), 
 	 "Rescales the kinetic temperature of the input/generated config to this value.")
 	("thermostat,T", po::value<double>(),
@@ -122,6 +126,12 @@ main(int argc, char *argv[])
 
       if (vm.count("random-seed"))
 	sim.ranGenerator.seed(vm["random-seed"].as<unsigned int>());
+
+      if (vm.count("n-threads"))
+	{
+	  threads.setThreadCount(vm["n-threads"].as<unsigned int>());
+	  sim.threadPool = &threads;
+	}
       
       if (!vm.count("pack-mode") && (vm.count("help") || !vm.count("config-file")))
 	{
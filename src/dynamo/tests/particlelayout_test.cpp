@@ -0,0 +1,226 @@
+#include <dynamo/simulation.hpp>
+#include <dynamo/dynamics/newtonian.hpp>
+#include <dynamo/species/point.hpp>
+#include <dynamo/ranges/IDRangeAll.hpp>
+#include <dynamo/BC/None.hpp>
+#include <boost/foreach.hpp>
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <time.h>
+
+using namespace dynamo;
+
+//A small deterministic generator, so the test needs no seed
+unsigned long nextInt()
+{
+  static unsigned long state = 12345;
+  state = (state * 1103515245 + 12345) % 2147483648UL;
+  return state;
+}
+
+double nextValue() { return double(nextInt()) / 2147483648.0 - 0.5; }
+
+double seconds()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + 1e-9 * now.tv_nsec;
+}
+
+//The particle data laid out as a structure of arrays
+struct ParticleArrays
+{
+  std::vector<double> x, y, z, vx, vy, vz, delay, mass;
+
+  void stream(const double dt)
+  {
+    const size_t N = x.size();
+    for (size_t i(0); i < N; ++i)
+      {
+	x[i] += vx[i] * (delay[i] + dt);
+	y[i] += vy[i] * (delay[i] + dt);
+	z[i] += vz[i] * (delay[i] + dt);
+	delay[i] = 0;
+      }
+  }
+
+  double kineticEnergy() const
+  {
+    double sum(0);
+    const size_t N = x.size();
+    for (size_t i(0); i < N; ++i)
+      sum += 0.5 * ((vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]) * mass[i]);
+    return sum;
+  }
+};
+
+bool equal(const Particle& part, const ParticleArrays& arrays, size_t i)
+{
+  return (part.getPosition()[0] == arrays.x[i])
+    && (part.getPosition()[1] == arrays.y[i])
+    && (part.getPosition()[2] == arrays.z[i])
+    && (part.getVelocity()[0] == arrays.vx[i])
+    && (part.getVelocity()[1] == arrays.vy[i])
+    && (part.getVelocity()[2] == arrays.vz[i]);
+}
+
+/* Times the particle sweeps of DynamO on its packed array of
+   Particle-s against the same sweeps over a structure of arrays, for
+   a million particles. The results of each layout must agree
+   exactly, the timings are only reported.
+ */
+int main()
+{
+  const size_t N = 1000000;
+  const size_t sweeps = 20;
+  const size_t events = 20 * N;
+
+  if (sizeof(Particle) != 64)
+    {
+      std::cout << "A Particle is " << sizeof(Particle) << " bytes, not one cache line" << std::endl;
+      return 1;
+    }
+
+  Simulation sim;
+  sim.BCs = shared_ptr<BoundaryCondition>(new BCNone(&sim));
+  shared_ptr<DynNewtonian> dynamics(new DynNewtonian(&sim));
+  sim.dynamics = dynamics;
+  sim.species.push_back(shared_ptr<Species>(new SpPoint(&sim, new IDRangeAll(&sim), 1.0, "Bulk", 0)));
+
+  ParticleArrays arrays;
+  sim.particles.reserve(N);
+  for (size_t i(0); i < N; ++i)
+    {
+      const Vector pos(nextValue(), nextValue(), nextValue());
+      const Vector vel(nextValue(), nextValue(), nextValue());
+      sim.particles.push_back(Particle(pos, vel, i));
+      arrays.x.push_back(pos[0]); arrays.y.push_back(pos[1]); arrays.z.push_back(pos[2]);
+      arrays.vx.push_back(vel[0]); arrays.vy.push_back(vel[1]); arrays.vz.push_back(vel[2]);
+      arrays.delay.push_back(0);
+      arrays.mass.push_back(1.0);
+    }
+  sim.N = N;
+  sim.species.buildParticleIndex(sim.particles);
+  dynamics->initialise();
+
+  if (reinterpret_cast<size_t>(&sim.particles[0]) % 64)
+    {
+      std::cout << "The particles are not aligned to a cache line" << std::endl;
+      return 1;
+    }
+
+  //Free streaming of every particle, first as the default
+  //Dynamics::streamAllParticles does, then with the DynNewtonian sweep
+  //used by Dynamics::updateAllParticles
+  double start = seconds();
+  for (size_t sweep(0); sweep < sweeps; ++sweep)
+    BOOST_FOREACH(Particle& part, sim.particles)
+      {
+	dynamics->streamParticle(part, part.getPecTime() + 0.001);
+	part.getPecTime() = 0;
+      }
+  const double genericTime = seconds() - start;
+
+  start = seconds();
+  for (size_t sweep(0); sweep < sweeps; ++sweep)
+    {
+      dynamics->stream(0.001);
+      dynamics->updateAllParticles();
+    }
+  const double bulkTime = seconds() - start;
+
+  start = seconds();
+  for (size_t sweep(0); sweep < 2 * sweeps; ++sweep)
+    arrays.stream(0.001);
+  const double arraysTime = seconds() - start;
+
+  for (size_t i(0); i < N; ++i)
+    if (!equal(sim.particles[i], arrays, i))
+      {
+	std::cout << "The streamed particle " << i << " differs" << std::endl;
+	return 1;
+      }
+
+  std::cerr << N << " particles, " << sweeps << " streaming sweeps:"
+	    << " per-particle streamParticle " << genericTime << "s,"
+	    << " streamAllParticles " << bulkTime << "s,"
+	    << " structure of arrays " << arraysTime / 2 << "s\n";
+
+  //Kinetic energy sums
+  start = seconds();
+  double perParticleSum(0);
+  for (size_t sweep(0); sweep < sweeps; ++sweep)
+    BOOST_FOREACH(const Particle& part, sim.particles)
+      perParticleSum += dynamics->getParticleKineticEnergy(part);
+  const double perParticleTime = seconds() - start;
+
+  start = seconds();
+  double bulkSum(0);
+  for (size_t sweep(0); sweep < sweeps; ++sweep)
+    bulkSum += dynamics->getSystemKineticEnergy();
+  const double bulkSumTime = seconds() - start;
+
+  start = seconds();
+  double arraysSum(0);
+  for (size_t sweep(0); sweep < sweeps; ++sweep)
+    arraysSum += arrays.kineticEnergy();
+  const double arraysSumTime = seconds() - start;
+
+  if ((std::abs(bulkSum - perParticleSum) > 1e-12 * perParticleSum)
+      || (std::abs(arraysSum - perParticleSum) > 1e-12 * perParticleSum))
+    {
+      std::cout << "The kinetic energies " << perParticleSum << ", " << bulkSum
+		<< " and " << arraysSum << " differ" << std::endl;
+      return 1;
+    }
+
+  std::cerr << N << " particles, " << sweeps << " kinetic energy sums:"
+	    << " per-particle " << perParticleTime << "s,"
+	    << " getSystemKineticEnergy " << bulkSumTime << "s,"
+	    << " structure of arrays " << arraysSumTime << "s\n";
+
+  //The access of the event loop: one particle at a time, in no order,
+  //is brought up to date and its position and velocity read
+  std::vector<size_t> order(events);
+  for (size_t i(0); i < events; ++i)
+    order[i] = nextInt() % N;
+
+  start = seconds();
+  double particleSum(0);
+  for (size_t i(0); i < events; ++i)
+    {
+      Particle& part = sim.particles[order[i]];
+      part.getPecTime() = 0.001;
+      dynamics->streamParticle(part, part.getPecTime());
+      part.getPecTime() = 0;
+      particleSum += part.getPosition()[0] * part.getVelocity()[1];
+    }
+  const double particleTime = seconds() - start;
+
+  start = seconds();
+  double arraysEventSum(0);
+  for (size_t i(0); i < events; ++i)
+    {
+      const size_t id = order[i];
+      arrays.delay[id] = 0.001;
+      arrays.x[id] += arrays.vx[id] * arrays.delay[id];
+      arrays.y[id] += arrays.vy[id] * arrays.delay[id];
+      arrays.z[id] += arrays.vz[id] * arrays.delay[id];
+      arrays.delay[id] = 0;
+      arraysEventSum += arrays.x[id] * arrays.vy[id];
+    }
+  const double arraysEventTime = seconds() - start;
+
+  if (particleSum != arraysEventSum)
+    {
+      std::cout << "The single particle updates differ" << std::endl;
+      return 1;
+    }
+
+  std::cerr << N << " particles, " << events << " single particle updates:"
+	    << " Particle array " << particleTime << "s,"
+	    << " structure of arrays " << arraysEventTime << "s\n";
+
+  return 0;
+}
@@ -0,0 +1,175 @@
+#include <dynamo/particlestream.hpp>
+#include <magnet/xmlreader.hpp>
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace dynamo;
+
+//A small deterministic generator, so the test needs no seed
+double nextValue()
+{
+  static unsigned long state = 12345;
+  state = (state * 1103515245 + 12345) % 2147483648UL;
+  return (double(state) / 2147483648.0 - 0.5) * 20;
+}
+
+void writeVector(std::ostream& os, const char* tag)
+{
+  char buf[128];
+  const double x = nextValue(), y = nextValue(), z = nextValue();
+  std::snprintf(buf, sizeof(buf), "      <%s x=\"%.14e\" y=\"%.14e\" z=\"%.14e\"/>\n", tag, x, y, z);
+  os << buf;
+}
+
+/* Writes a configuration in the format of DynamO. If scrambled, some
+   of the Pt tags have their IDs swapped or missing and the N
+   attribute is left out.
+ */
+std::string makeConfig(size_t N, bool orientation, bool scrambled)
+{
+  std::ostringstream os;
+  os << "<?xml version=\"1.0\"?>\n"
+     << "<DynamOconfig version=\"1.5.0\">\n"
+     << "  <Simulation lastMFT=\"1\">\n"
+     << "    <SimulationSize x=\"10\" y=\"10\" z=\"10\"/>\n"
+     << "  </Simulation>\n"
+     << "  <Properties/>\n"
+     << "  <ParticleData";
+  if (!scrambled) os << " N=\"" << N << "\"";
+  if (orientation) os << " OrientationData=\"Y\"";
+  os << ">\n";
+
+  for (size_t i(0); i < N; ++i)
+    {
+      size_t ID = i;
+      if (scrambled && (i % 10 == 4)) ID = i + 1;
+      if (scrambled && (i % 10 == 5)) ID = i - 1;
+
+      os << "    <Pt";
+      if (!scrambled || (i % 97 != 3)) os << " ID=\"" << ID << "\"";
+      os << " Mass=\"" << 1 + i % 3 << "\"";
+      if (i % 50 == 7) os << " Static=\"Static\"";
+      os << ">\n";
+      writeVector(os, "P");
+      writeVector(os, "V");
+      if (orientation)
+	{
+	  writeVector(os, "U");
+	  writeVector(os, "O");
+	}
+      os << "    </Pt>\n";
+    }
+
+  os << "  </ParticleData>\n"
+     << "  <History>Trailing data</History>\n"
+     << "</DynamOconfig>\n";
+  return os.str();
+}
+
+bool equal(const Vector& a, const Vector& b)
+{ return (a[0] == b[0]) && (a[1] == b[1]) && (a[2] == b[2]); }
+
+//Loads the configuration the way Dynamics::loadParticleXMLData does
+//from a DOM, and compares it against the stream reader
+bool compare(const std::string& config, size_t chunkSize, bool orientation, bool scrambled)
+{
+  magnet::xml::Document doc;
+  doc.getStoredXMLData() = config;
+  doc.parseData();
+  const magnet::xml::Node particleData
+    = doc.getNode("DynamOconfig").getNode("ParticleData");
+
+  ParticleStreamReader stream(chunkSize);
+  std::istringstream in(config);
+  magnet::xml::Document streamDoc;
+  stream.read(in, streamDoc.getStoredXMLData());
+  streamDoc.parseData();
+
+  const magnet::xml::Node streamData
+    = streamDoc.getNode("DynamOconfig").getNode("ParticleData");
+  if (streamData.hasNode("Pt") || !streamDoc.getNode("DynamOconfig").hasNode("History")
+      || (streamData.hasAttribute("N") == scrambled)
+      || (streamData.hasAttribute("OrientationData") != orientation))
+    {
+      std::cout << "The XML outside of the particle data was not kept, chunk size "
+		<< chunkSize << std::endl;
+      return false;
+    }
+
+  const ParticleContainer& particles = stream.getParticles();
+  const std::vector<double>& masses = stream.getAttribute("Mass");
+  bool outOfSequence = false;
+  size_t ID(0);
+  for (magnet::xml::Node node = particleData.fastGetNode("Pt"); node.valid(); ++node, ++ID)
+    {
+      if (!node.hasAttribute("ID") || (node.getAttribute("ID").as<size_t>() != ID))
+	outOfSequence = true;
+
+      const Particle part(node, ID);
+      if ((ID >= particles.size())
+	  || (particles[ID].getID() != ID)
+	  || !equal(particles[ID].getPosition(), part.getPosition())
+	  || !equal(particles[ID].getVelocity(), part.getVelocity())
+	  || (particles[ID].testState(Particle::DYNAMIC) != part.testState(Particle::DYNAMIC))
+	  || (masses[ID] != node.getAttribute("Mass").as<double>()))
+	{
+	  std::cout << "Particle " << ID << " differs, chunk size " << chunkSize << std::endl;
+	  return false;
+	}
+
+      if (orientation)
+	{
+	  Vector U, O;
+	  U << node.getNode("U");
+	  O << node.getNode("O");
+	  if (!equal(stream.getOrientations()[ID], U)
+	      || !equal(stream.getAngularVelocities()[ID], O))
+	    {
+	      std::cout << "Orientation " << ID << " differs, chunk size " << chunkSize << std::endl;
+	      return false;
+	    }
+	}
+    }
+
+  if ((ID != particles.size()) || (ID != stream.size()))
+    {
+      std::cout << "Read " << stream.size() << " particles, expected " << ID << std::endl;
+      return false;
+    }
+
+  if ((stream.outOfSequence() != outOfSequence) || (outOfSequence != scrambled))
+    {
+      std::cout << "The IDs were not found to be out of sequence, chunk size "
+		<< chunkSize << std::endl;
+      return false;
+    }
+
+  return true;
+}
+
+int main()
+{
+  //Chunks of a few bytes split every tag, the larger file crosses
+  //several chunks of the default size
+  const size_t smallChunks[] = {1, 2, 3, 7, 13, 64, 1000};
+  for (size_t i(0); i < sizeof(smallChunks) / sizeof(size_t); ++i)
+    for (int scrambled(0); scrambled < 2; ++scrambled)
+      if (!compare(makeConfig(200, !scrambled, scrambled), smallChunks[i], !scrambled, scrambled))
+	return 1;
+
+  const std::string large = makeConfig(20000, true, false);
+  if (large.size() < 3 * (1 << 20))
+    {
+      std::cout << "The large configuration is only " << large.size() << " bytes" << std::endl;
+      return 1;
+    }
+
+  if (!compare(large, 1 << 20, true, false) || !compare(large, 4099, true, false)
+      || !compare(makeConfig(20000, false, true), 1 << 20, false, true))
+    return 1;
+
+  return 0;
+}
@@ -0,0 +1,249 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <boost/iterator/iterator_facade.hpp>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <map>
+
+namespace magnet {
+  namespace containers {
+    /*! \brief A map-like container from integer bin indices to
+     * values, which stores a contiguous range of bins in an array.
+     *
+     * This is intended as the Container of a \ref FuzzyArray, where
+     * a std::map costs a tree search (and a node allocation for new
+     * bins) on every access. Here, the bins within a window
+     * [\ref _offset, \ref _offset + \ref _data.size()) are stored in a
+     * vector, which grows in both directions as new bins are
+     * accessed, so an access is an array look up.
+     *
+     * The window is only grown while it would remain reasonably
+     * dense (see \ref maxEmptyPerBin). Bins which are too far from
+     * the window are stored in a std::map, and are moved into the
+     * window if it later grows to cover them. Thus, histograms of
+     * bounded quantities are stored densely, and a few distant
+     * outliers do not cause a huge allocation.
+     *
+     * Like a std::map, only the bins which have been accessed are
+     * visited when iterating, and they are visited in ascending
+     * order. The iterators are read only and dereference to a
+     * std::pair<const long, T> by value.
+     *
+     * \tparam T The type stored in each bin.
+     */
+    template<class T>
+    class DenseBinArray
+    {
+      typedef std::map<long, T> Sparse;
+
+      enum {
+	//! The window may always grow to this many bins.
+	minDenseBins = 4096,
+	//! Otherwise, at most this many bins per accessed bin.
+	maxEmptyPerBin = 8
+      };
+
+    public:
+      typedef long key_type;
+      typedef T mapped_type;
+      typedef std::pair<const long, T> value_type;
+      typedef size_t size_type;
+
+      class const_iterator:
+	public boost::iterator_facade<const_iterator, value_type,
+				      boost::forward_traversal_tag, value_type>
+      {
+      public:
+	const_iterator(): _c(NULL), _phase(2), _idx(0) {}
+
+      private:
+	friend class DenseBinArray;
+	friend class boost::iterator_core_access;
+
+	/*! \brief The iterator first visits the sparse bins below
+	  the window (phase 0), then the accessed bins of the window
+	  (phase 1), then the sparse bins above the window (phase 2).
+	 */
+	const_iterator(const DenseBinArray* c, bool atEnd):
+	  _c(c), _split(c->_sparse.lower_bound(c->_offset)),
+	  _phase(0), _idx(0)
+	{
+	  if (atEnd)
+	    {
+	      _phase = 2;
+	      _idx = _c->_data.size();
+	      _sit = _c->_sparse.end();
+	    }
+	  else
+	    {
+	      _sit = _c->_sparse.begin();
+	      settle();
+	    }
+	}
+
+	void settle()
+	{
+	  if ((_phase == 0) && (_sit == _split))
+	    _phase = 1;
+
+	  if (_phase == 1)
+	    {
+	      while ((_idx < _c->_data.size()) && !_c->_used[_idx]) ++_idx;
+	      if (_idx == _c->_data.size()) _phase = 2;
+	    }
+	}
+
+	void increment()
+	{
+	  if (_phase == 1)
+	    ++_idx;
+	  else
+	    ++_sit;
+	  settle();
+	}
+
+	bool equal(const const_iterator& o) const
+	{ return (_phase == o._phase) && (_idx == o._idx) && (_sit == o._sit); }
+
+	value_type dereference() const
+	{
+	  if (_phase == 1)
+	    return value_type(_c->_offset + long(_idx), _c->_data[_idx]);
+	  return *_sit;
+	}
+
+	const DenseBinArray* _c;
+	typename Sparse::const_iterator _sit;
+	typename Sparse::const_iterator _split;
+	int _phase;
+	size_t _idx;
+      };
+
+      //! Bins may only be modified through \ref operator[].
+      typedef const_iterator iterator;
+
+      DenseBinArray(): _offset(0), _denseEntries(0) {}
+
+      /*! \brief Access a bin, default constructing it if it has not
+        been accessed before.
+       */
+      T& operator[](const long& bin)
+      {
+	if ((bin < _offset) || (bin >= _offset + long(_data.size())))
+	  if (!grow(bin))
+	    return _sparse[bin];
+
+	const size_t idx = bin - _offset;
+	if (!_used[idx])
+	  {
+	    _used[idx] = true;
+	    ++_denseEntries;
+	  }
+	return _data[idx];
+      }
+
+      const_iterator begin() const { return const_iterator(this, false); }
+      const_iterator end() const { return const_iterator(this, true); }
+
+      //! The number of bins which have been accessed.
+      size_t size() const { return _denseEntries + _sparse.size(); }
+
+      bool empty() const { return !size(); }
+
+      void clear()
+      {
+	_data.clear();
+	_used.clear();
+	_sparse.clear();
+	_offset = 0;
+	_denseEntries = 0;
+      }
+
+      //! The number of bins which are stored outside of the array.
+      size_t sparseSize() const { return _sparse.size(); }
+
+    private:
+      /*! \brief Try to grow the window to include the passed bin.
+
+        \returns false if the window would become too sparse, in
+        which case the bin is to be stored in \ref _sparse.
+       */
+      bool grow(const long bin)
+      {
+	const long window = _data.size();
+	const size_t limit = std::max<size_t>(minDenseBins,
+					      maxEmptyPerBin * (size() + 1));
+
+	if (!window)
+	  {
+	    //Start a fresh window, centred on the first bin
+	    const long newSize = 16;
+	    _data.assign(newSize, T());
+	    _used.assign(newSize, false);
+	    _offset = bin - newSize / 2;
+	    adoptSparse();
+	    return true;
+	  }
+
+	const long lo = std::min(bin, _offset);
+	const long hi = std::max(bin + 1, _offset + window);
+	if (size_t(hi - lo) > limit) return false;
+
+	//Double the window in the direction of growth, as far as the
+	//limit allows, so that the growth is amortised
+	const long newSize = std::max(hi - lo, std::min(2 * window, long(limit)));
+	const long newOffset = (bin < _offset) ? hi - newSize : lo;
+
+	std::vector<T> data(newSize, T());
+	std::vector<bool> used(newSize, false);
+	std::copy(_data.begin(), _data.end(), data.begin() + (_offset - newOffset));
+	std::copy(_used.begin(), _used.end(), used.begin() + (_offset - newOffset));
+	_data.swap(data);
+	_used.swap(used);
+	_offset = newOffset;
+	adoptSparse();
+	return true;
+      }
+
+      //! Move any sparse bins which are now within the window into it.
+      void adoptSparse()
+      {
+	typename Sparse::iterator it = _sparse.lower_bound(_offset);
+	const typename Sparse::iterator last
+	  = _sparse.lower_bound(_offset + long(_data.size()));
+
+	while (it != last)
+	  {
+	    const size_t idx = it->first - _offset;
+	    _data[idx] = it->second;
+	    _used[idx] = true;
+	    ++_denseEntries;
+	    _sparse.erase(it++);
+	  }
+      }
+
+      std::vector<T> _data;
+      std::vector<bool> _used;
+      long _offset;
+      size_t _denseEntries;
+      Sparse _sparse;
+    };
+  }
+}
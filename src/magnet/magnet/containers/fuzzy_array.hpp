@@ -36,6 +36,9 @@ namespace magnet {
       This class is space efficient as it uses a map to store the
       allocated bins. A map (not a unordered_map) must be the
       default, as histogramming output assumes the values are sorted.
+      Where the addressed range is bounded, a \ref DenseBinArray may
+      be used as the Container instead, which stores the bins in an
+      array but still iterates over them in order.
      
       Both the bin width and the inverse bin width are stored within
       the class. The inverse is stored as multiply operations are far
@@ -92,6 +95,23 @@ namespace magnet {
       T& operator[](const double& x)
       { return Container::operator[](lrint(x * _invBinWidth + shiftBin * 0.5)); }
 
+      /*! \brief Add the bins of another FuzzyArray to this one.
+
+        This allows separate arrays to be filled (e.g., one per
+        thread) and combined before they are output.
+       */
+      FuzzyArray& operator+=(const FuzzyArray& other)
+      {
+	if (other._binWidth != _binWidth)
+	  M_throw() << "Cannot combine FuzzyArrays with different bin widths";
+
+	for (typename Container::const_iterator it = other.Container::begin();
+	     it != other.Container::end(); ++it)
+	  Container::operator[]((*it).first) += (*it).second;
+
+	return *this;
+      }
+
     protected:
       double _binWidth;
       double _invBinWidth;
@@ -0,0 +1,164 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+namespace magnet {
+  namespace containers {
+    /*! \brief A vector-like container which stores its first N
+     * elements inline.
+     *
+     * This container only allocates from the heap once more than N
+     * elements are stored. It is intended for short lived containers
+     * which nearly always hold only a handful of elements, where a
+     * std::list or std::vector would allocate on every insertion.
+     *
+     * Only the operations required for appending, iterating and
+     * keeping a short array sorted are provided. Iterators are plain
+     * pointers and are invalidated by any insertion.
+     *
+     * \tparam T The type of the stored elements.
+     * \tparam N The number of elements stored inline.
+     */
+    template<class T, size_t N>
+    class SmallVector
+    {
+    public:
+      typedef T value_type;
+      typedef T& reference;
+      typedef const T& const_reference;
+      typedef T* iterator;
+      typedef const T* const_iterator;
+      typedef size_t size_type;
+
+      SmallVector(): _data(inlineData()), _size(0), _capacity(N) {}
+
+      SmallVector(const SmallVector& other):
+	_data(inlineData()), _size(0), _capacity(N)
+      {
+	reserve(other._size);
+	for (const_iterator it = other.begin(); it != other.end(); ++it)
+	  push_back(*it);
+      }
+
+      ~SmallVector()
+      {
+	clear();
+	if (!isInline()) ::operator delete(_data);
+      }
+
+      SmallVector& operator=(const SmallVector& other)
+      {
+	if (this == &other) return *this;
+	clear();
+	reserve(other._size);
+	for (const_iterator it = other.begin(); it != other.end(); ++it)
+	  push_back(*it);
+	return *this;
+      }
+
+      inline void push_back(const T& val)
+      {
+	if (_size == _capacity)
+	  {
+	    //Copy the value first, in case it is stored in this
+	    //container
+	    T tmp(val);
+	    reserve(2 * _capacity);
+	    new (_data + _size) T(tmp);
+	  }
+	else
+	  new (_data + _size) T(val);
+
+	++_size;
+      }
+
+      inline void pop_back() { _data[--_size].~T(); }
+
+      //! \brief Inserts an element before pos, returning an iterator to it.
+      iterator insert(iterator pos, const T& val)
+      {
+	const size_t index = pos - _data;
+	push_back(val);
+	std::rotate(_data + index, _data + _size - 1, _data + _size);
+	return _data + index;
+      }
+
+      //! \brief Removes an element, returning an iterator to the next one.
+      iterator erase(iterator pos)
+      {
+	std::copy(pos + 1, end(), pos);
+	pop_back();
+	return pos;
+      }
+
+      inline void clear()
+      {
+	for (size_t i(0); i < _size; ++i)
+	  _data[i].~T();
+	_size = 0;
+      }
+
+      void reserve(size_t newCapacity)
+      {
+	if (newCapacity <= _capacity) return;
+
+	T* newData = static_cast<T*>(::operator new(newCapacity * sizeof(T)));
+	for (size_t i(0); i < _size; ++i)
+	  {
+	    new (newData + i) T(_data[i]);
+	    _data[i].~T();
+	  }
+
+	if (!isInline()) ::operator delete(_data);
+	_data = newData;
+	_capacity = newCapacity;
+      }
+
+      inline size_t size() const { return _size; }
+      inline size_t capacity() const { return _capacity; }
+      inline bool empty() const { return !_size; }
+
+      inline iterator begin() { return _data; }
+      inline iterator end() { return _data + _size; }
+      inline const_iterator begin() const { return _data; }
+      inline const_iterator end() const { return _data + _size; }
+
+      inline T& operator[](size_t i) { return _data[i]; }
+      inline const T& operator[](size_t i) const { return _data[i]; }
+
+      inline T& front() { return _data[0]; }
+      inline const T& front() const { return _data[0]; }
+      inline T& back() { return _data[_size - 1]; }
+      inline const T& back() const { return _data[_size - 1]; }
+
+    private:
+      inline T* inlineData() { return reinterpret_cast<T*>(_inline.address()); }
+      inline bool isInline() const { return _data == reinterpret_cast<const T*>(_inline.address()); }
+
+      typename boost::aligned_storage<N * sizeof(T), boost::alignment_of<T>::value>::type _inline;
+      T* _data;
+      size_t _size;
+      size_t _capacity;
+    };
+  }
+}
@@ -17,15 +17,24 @@
 
 #pragma once
 #include <magnet/containers/fuzzy_array.hpp>
+#include <magnet/containers/dense_bin_array.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <boost/foreach.hpp>
 
 namespace magnet {
   namespace math {
-    template<bool shiftBin=false>
-    class Histogram : public magnet::containers::FuzzyArray<unsigned long, shiftBin>
+    /*! \brief A histogram of sampled values.
+
+      The bins are stored in a \ref magnet::containers::DenseBinArray
+      by default, which only falls back to sparse storage for bins
+      far from the sampled range. Any sorted map-like container of
+      bins may be passed as Bins instead.
+     */
+    template<bool shiftBin=false,
+	     class Bins = magnet::containers::DenseBinArray<unsigned long> >
+    class Histogram : public magnet::containers::FuzzyArray<unsigned long, shiftBin, Bins>
     {
-      typedef typename magnet::containers::FuzzyArray<unsigned long,shiftBin> Container;
+      typedef typename magnet::containers::FuzzyArray<unsigned long, shiftBin, Bins> Container;
 
     public:
       Histogram(double binwidth):
@@ -42,6 +51,17 @@ namespace magnet {
 	++(Container::operator[](val));
 	++sampleCount;
       }
+
+      /*! \brief Add the samples of another histogram to this one.
+	
+	The histograms must have the same bin width.
+       */
+      Histogram& operator+=(const Histogram& other)
+      {
+	Container::operator+=(other);
+	sampleCount += other.sampleCount;
+	return *this;
+      }
   
       void outputHistogram(magnet::xml::XmlStream& XML, double scalex) const
       {
@@ -74,10 +94,15 @@ namespace magnet {
       unsigned long sampleCount;
     };
 
-    template<bool shiftBin=false>
-    class HistogramWeighted: public magnet::containers::FuzzyArray<double,shiftBin>
+    /*! \brief A histogram where each sample carries a weight.
+
+      \sa Histogram
+     */
+    template<bool shiftBin=false,
+	     class Bins = magnet::containers::DenseBinArray<double> >
+    class HistogramWeighted: public magnet::containers::FuzzyArray<double, shiftBin, Bins>
     {
-      typedef magnet::containers::FuzzyArray<double> Container;
+      typedef typename magnet::containers::FuzzyArray<double, shiftBin, Bins> Container;
     public:
       HistogramWeighted(double binwidth):
 	Container(binwidth),
@@ -93,6 +118,17 @@ namespace magnet {
 	Container::operator[](val) += weight;
 	sampleCount += weight;
       }
+
+      /*! \brief Add the samples of another histogram to this one.
+	
+	The histograms must have the same bin width.
+       */
+      HistogramWeighted& operator+=(const HistogramWeighted& other)
+      {
+	Container::operator+=(other);
+	sampleCount += other.sampleCount;
+	return *this;
+      }
     
       void outputHistogram(magnet::xml::XmlStream& XML, double scalex) const
       {
@@ -103,7 +139,7 @@ namespace magnet {
 	    << magnet::xml::attr("BinWidth") << Container::getBinWidth() * scalex;
   
 	double avgSum = 0.0;
-	BOOST_FOREACH(const Container::value_type &p1, *this)
+	BOOST_FOREACH(const typename Container::value_type &p1, *this)
 	  avgSum += static_cast<double>(p1.first + 0.5 * shiftBin) * p1.second;
   
 	XML << magnet::xml::attr("AverageVal")
@@ -111,7 +147,7 @@ namespace magnet {
 	    << magnet::xml::chardata();
   
 	//This gives mathmatically correct but not really pretty
-	BOOST_FOREACH(const Container::value_type &p1, *this)
+	BOOST_FOREACH(const typename Container::value_type &p1, *this)
 	  XML << (p1.first + 0.5 * shiftBin) * Container::getBinWidth() * scalex << " "
 	      << static_cast<double>(p1.second)
 	  / (Container::getBinWidth() * sampleCount * scalex) << "\n";
@@ -130,7 +166,7 @@ namespace magnet {
 	    << magnet::xml::attr("BinWidth") << Container::getBinWidth() * scalex;
   
 	double avgSum = 0.0;
-	BOOST_FOREACH(const Container::value_type &p1, *this)
+	BOOST_FOREACH(const typename Container::value_type &p1, *this)
 	  avgSum += static_cast<double>(p1.first + 0.5 * shiftBin)* p1.second;
   
 	XML << magnet::xml::attr("AverageVal")
@@ -138,7 +174,7 @@ namespace magnet {
 	    << magnet::xml::chardata();
     
 	//This one gives histograms usable by the reweight program
-	BOOST_FOREACH(const Container::value_type &p1, *this)
+	BOOST_FOREACH(const typename Container::value_type &p1, *this)
 	  XML << (p1.first + 0.5 * shiftBin) * Container::getBinWidth() * scalex << " " 
 	      << static_cast<double>(p1.second)
 	  / (Container::getBinWidth() * sampleCount * scalex) << "\n";
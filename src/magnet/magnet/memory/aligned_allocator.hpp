@@ -0,0 +1,97 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <boost/static_assert.hpp>
+#include <cstdlib>
+#include <cstddef>
+#include <limits>
+#include <new>
+
+namespace magnet {
+  namespace memory {
+    /*! \brief A standard library allocator which returns memory
+     * aligned to a fixed boundary.
+     *
+     * The default allocators only guarantee alignment suitable for
+     * the fundamental types. This allocator can be used to make a
+     * container start on a cache line boundary, so that fixed size
+     * elements (e.g., 64 byte elements with a 64 byte alignment)
+     * never straddle two cache lines.
+     *
+     * \tparam T The type of object to allocate.
+     * \tparam Alignment The required alignment in bytes. This must be
+     * a power of two and a multiple of sizeof(void*).
+     */
+    template<class T, size_t Alignment = 64>
+    class AlignedAllocator
+    {
+      BOOST_STATIC_ASSERT(!(Alignment & (Alignment - 1)));
+      BOOST_STATIC_ASSERT(!(Alignment % sizeof(void*)));
+
+    public:
+      typedef T value_type;
+      typedef T* pointer;
+      typedef const T* const_pointer;
+      typedef T& reference;
+      typedef const T& const_reference;
+      typedef size_t size_type;
+      typedef std::ptrdiff_t difference_type;
+
+      template<class U>
+      struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+      AlignedAllocator() throw() {}
+      AlignedAllocator(const AlignedAllocator&) throw() {}
+      template<class U>
+      AlignedAllocator(const AlignedAllocator<U, Alignment>&) throw() {}
+
+      pointer address(reference x) const { return &x; }
+      const_pointer address(const_reference x) const { return &x; }
+
+      pointer allocate(size_type n, const void* = 0)
+      {
+	if (n > max_size()) throw std::bad_alloc();
+
+	void* ptr(0);
+	if (posix_memalign(&ptr, Alignment, n * sizeof(T)))
+	  throw std::bad_alloc();
+
+	return static_cast<pointer>(ptr);
+      }
+
+      void deallocate(pointer p, size_type) { free(p); }
+
+      size_type max_size() const throw()
+      { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+      void construct(pointer p, const T& val) { new (static_cast<void*>(p)) T(val); }
+
+      void destroy(pointer p) { p->~T(); }
+    };
+
+    template<class T, class U, size_t Alignment>
+    inline bool operator==(const AlignedAllocator<T, Alignment>&,
+			   const AlignedAllocator<U, Alignment>&)
+    { return true; }
+
+    template<class T, class U, size_t Alignment>
+    inline bool operator!=(const AlignedAllocator<T, Alignment>&,
+			   const AlignedAllocator<U, Alignment>&)
+    { return false; }
+  }
+}
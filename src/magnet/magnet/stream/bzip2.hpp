@@ -0,0 +1,406 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <magnet/thread/workstealing.hpp>
+#include <magnet/exception.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/operations.hpp>
+#include <tr1/memory>
+#include <bzlib.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace magnet {
+  namespace stream {
+    namespace detail {
+      /*! \brief A piece of a bzip2 file which is compressed or
+          decompressed as an independent task.
+       */
+      struct Bzip2Block
+      {
+	Bzip2Block(): input(NULL), inputLength(0), status(BZ_OK) {}
+
+	const char* input;
+	size_t inputLength;
+	std::vector<char> output;
+	int status;
+
+	//! \brief Compresses the input into a single bzip2 stream.
+	void compress()
+	{
+	  //The worst case expansion given in the bzip2 manual
+	  unsigned int length = inputLength + inputLength / 100 + 600;
+	  output.resize(length);
+	  //bzip2 rejects a NULL source, even if it is empty
+	  char empty(0);
+	  status = BZ2_bzBuffToBuffCompress(&output[0], &length, input ? const_cast<char*>(input) : &empty,
+					    inputLength, 9, 0, 0);
+	  output.resize(length);
+	}
+
+	/*! \brief Decompresses the input, which must be one or more
+	    complete bzip2 streams.
+
+	  status is set to BZ_OK if all of the input was decompressed.
+	 */
+	void decompress()
+	{
+	  output.clear();
+	  output.reserve(5 * inputLength);
+	  const size_t chunk = 1 << 20;
+
+	  size_t pos(0);
+	  while (pos < inputLength)
+	    {
+	      bz_stream strm;
+	      std::memset(&strm, 0, sizeof(strm));
+	      if ((status = BZ2_bzDecompressInit(&strm, 0, 0)) != BZ_OK) return;
+
+	      strm.next_in = const_cast<char*>(input + pos);
+	      strm.avail_in = inputLength - pos;
+
+	      for (;;)
+		{
+		  const size_t old = output.size();
+		  output.resize(old + chunk);
+		  strm.next_out = &output[old];
+		  strm.avail_out = chunk;
+		  status = BZ2_bzDecompress(&strm);
+		  output.resize(old + chunk - strm.avail_out);
+
+		  if (status == BZ_STREAM_END) break;
+
+		  //Either an error, or the stream is truncated
+		  if ((status != BZ_OK) || (!strm.avail_in && strm.avail_out))
+		    {
+		      if (status == BZ_OK) status = BZ_UNEXPECTED_EOF;
+		      BZ2_bzDecompressEnd(&strm);
+		      return;
+		    }
+		}
+
+	      pos = inputLength - strm.avail_in;
+	      BZ2_bzDecompressEnd(&strm);
+	    }
+
+	  status = BZ_OK;
+	}
+      };
+
+      //! \brief Calls a method of a block, by index.
+      struct Bzip2BlockCall
+      {
+	Bzip2BlockCall(std::vector<Bzip2Block>& b, void (Bzip2Block::*f)()):
+	  blocks(b), func(f) {}
+	void operator()(size_t i) const { (blocks[i].*func)(); }
+	std::vector<Bzip2Block>& blocks;
+	void (Bzip2Block::*func)();
+      };
+
+      //! \brief Runs the compress or decompress method of every block.
+      inline void processBlocks(std::vector<Bzip2Block>& blocks, void (Bzip2Block::*func)(),
+				thread::WorkStealingPool* pool)
+      {
+	if (pool && pool->getThreadCount() && (blocks.size() > 1))
+	  pool->parallel_for(0, blocks.size(), Bzip2BlockCall(blocks, func), 1);
+	else
+	  for (size_t i(0); i < blocks.size(); ++i)
+	    (blocks[i].*func)();
+      }
+    }
+
+    /*! \brief A boost::iostreams filter which compresses the data
+        into bzip2 format using a WorkStealingPool.
+
+      The data is split into blocks which are compressed as separate
+      bzip2 streams and concatenated (as done by pbzip2). The result
+      is readable by any bzip2 decompressor, e.g., bzcat or
+      boost::iostreams::bzip2_decompressor.
+
+      \code
+      boost::iostreams::filtering_ostream os;
+      os.push(ParallelBzip2Compressor(&pool));
+      os.push(boost::iostreams::file_sink("file.bz2"));
+      \endcode
+     */
+    class ParallelBzip2Compressor
+    {
+    public:
+      typedef char char_type;
+      struct category: boost::iostreams::output_filter_tag,
+		       boost::iostreams::multichar_tag,
+		       boost::iostreams::closable_tag {};
+
+      /*! \param pool The WorkStealingPool to compress the blocks with. If
+          this is NULL, the blocks are compressed by the calling thread.
+	  \param blockSize The number of bytes compressed into each
+	  bzip2 stream.
+       */
+      ParallelBzip2Compressor(thread::WorkStealingPool* pool = NULL, size_t blockSize = 900000):
+	_state(new State(pool, blockSize)) {}
+
+      template<class Sink>
+      std::streamsize write(Sink& snk, const char* s, std::streamsize n)
+      {
+	State& state = *_state;
+	const char* end = s + n;
+	while (s != end)
+	  {
+	    const size_t count = std::min(size_t(end - s), state.blockSize - state.buffer.size());
+	    state.buffer.insert(state.buffer.end(), s, s + count);
+	    s += count;
+
+	    if (state.buffer.size() == state.blockSize)
+	      {
+		state.pending.push_back(std::vector<char>());
+		state.pending.back().swap(state.buffer);
+		state.buffer.reserve(state.blockSize);
+
+		if (state.pending.size() >= state.batchSize())
+		  flush(snk);
+	      }
+	  }
+
+	return n;
+      }
+
+      template<class Sink>
+      void close(Sink& snk)
+      {
+	State& state = *_state;
+	//Always write at least one stream, so that empty data gives a
+	//valid bzip2 file
+	if (!state.buffer.empty() || (!state.written && state.pending.empty()))
+	  {
+	    state.pending.push_back(std::vector<char>());
+	    state.pending.back().swap(state.buffer);
+	  }
+	flush(snk);
+	state.written = false;
+      }
+
+    private:
+      struct State
+      {
+	State(thread::WorkStealingPool* p, size_t size):
+	  pool(p), blockSize(size), written(false)
+	{ buffer.reserve(blockSize); }
+
+	size_t batchSize() const { return (pool && pool->getThreadCount()) ? pool->getThreadCount() : 1; }
+
+	thread::WorkStealingPool* pool;
+	size_t blockSize;
+	bool written;
+	std::vector<char> buffer;
+	std::vector<std::vector<char> > pending;
+      };
+
+      template<class Sink>
+      void flush(Sink& snk)
+      {
+	State& state = *_state;
+	std::vector<detail::Bzip2Block> blocks(state.pending.size());
+	for (size_t i(0); i < blocks.size(); ++i)
+	  {
+	    blocks[i].input = state.pending[i].empty() ? NULL : &state.pending[i][0];
+	    blocks[i].inputLength = state.pending[i].size();
+	  }
+
+	detail::processBlocks(blocks, &detail::Bzip2Block::compress, state.pool);
+
+	for (size_t i(0); i < blocks.size(); ++i)
+	  {
+	    if (blocks[i].status != BZ_OK)
+	      M_throw() << "bzip2 compression failed with error code " << blocks[i].status;
+	    boost::iostreams::write(snk, &blocks[i].output[0], blocks[i].output.size());
+	  }
+
+	state.pending.clear();
+	state.written = true;
+      }
+
+      std::tr1::shared_ptr<State> _state;
+    };
+
+    /*! \brief A boost::iostreams filter which decompresses bzip2
+        data using a WorkStealingPool.
+
+      Files made of many bzip2 streams (such as those written by
+      ParallelBzip2Compressor or pbzip2) are split at the start of
+      each stream and the streams are decompressed in parallel. Files
+      holding a single stream (e.g., from the standard bzip2) are
+      read completely and decompressed by a single thread.
+     */
+    class ParallelBzip2Decompressor
+    {
+    public:
+      typedef char char_type;
+      struct category: boost::iostreams::input_filter_tag,
+		       boost::iostreams::multichar_tag {};
+
+      /*! \param pool The WorkStealingPool to decompress the streams with.
+	  If this is NULL, the streams are decompressed by the calling
+	  thread.
+	  \param readSize The number of compressed bytes read per thread
+	  before the streams are decompressed.
+       */
+      ParallelBzip2Decompressor(thread::WorkStealingPool* pool = NULL, size_t readSize = 1 << 20):
+	_state(new State(pool, readSize)) {}
+
+      template<class Source>
+      std::streamsize read(Source& src, char* s, std::streamsize n)
+      {
+	State& state = *_state;
+	while (state.outputPos == state.output.size())
+	  {
+	    if (state.eof && state.input.empty()) return -1;
+	    fill(src);
+	    decode();
+	  }
+
+	const std::streamsize count = std::min(std::streamsize(state.output.size() - state.outputPos), n);
+	std::memcpy(s, &state.output[state.outputPos], count);
+	state.outputPos += count;
+	return count;
+      }
+
+    private:
+      struct State
+      {
+	State(thread::WorkStealingPool* p, size_t size):
+	  pool(p), readSize(size), eof(false), outputPos(0), scanPos(1) {}
+
+	size_t threads() const { return (pool && pool->getThreadCount()) ? pool->getThreadCount() : 1; }
+
+	thread::WorkStealingPool* pool;
+	size_t readSize;
+	bool eof;
+	std::vector<char> input;
+	std::vector<char> output;
+	size_t outputPos;
+	//! \brief The stream headers found in the input (excluding the first).
+	std::vector<size_t> starts;
+	//! \brief The first position of the input not yet searched for stream headers.
+	size_t scanPos;
+      };
+
+      //! \brief Reads the next window of compressed data.
+      template<class Source>
+      void fill(Source& src)
+      {
+	State& state = *_state;
+	const size_t target = state.input.size() + state.threads() * state.readSize;
+	while (!state.eof && (state.input.size() < target))
+	  {
+	    const size_t old = state.input.size();
+	    state.input.resize(target);
+	    std::streamsize count = boost::iostreams::read(src, &state.input[old], target - old);
+	    if (count < 0)
+	      {
+		state.eof = true;
+		count = 0;
+	      }
+	    state.input.resize(old + count);
+	  }
+      }
+
+      /*! \brief Tests if a bzip2 stream header followed by a block
+          header starts at a position of the input.
+
+	This may also match compressed data, so any split made at
+	such a position is checked when it is decompressed.
+       */
+      bool isStreamStart(size_t pos) const
+      {
+	const std::vector<char>& input = _state->input;
+	return (pos + 10 <= input.size())
+	  && (input[pos] == 'B') && (input[pos + 1] == 'Z') && (input[pos + 2] == 'h')
+	  && (input[pos + 3] >= '1') && (input[pos + 3] <= '9')
+	  && !std::memcmp(&input[pos + 4], "1AY&SY", 6);
+      }
+
+      //! \brief Decompresses the complete streams in the input.
+      void decode()
+      {
+	State& state = *_state;
+	state.output.clear();
+	state.outputPos = 0;
+
+	//Split the input at the stream headers. Unless the end of the
+	//file has been reached, the last stream may be incomplete and
+	//is kept for the next pass.
+	for (; state.scanPos + 10 <= state.input.size(); ++state.scanPos)
+	  if (isStreamStart(state.scanPos))
+	    state.starts.push_back(state.scanPos);
+
+	std::vector<size_t> starts(1, 0);
+	starts.insert(starts.end(), state.starts.begin(), state.starts.end());
+	if (state.eof)
+	  starts.push_back(state.input.size());
+
+	if (starts.size() < 2) return;
+
+	std::vector<detail::Bzip2Block> blocks(starts.size() - 1);
+	for (size_t i(0); i < blocks.size(); ++i)
+	  {
+	    blocks[i].input = &state.input[starts[i]];
+	    blocks[i].inputLength = starts[i + 1] - starts[i];
+	  }
+
+	detail::processBlocks(blocks, &detail::Bzip2Block::decompress, state.pool);
+
+	size_t consumed = 0;
+	for (size_t i(0); i < blocks.size(); ++i)
+	  {
+	    //A failed block was split at a false stream header, so
+	    //join it to the next block and try again
+	    while ((blocks[i].status != BZ_OK) && (i + 1 < blocks.size()))
+	      {
+		blocks[i + 1].input = blocks[i].input;
+		blocks[i + 1].inputLength += blocks[i].inputLength;
+		++i;
+		blocks[i].decompress();
+	      }
+
+	    if (blocks[i].status != BZ_OK)
+	      {
+		if (state.eof)
+		  M_throw() << "bzip2 decompression failed with error code " << blocks[i].status;
+		//Leave the block with the incomplete stream
+		break;
+	      }
+
+	    state.output.insert(state.output.end(), blocks[i].output.begin(), blocks[i].output.end());
+	    consumed = (blocks[i].input - &state.input[0]) + blocks[i].inputLength;
+	  }
+
+	state.input.erase(state.input.begin(), state.input.begin() + consumed);
+
+	std::vector<size_t> remaining;
+	for (size_t i(0); i < state.starts.size(); ++i)
+	  if (state.starts[i] > consumed)
+	    remaining.push_back(state.starts[i] - consumed);
+	state.starts.swap(remaining);
+	state.scanPos = std::max(state.scanPos, consumed + 1) - consumed;
+      }
+
+      std::tr1::shared_ptr<State> _state;
+    };
+  }
+}
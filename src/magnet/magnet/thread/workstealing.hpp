@@ -0,0 +1,773 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*! \file workstealing.hpp
+ * \brief Contains the definition of WorkStealingPool
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <new>
+
+#include <magnet/exception.hpp>
+#include <magnet/thread/threadgroup.hpp>
+#include <magnet/thread/mutex.hpp>
+
+namespace magnet {
+  namespace thread {
+    class WorkStealingPool;
+
+    namespace detail {
+      /*! \brief A unit of work queued in a WorkStealingPool.
+
+	The functor is copied into the job's own storage if it fits,
+	so the common small tasks do not allocate. Jobs are recycled
+	through free lists once the pool and every Future have
+	released them.
+       */
+      struct WSJob
+      {
+	enum { storageSize = 64 };
+
+	void (*run)(WSJob*);
+	void (*destroy)(WSJob*);
+
+	//! \brief The number of references held by the pool and Futures.
+	volatile size_t refs;
+	//! \brief Set to zero once the job has run.
+	volatile size_t remaining;
+	//! \brief If set, a Future reports any exception instead of the pool.
+	bool hasFuture;
+	bool failed;
+	std::string error;
+
+	union
+	{
+	  char bytes[storageSize];
+	  double alignDouble;
+	  long long alignLong;
+	  void* alignPointer;
+	} storage;
+      };
+
+      //! \brief Stores and calls a functor held inside a WSJob.
+      template<class F, bool inplace = (sizeof(F) <= WSJob::storageSize)>
+      struct WSFunctor
+      {
+	static F* get(WSJob* job) { return reinterpret_cast<F*>(job->storage.bytes); }
+	static void construct(WSJob* job, const F& func) { new (job->storage.bytes) F(func); }
+	static void run(WSJob* job) { (*get(job))(); }
+	static void destroy(WSJob* job) { get(job)->~F(); }
+      };
+
+      //! \brief Large functors are stored on the heap.
+      template<class F>
+      struct WSFunctor<F, false>
+      {
+	static F*& get(WSJob* job) { return *reinterpret_cast<F**>(job->storage.bytes); }
+	static void construct(WSJob* job, const F& func) { get(job) = new F(func); }
+	static void run(WSJob* job) { (*get(job))(); }
+	static void destroy(WSJob* job) { delete get(job); }
+      };
+
+      //! \brief Runs and deletes a function::Task.
+      struct WSTask
+      {
+	static function::Task*& get(WSJob* job) { return *reinterpret_cast<function::Task**>(job->storage.bytes); }
+	static void run(WSJob* job) { (*get(job))(); }
+	static void destroy(WSJob* job) { delete get(job); }
+      };
+
+      /*! \brief An index range split into chunks, which are claimed
+	  in order by any thread working on it.
+
+	  The Body is called as body(chunk, first, last).
+       */
+      template<class Body>
+      struct WSRange
+      {
+	WSRange(size_t b, size_t e, size_t g, const Body& bd):
+	  begin(b), end(e), grain(g), chunks((e - b + g - 1) / g), next(0), body(bd) {}
+
+	void run()
+	{
+	  for (;;)
+	    {
+	      const size_t chunk = __sync_fetch_and_add(&next, size_t(1));
+	      if (chunk >= chunks) return;
+	      const size_t first = begin + chunk * grain;
+	      body(chunk, first, std::min(first + grain, end));
+	    }
+	}
+
+	//! \brief Stops any further chunks from being started.
+	void abort() { next = chunks; }
+
+	size_t begin, end, grain, chunks;
+	volatile size_t next;
+	const Body& body;
+      };
+
+      //! \brief A task which works on a WSRange.
+      template<class Body>
+      struct WSRangeHelper
+      {
+	WSRangeHelper(WSRange<Body>* r): range(r) {}
+	void operator()() const { range->run(); }
+	WSRange<Body>* range;
+      };
+
+      //! \brief The WSRange Body of WorkStealingPool::parallel_for.
+      template<class F>
+      struct WSForBody
+      {
+	WSForBody(const F& f): func(f) {}
+	void operator()(size_t, size_t first, size_t last) const
+	{
+	  for (size_t i(first); i < last; ++i)
+	    func(i);
+	}
+	const F& func;
+      };
+
+      //! \brief The WSRange Body of WorkStealingPool::parallel_reduce.
+      template<class T, class F>
+      struct WSReduceBody
+      {
+	WSReduceBody(const F& f, std::vector<T>& p): func(f), partials(p) {}
+	void operator()(size_t chunk, size_t first, size_t last) const
+	{
+	  T& acc = partials[chunk];
+	  for (size_t i(first); i < last; ++i)
+	    func(i, acc);
+	}
+	const F& func;
+	std::vector<T>& partials;
+      };
+    }
+
+    /*! \brief A pool of worker threads which balance their load by
+     * stealing tasks from each other.
+     *
+     * Each worker has its own deque of tasks. A worker pushes the
+     * tasks it creates onto the back of its own deque and takes work
+     * from the back too, so nested tasks stay on the thread (and
+     * cache) that made them. An idle worker takes work from the tasks
+     * submitted by other threads, then steals from the front of the
+     * other workers' deques. As every deque has its own lock, the
+     * workers rarely contend for the same one, unlike the single
+     * queue of the ThreadPool.
+     *
+     * The task storage is pooled, so submitting a small functor does
+     * not allocate once the pool has warmed up.
+     *
+     * Any thread waiting on a Future, or in one of the parallel
+     * algorithms, runs queued tasks until its wait is over. This
+     * makes it safe to submit and wait on tasks from inside a task,
+     * and lets the pool run in 0 thread mode, where the waiting thread
+     * does all of the work.
+     *
+     * The interface of the ThreadPool (queueTask, queueTasks and
+     * wait()) is also provided.
+     */
+    class WorkStealingPool
+    {
+    public:
+      /*! \brief A handle to a submitted task which may be waited on.
+       *
+       * Futures may be copied freely; the task's storage is held
+       * until the task has run and every handle is destroyed. A Future
+       * must not outlive its pool.
+       */
+      class Future
+      {
+      public:
+	Future(): _pool(NULL), _job(NULL) {}
+
+	Future(const Future& other):
+	  _pool(other._pool), _job(other._job)
+	{ if (_job) __sync_add_and_fetch(&_job->refs, size_t(1)); }
+
+	Future& operator=(const Future& other)
+	{
+	  if (other._job) __sync_add_and_fetch(&other._job->refs, size_t(1));
+	  if (_job) _pool->release(_job);
+	  _pool = other._pool;
+	  _job = other._job;
+	  return *this;
+	}
+
+	~Future() { if (_job) _pool->release(_job); }
+
+	//! \brief Tests if this Future refers to a task.
+	bool valid() const { return _job != NULL; }
+
+	//! \brief Tests if the task has run.
+	bool ready() const { return !_job->remaining; }
+
+	/*! \brief Waits for the task to run, running other tasks in
+	 * the meantime.
+	 *
+	 * If the task threw an exception, it is rethrown here.
+	 */
+	void wait()
+	{
+	  _pool->helpUntil(_job->remaining);
+	  if (_job->failed)
+	    M_throw() << "Task threw an exception:-" << _job->error;
+	}
+
+      private:
+	friend class WorkStealingPool;
+
+	Future(WorkStealingPool* pool, detail::WSJob* job):
+	  _pool(pool), _job(job)
+	{ __sync_add_and_fetch(&_job->refs, size_t(1)); }
+
+	WorkStealingPool* _pool;
+	detail::WSJob* _job;
+      };
+
+      /*! \brief Default Constructor
+       *
+       * This initialises the pool to 0 threads
+       */
+      inline WorkStealingPool():
+	_exception_flag(false),
+	_pending(0),
+	_queued(0),
+	_sleeping(0),
+	_waiters(0),
+	_stop_flag(false)
+      {}
+
+      /*! \brief Destructor
+       *
+       * Join all threads in the pool and wait until they are terminated.
+       */
+      inline ~WorkStealingPool() throw()
+      {
+	stop();
+
+	for (size_t i(0); i < _workers.size(); ++i)
+	  {
+	    freeJobs(_workers[i]->jobs);
+	    freeJobs(_workers[i]->cache);
+	    delete _workers[i];
+	  }
+	freeJobs(_external.jobs);
+	freeJobs(_freeJobs);
+      }
+
+      /*! \brief Set the number of threads in the pool
+       *
+       * The current threads are stopped (once they have run every
+       * queued task) and the pool is restarted with the new number of
+       * threads. This must not be called while tasks are running.
+       */
+      inline void setThreadCount(size_t x)
+      {
+	if (x == _threads.size()) return;
+
+	stop();
+	_stop_flag = false;
+
+	//Hand any tasks left on the old workers to the new ones
+	for (size_t i(0); i < _workers.size(); ++i)
+	  {
+	    _external.jobs.insert(_external.jobs.end(), _workers[i]->jobs.begin(), _workers[i]->jobs.end());
+	    _external.size = _external.jobs.size();
+	    _freeJobs.insert(_freeJobs.end(), _workers[i]->cache.begin(), _workers[i]->cache.end());
+	    delete _workers[i];
+	  }
+
+	_workers.resize(x);
+	for (size_t i(0); i < x; ++i)
+	  _workers[i] = new Worker;
+
+	for (size_t i(0); i < x; ++i)
+	  _threads.create_thread(function::Task::makeTask(&WorkStealingPool::beginThread, this, i));
+      }
+
+      /*! \brief The current number of threads in the pool */
+      inline size_t getThreadCount() const { return _threads.size(); }
+
+      /*! \brief Queue a functor to be run by the pool.
+       *
+       * The functor is copied, and its operator()() is called once by
+       * some thread of the pool (or a waiting thread).
+       */
+      template<class F>
+      inline Future submit(const F& func)
+      {
+	detail::WSJob* job = allocate();
+	detail::WSFunctor<F>::construct(job, func);
+	job->run = &detail::WSFunctor<F>::run;
+	job->destroy = &detail::WSFunctor<F>::destroy;
+	job->hasFuture = true;
+	Future future(this, job);
+	push(job);
+	return future;
+      }
+
+      /*! \brief Queue a Task to be run by the pool, which takes
+       * ownership of the Task.
+       */
+      inline Future submit(function::Task* task)
+      {
+	detail::WSJob* job = makeTaskJob(task);
+	job->hasFuture = true;
+	Future future(this, job);
+	push(job);
+	return future;
+      }
+
+      /*! \brief Queue a Task which is not waited on individually.
+       *
+       * Any exception it throws is reported by wait().
+       */
+      inline void queueTask(function::Task* task)
+      { push(makeTaskJob(task)); }
+
+      inline void queueTasks(std::vector<function::Task*>& tasks)
+      {
+	for (std::vector<function::Task*>::const_iterator iPtr = tasks.begin();
+	     iPtr != tasks.end(); ++iPtr)
+	  queueTask(*iPtr);
+	tasks.clear();
+      }
+
+      /*! \brief Wait for all tasks to complete.
+       *
+       * The calling thread runs tasks until none are left. This must
+       * not be called from inside a task, as the task would wait for
+       * itself; wait on a Future instead.
+       */
+      inline void wait()
+      {
+	helpUntil(_pending);
+
+	ScopedLock lock(_exception_mutex);
+	if (_exception_flag)
+	  {
+	    std::string data = _exception_data.str();
+	    _exception_data.str("");
+	    _exception_flag = false;
+	    M_throw() << "Thread Exception found while waiting for tasks/threads to finish"
+		      << data;
+	  }
+      }
+
+      /*! \brief Calls func(i) for every i in [begin, end).
+       *
+       * The range is split into chunks of grain indices, which are
+       * worked on by the calling thread and as many of the pool's
+       * threads as are free. func is shared between the threads, so
+       * its operator() must be const and safe to call concurrently.
+       *
+       * \param grain The number of indices in each chunk. If zero, a
+       * chunk size giving several chunks per thread is used.
+       */
+      template<class F>
+      inline void parallel_for(size_t begin, size_t end, const F& func, size_t grain = 0)
+      {
+	if (end <= begin) return;
+	detail::WSForBody<F> body(func);
+	detail::WSRange<detail::WSForBody<F> > range(begin, end, defaultGrain(begin, end, grain), body);
+	runRange(range);
+      }
+
+      /*! \brief Reduces func over the range [begin, end).
+       *
+       * Each chunk of the range is accumulated into its own copy of
+       * identity by calling func(i, acc) for each index, then the
+       * chunks are combined in order using op(a, b). The result is
+       * therefore reproducible for a fixed grain, however the chunks
+       * were scheduled.
+       *
+       * \param grain The number of indices in each chunk. If zero, a
+       * chunk size giving several chunks per thread is used.
+       */
+      template<class T, class F, class Op>
+      inline T parallel_reduce(size_t begin, size_t end, const T& identity, const F& func, Op op, size_t grain = 0)
+      {
+	if (end <= begin) return identity;
+	grain = defaultGrain(begin, end, grain);
+	std::vector<T> partials((end - begin + grain - 1) / grain, identity);
+	detail::WSReduceBody<T, F> body(func, partials);
+	detail::WSRange<detail::WSReduceBody<T, F> > range(begin, end, grain, body);
+	runRange(range);
+
+	T result(identity);
+	for (typename std::vector<T>::const_iterator iPtr = partials.begin();
+	     iPtr != partials.end(); ++iPtr)
+	  result = op(result, *iPtr);
+	return result;
+      }
+
+    private:
+      WorkStealingPool(const WorkStealingPool&);
+      WorkStealingPool& operator=(const WorkStealingPool&);
+
+      static const size_t npos = size_t(-1);
+
+      //! \brief The maximum number of free jobs a worker keeps for itself.
+      static const size_t cacheSize = 256;
+
+      /*! \brief The deque of a worker, and its cache of free jobs.
+       *
+       * The size is a copy of jobs.size() which may be read without
+       * the lock, to skip empty deques.
+       */
+      struct Worker
+      {
+	Worker(): size(0) {}
+	Mutex mutex;
+	std::deque<detail::WSJob*> jobs;
+	volatile size_t size;
+	std::vector<detail::WSJob*> cache;
+      };
+
+      //! \brief The pool which owns the current thread, if any.
+      inline static WorkStealingPool*& currentPool()
+      { static __thread WorkStealingPool* pool = NULL; return pool; }
+
+      //! \brief The index of the current thread in its pool.
+      inline static size_t& currentIndex()
+      { static __thread size_t index = 0; return index; }
+
+      //! \brief The index of the current thread in this pool, or npos.
+      inline size_t currentWorker() const
+      { return (currentPool() == this) ? currentIndex() : npos; }
+
+      inline detail::WSJob* allocate()
+      {
+	detail::WSJob* job = NULL;
+	const size_t id = currentWorker();
+	if ((id != npos) && !_workers[id]->cache.empty())
+	  {
+	    job = _workers[id]->cache.back();
+	    _workers[id]->cache.pop_back();
+	  }
+	else
+	  {
+	    ScopedLock lock(_free_mutex);
+	    if (!_freeJobs.empty())
+	      {
+		job = _freeJobs.back();
+		_freeJobs.pop_back();
+	      }
+	  }
+
+	if (!job) job = new detail::WSJob;
+	job->refs = 1;
+	job->remaining = 1;
+	job->hasFuture = false;
+	job->failed = false;
+	return job;
+      }
+
+      //! \brief Drops a reference to a job, recycling it if it was the last.
+      inline void release(detail::WSJob* job)
+      {
+	if (__sync_sub_and_fetch(&job->refs, size_t(1))) return;
+
+	job->error.clear();
+	const size_t id = currentWorker();
+	if ((id != npos) && (_workers[id]->cache.size() < cacheSize))
+	  _workers[id]->cache.push_back(job);
+	else
+	  {
+	    ScopedLock lock(_free_mutex);
+	    _freeJobs.push_back(job);
+	  }
+      }
+
+      inline detail::WSJob* makeTaskJob(function::Task* task)
+      {
+	detail::WSJob* job = allocate();
+	detail::WSTask::get(job) = task;
+	job->run = &detail::WSTask::run;
+	job->destroy = &detail::WSTask::destroy;
+	return job;
+      }
+
+      template<class Container>
+      static void freeJobs(Container& jobs)
+      {
+	for (typename Container::iterator iPtr = jobs.begin(); iPtr != jobs.end(); ++iPtr)
+	  {
+	    //Queued jobs still hold their functors
+	    if ((*iPtr)->remaining) (*iPtr)->destroy(*iPtr);
+	    delete *iPtr;
+	  }
+	jobs.clear();
+      }
+
+      /*! \brief Queues a job on the current worker's deque, or the
+       * shared deque if this is not one of the pool's threads.
+       */
+      inline void push(detail::WSJob* job)
+      {
+	const size_t id = currentWorker();
+	Worker& worker = (id != npos) ? *_workers[id] : _external;
+
+	__sync_add_and_fetch(&_pending, size_t(1));
+	{
+	  ScopedLock lock(worker.mutex);
+	  worker.jobs.push_back(job);
+	  worker.size = worker.jobs.size();
+	  __sync_add_and_fetch(&_queued, size_t(1));
+	}
+
+	//Wake a sleeping worker. The sleeping count is incremented
+	//before a worker checks the queued count, so either it sees
+	//this job or it is counted here.
+	if (_sleeping)
+	  {
+	    ScopedLock lock(_sleep_mutex);
+	    _work_condition.notify_one();
+	  }
+      }
+
+      inline detail::WSJob* popBack(Worker& worker)
+      {
+	if (!worker.size) return NULL;
+	ScopedLock lock(worker.mutex);
+	if (worker.jobs.empty()) return NULL;
+	detail::WSJob* job = worker.jobs.back();
+	worker.jobs.pop_back();
+	worker.size = worker.jobs.size();
+	__sync_sub_and_fetch(&_queued, size_t(1));
+	return job;
+      }
+
+      inline detail::WSJob* popFront(Worker& worker)
+      {
+	if (!worker.size) return NULL;
+	ScopedLock lock(worker.mutex);
+	if (worker.jobs.empty()) return NULL;
+	detail::WSJob* job = worker.jobs.front();
+	worker.jobs.pop_front();
+	worker.size = worker.jobs.size();
+	__sync_sub_and_fetch(&_queued, size_t(1));
+	return job;
+      }
+
+      /*! \brief Finds a job for a thread to run.
+       *
+       * A worker first takes the newest job from its own deque, then
+       * the oldest job submitted from outside the pool, then steals
+       * the oldest job of the other workers.
+       */
+      inline detail::WSJob* findJob(size_t id)
+      {
+	detail::WSJob* job = NULL;
+	if ((id != npos) && (job = popBack(*_workers[id]))) return job;
+	if ((job = popFront(_external))) return job;
+
+	const size_t n = _workers.size();
+	const size_t start = (id != npos) ? id + 1 : 0;
+	for (size_t i(0); i < n; ++i)
+	  {
+	    const size_t victim = (start + i) % n;
+	    if ((victim != id) && (job = popFront(*_workers[victim])))
+	      return job;
+	  }
+
+	return NULL;
+      }
+
+      inline void execute(detail::WSJob* job)
+      {
+	try { job->run(job); }
+	catch (std::exception& cep)
+	  {
+	    job->failed = true;
+	    job->error = cep.what();
+
+	    if (!job->hasFuture)
+	      {
+		//Mark the waiting thread to throw an exception
+		ScopedLock lock(_exception_mutex);
+		_exception_data << "\nTHREAD: Task threw an exception:-" << cep.what();
+		_exception_flag = true;
+	      }
+	  }
+
+	job->destroy(job);
+	complete(job->remaining);
+	complete(_pending);
+	release(job);
+      }
+
+      //! \brief Decrements a counter which a thread may be waiting on.
+      inline void complete(volatile size_t& counter)
+      {
+	//Waiters only wake once their counter reaches zero. As in
+	//push(), the waiters are counted before they check their
+	//counter.
+	if (!__sync_sub_and_fetch(&counter, size_t(1)) && _waiters)
+	  {
+	    ScopedLock lock(_done_mutex);
+	    _done_condition.notify_all();
+	  }
+      }
+
+      /*! \brief Runs jobs until the counter reaches zero, sleeping if
+       * there are none to run.
+       */
+      inline void helpUntil(volatile size_t& counter)
+      {
+	const size_t id = currentWorker();
+	while (counter)
+	  {
+	    detail::WSJob* job = findJob(id);
+	    if (job)
+	      {
+		execute(job);
+		continue;
+	      }
+
+	    ScopedLock lock(_done_mutex);
+	    __sync_add_and_fetch(&_waiters, size_t(1));
+	    if (counter && !_queued)
+	      _done_condition.wait(_done_mutex);
+	    __sync_sub_and_fetch(&_waiters, size_t(1));
+	  }
+      }
+
+      template<class Body>
+      inline void runRange(detail::WSRange<Body>& range)
+      {
+	std::vector<Future> helpers;
+	const size_t nHelpers = std::min(range.chunks - 1, _threads.size());
+	helpers.reserve(nHelpers);
+	for (size_t i(0); i < nHelpers; ++i)
+	  helpers.push_back(submit(detail::WSRangeHelper<Body>(&range)));
+
+	//The range is on the stack, so every helper must finish
+	//before any exception leaves this function
+	std::string error;
+	try { range.run(); }
+	catch (std::exception& cep)
+	  {
+	    range.abort();
+	    error += cep.what();
+	  }
+
+	for (std::vector<Future>::iterator iPtr = helpers.begin(); iPtr != helpers.end(); ++iPtr)
+	  try { iPtr->wait(); }
+	  catch (std::exception& cep)
+	    {
+	      range.abort();
+	      error += cep.what();
+	    }
+
+	if (!error.empty())
+	  M_throw() << "Exception while running a parallel range:-" << error;
+      }
+
+      inline size_t defaultGrain(size_t begin, size_t end, size_t grain) const
+      {
+	if (grain) return grain;
+	return std::max(size_t(1), (end - begin) / (8 * (_threads.size() + 1)));
+      }
+
+      /*! \brief Thread worker loop.
+       */
+      inline void beginThread(size_t id)
+      {
+	currentPool() = this;
+	currentIndex() = id;
+
+	try
+	  {
+	    for (;;)
+	      {
+		detail::WSJob* job = findJob(id);
+		if (job)
+		  {
+		    execute(job);
+		    continue;
+		  }
+
+		ScopedLock lock(_sleep_mutex);
+		if (_stop_flag) break;
+		__sync_add_and_fetch(&_sleeping, size_t(1));
+		if (!_queued)
+		  _work_condition.wait(_sleep_mutex);
+		__sync_sub_and_fetch(&_sleeping, size_t(1));
+	      }
+	  }
+	catch (std::exception& p)
+	  {
+	    std::cout << "\nTHREAD :Catastrophic Failure of thread!!! System will Hang, Aborting!"
+		      << p.what();
+	    throw;
+	  }
+      }
+
+      /*! \brief Halt the pool once the queued tasks have run, and
+       * terminate all the threads.
+       */
+      inline void stop()
+      {
+	{
+	  ScopedLock lock(_sleep_mutex);
+	  _stop_flag = true;
+	}
+
+	_work_condition.notify_all();
+	_threads.join_all();
+      }
+
+      bool _exception_flag;
+      std::ostringstream _exception_data;
+      Mutex _exception_mutex;
+
+      std::vector<Worker*> _workers;
+      //! \brief The deque for tasks submitted from outside the pool.
+      Worker _external;
+
+      Mutex _free_mutex;
+      std::vector<detail::WSJob*> _freeJobs;
+
+      //! \brief The number of submitted jobs which have not yet run.
+      volatile size_t _pending;
+      //! \brief The number of jobs in the deques.
+      volatile size_t _queued;
+
+      volatile size_t _sleeping;
+      Mutex _sleep_mutex;
+      Condition _work_condition;
+
+      volatile size_t _waiters;
+      Mutex _done_mutex;
+      Condition _done_condition;
+
+      volatile bool _stop_flag;
+
+      ThreadGroup _threads;
+    };
+  }
+}
@@ -0,0 +1,107 @@
+#include <magnet/stream/bzip2.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+
+namespace io = boost::iostreams;
+
+//Some compressible text, so that the streams are small compared to
+//the blocks
+std::string makeData(size_t length)
+{
+  std::string data;
+  data.reserve(length);
+  std::srand(42);
+  while (data.size() < length)
+    {
+      std::ostringstream os;
+      os << "<Pt ID=\"" << data.size() << "\"><P x=\"" << std::rand() % 1000 << "\"/></Pt>\n";
+      data += os.str();
+    }
+  data.resize(length);
+  return data;
+}
+
+template<class Filter>
+std::string filter(const std::string& data, Filter f)
+{
+  std::string result;
+  io::filtering_ostream os;
+  os.push(f);
+  os.push(io::back_inserter(result));
+  os.write(data.data(), data.size());
+  os.reset();
+  return result;
+}
+
+template<class Filter>
+std::string unfilter(const std::string& data, Filter f)
+{
+  std::string result;
+  io::filtering_istream is;
+  is.push(f);
+  is.push(io::array_source(data.data(), data.size()));
+  io::copy(is, io::back_inserter(result));
+  return result;
+}
+
+int main()
+{
+  magnet::thread::WorkStealingPool pool;
+  pool.setThreadCount(4);
+
+  const size_t sizes[] = {0, 1, 999, 1000, 1001, 123456};
+  for (size_t i(0); i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+      const std::string data = makeData(sizes[i]);
+
+      //Small blocks to give many streams
+      const std::string compressed
+	= filter(data, magnet::stream::ParallelBzip2Compressor(&pool, 1000));
+
+      if (unfilter(compressed, io::bzip2_decompressor()) != data)
+	{
+	  std::cout << "The standard decompressor failed to read the parallel stream of "
+		    << sizes[i] << " bytes" << std::endl;
+	  return 1;
+	}
+
+      if (unfilter(compressed, magnet::stream::ParallelBzip2Decompressor(&pool, 100)) != data)
+	{
+	  std::cout << "The parallel decompressor failed to read the parallel stream of "
+		    << sizes[i] << " bytes" << std::endl;
+	  return 1;
+	}
+
+      if (unfilter(compressed, magnet::stream::ParallelBzip2Decompressor()) != data)
+	{
+	  std::cout << "The serial decompressor failed to read the parallel stream of "
+		    << sizes[i] << " bytes" << std::endl;
+	  return 1;
+	}
+
+      if (unfilter(filter(data, io::bzip2_compressor()),
+		   magnet::stream::ParallelBzip2Decompressor(&pool, 100)) != data)
+	{
+	  std::cout << "The parallel decompressor failed to read the standard stream of "
+		    << sizes[i] << " bytes" << std::endl;
+	  return 1;
+	}
+    }
+
+  //A corrupt file must be reported
+  std::string compressed = filter(makeData(10000), magnet::stream::ParallelBzip2Compressor(&pool, 1000));
+  compressed.resize(compressed.size() / 2);
+  try {
+    unfilter(compressed, magnet::stream::ParallelBzip2Decompressor(&pool, 100));
+    std::cout << "Truncated data was not detected" << std::endl;
+    return 1;
+  } catch (std::exception&) {}
+
+  return 0;
+}
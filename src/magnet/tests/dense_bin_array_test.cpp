@@ -0,0 +1,120 @@
+#include <magnet/containers/dense_bin_array.hpp>
+#include <magnet/math/histogram.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <map>
+
+typedef magnet::containers::DenseBinArray<unsigned long> Dense;
+typedef std::map<long, unsigned long> Sparse;
+
+bool sameBins(const Dense& dense, const Sparse& sparse)
+{
+  if (dense.size() != sparse.size()) return false;
+
+  Sparse::const_iterator sit = sparse.begin();
+  for (Dense::const_iterator it = dense.begin(); it != dense.end(); ++it, ++sit)
+    if (((*it).first != sit->first) || ((*it).second != sit->second))
+      return false;
+
+  return true;
+}
+
+int main()
+{
+  std::srand(42);
+
+  {
+    Dense dense;
+    Sparse sparse;
+    if (!sameBins(dense, sparse) || (dense.begin() != dense.end()))
+      { std::cout << "Empty array is not empty" << std::endl; return 1; }
+
+    //A bounded range, filled in a random order in both directions
+    for (size_t i(0); i < 100000; ++i)
+      {
+	long bin = std::rand() % 2001 - 1000;
+	++dense[bin];
+	++sparse[bin];
+      }
+
+    if (!sameBins(dense, sparse))
+      { std::cout << "Bounded bins differ from a map" << std::endl; return 1; }
+
+    if (dense.sparseSize())
+      { std::cout << "Bounded bins were stored sparsely" << std::endl; return 1; }
+
+    //Distant outliers must not be stored in the array
+    long outliers[] = {1000000000, -1000000000, 50000, -50000, 2000000000};
+    for (size_t i(0); i < 5; ++i)
+      {
+	++dense[outliers[i]];
+	++sparse[outliers[i]];
+      }
+
+    if (!sameBins(dense, sparse))
+      { std::cout << "Outlier bins differ from a map" << std::endl; return 1; }
+
+    if (dense.sparseSize() != 5)
+      { std::cout << "Outliers were not stored sparsely" << std::endl; return 1; }
+
+    //Drifting outwards should move the nearby outliers into the array
+    for (long bin(0); bin <= 60000; bin += 7)
+      {
+	++dense[bin];
+	++sparse[bin];
+	++dense[-bin];
+	++sparse[-bin];
+      }
+
+    if (!sameBins(dense, sparse))
+      { std::cout << "Bins differ from a map after filling" << std::endl; return 1; }
+
+    if (dense.sparseSize() != 3)
+      { std::cout << "Outliers were not moved into the array" << std::endl; return 1; }
+
+    dense.clear();
+    sparse.clear();
+    ++dense[-3];
+    ++sparse[-3];
+    if (!sameBins(dense, sparse))
+      { std::cout << "Clear failed" << std::endl; return 1; }
+  }
+
+  {
+    //Histograms filled separately and combined must match a single
+    //histogram, including its output ordering
+    typedef magnet::math::Histogram<> Hist;
+    typedef magnet::math::Histogram<false, Sparse> MapHist;
+    Hist a(0.1), b(0.1);
+    MapHist all(0.1);
+
+    for (size_t i(0); i < 10000; ++i)
+      {
+	double val = std::rand() * (10.0 / RAND_MAX) - 5.0;
+	((i % 2) ? a : b).addVal(val);
+	all.addVal(val);
+      }
+
+    a += b;
+
+    if (a.getSampleCount() != all.getSampleCount())
+      { std::cout << "Combined sample count is wrong" << std::endl; return 1; }
+
+    MapHist::const_iterator sit = all.begin();
+    for (Hist::const_iterator it = a.begin(); it != a.end(); ++it, ++sit)
+      if ((sit == all.end()) || ((*it).first != sit->first) || ((*it).second != sit->second))
+	{ std::cout << "Combined histogram differs" << std::endl; return 1; }
+
+    if (sit != all.end())
+      { std::cout << "Combined histogram is missing bins" << std::endl; return 1; }
+
+    bool thrown = false;
+    try { a += Hist(0.2); }
+    catch (std::exception&) { thrown = true; }
+
+    if (!thrown)
+      { std::cout << "Combined histograms of different bin widths" << std::endl; return 1; }
+  }
+
+  return 0;
+}
@@ -0,0 +1,115 @@
+#include <magnet/containers/small_vector.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <list>
+#include <new>
+
+//Count every heap allocation made by the test
+size_t allocations = 0;
+
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+  ++allocations;
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) throw() { std::free(ptr); }
+
+struct Tracked
+{
+  static int alive;
+  Tracked(int v): value(v) { ++alive; }
+  Tracked(const Tracked& o): value(o.value) { ++alive; }
+  ~Tracked() { --alive; }
+  int value;
+};
+
+int Tracked::alive = 0;
+
+template<class Container>
+size_t allocationsPerEvent(size_t entries, size_t events)
+{
+  size_t start = allocations;
+  for (size_t i(0); i < events; ++i)
+    {
+      Container c;
+      for (size_t j(0); j < entries; ++j)
+	c.push_back(j);
+    }
+  return (allocations - start) / events;
+}
+
+int main()
+{
+  typedef magnet::containers::SmallVector<Tracked, 2> Vec;
+
+  {
+    size_t start = allocations;
+    Vec a;
+    a.push_back(Tracked(1));
+    a.push_back(Tracked(2));
+    if (allocations != start)
+      { std::cout << "Inline storage allocated memory" << std::endl; return 1; }
+
+    for (int i(3); i <= 10; ++i)
+      a.push_back(Tracked(i));
+
+    if (a.size() != 10)
+      { std::cout << "Wrong size after growth" << std::endl; return 1; }
+
+    int expected = 1;
+    for (Vec::const_iterator it = a.begin(); it != a.end(); ++it)
+      if ((it->value) != expected++)
+	{ std::cout << "Wrong element order" << std::endl; return 1; }
+
+    //Self referencing push_back across a reallocation
+    Vec b(a);
+    while (b.size() != b.capacity()) b.push_back(Tracked(0));
+    b.push_back(b.front());
+    if (b.back().value != 1)
+      { std::cout << "Self push_back failed" << std::endl; return 1; }
+
+    a = b;
+    if ((a.size() != b.size()) || (a.back().value != 1))
+      { std::cout << "Assignment failed" << std::endl; return 1; }
+
+    //Sorted insertion and removal, both inline and on the heap
+    Vec c;
+    const int values[] = {5, 1, 3, 4, 2};
+    for (size_t i(0); i < 5; ++i)
+      {
+	Vec::iterator it = c.begin();
+	while ((it != c.end()) && (it->value < values[i])) ++it;
+	c.insert(it, Tracked(values[i]));
+      }
+
+    for (int i(0); i < 5; ++i)
+      if (c[i].value != i + 1)
+	{ std::cout << "Sorted insertion failed" << std::endl; return 1; }
+
+    c.erase(c.begin() + 1);
+    c.erase(c.end() - 1);
+    c.erase(c.begin());
+    if ((c.size() != 2) || (c[0].value != 3) || (c[1].value != 4))
+      { std::cout << "Erase failed" << std::endl; return 1; }
+  }
+
+  if (Tracked::alive)
+    { std::cout << "Leaked " << Tracked::alive << " objects" << std::endl; return 1; }
+
+  const size_t events = 100000;
+  std::cout << "Heap allocations per event (std::list / SmallVector<2>)" << std::endl;
+  for (size_t entries(1); entries <= 4; ++entries)
+    std::cout << entries << " entries: "
+	      << allocationsPerEvent<std::list<size_t> >(entries, events) << " / "
+	      << allocationsPerEvent<magnet::containers::SmallVector<size_t, 2> >(entries, events)
+	      << std::endl;
+
+  if (allocationsPerEvent<magnet::containers::SmallVector<size_t, 2> >(2, events))
+    { std::cout << "SmallVector allocated for an inline event" << std::endl; return 1; }
+
+  return 0;
+}
@@ -2,6 +2,8 @@
 #include <vector>
 #include <stdexcept>
 #include <magnet/thread/threadpool.hpp>
+#include <magnet/thread/workstealing.hpp>
+#include <time.h>
 
 std::vector<float> sums;
 
@@ -23,6 +25,56 @@ void function2(int i)
   sums[i] = sum;
 }
 
+struct Function1
+{
+  void operator()(size_t i) const { function1(i); }
+};
+
+double seconds()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + 1e-9 * now.tv_nsec;
+}
+
+//Times many small tasks on the ThreadPool and the WorkStealingPool
+void benchmark(size_t threads, int N)
+{
+  const size_t loops = 200;
+
+  magnet::thread::ThreadPool pool;
+  pool.setThreadCount(threads);
+  double start = seconds();
+  for (size_t loop(0); loop < loops; ++loop)
+    {
+      for (int i = 0; i < N; ++i)   
+	pool.queueTask(magnet::function::Task::makeTask(function1, i));
+      pool.wait();
+    }
+  const double poolTime = seconds() - start;
+
+  magnet::thread::WorkStealingPool wspool;
+  wspool.setThreadCount(threads);
+  start = seconds();
+  for (size_t loop(0); loop < loops; ++loop)
+    {
+      for (int i = 0; i < N; ++i)   
+	wspool.queueTask(magnet::function::Task::makeTask(function1, i));
+      wspool.wait();
+    }
+  const double queueTime = seconds() - start;
+
+  start = seconds();
+  for (size_t loop(0); loop < loops; ++loop)
+    wspool.parallel_for(0, N, Function1());
+  const double forTime = seconds() - start;
+
+  std::cerr << threads << " threads, " << loops << " x " << N << " tasks:"
+	    << " ThreadPool " << poolTime << "s,"
+	    << " WorkStealingPool queueTask " << queueTime << "s,"
+	    << " parallel_for " << forTime << "s\n";
+}
+
 struct A
 {
   void memberFunc() { std::cerr << "Inside memberfunc\n"; }
@@ -94,6 +146,10 @@ int main()
 	}
     }
 
+  benchmark(0, N);
+  benchmark(1, N);
+  benchmark(4, N);
+
   std::cerr << "Finished\n";
 
   return 0;
@@ -0,0 +1,172 @@
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+#include <functional>
+#include <magnet/thread/workstealing.hpp>
+
+typedef magnet::thread::WorkStealingPool Pool;
+
+std::vector<size_t> values;
+
+void setValue(size_t i) { values[i] = i * i; }
+
+struct SetValue
+{
+  void operator()(size_t i) const { values[i] = 3 * i; }
+};
+
+struct SumSquares
+{
+  void operator()(size_t i, unsigned long long& acc) const { acc += i * i; }
+};
+
+void throwError() { throw std::runtime_error("Expected failure"); }
+
+struct Thrower
+{
+  void operator()() const { throwError(); }
+};
+
+struct Increment
+{
+  Increment(volatile size_t* c): counter(c) {}
+  void operator()() const { __sync_add_and_fetch(counter, size_t(1)); }
+  volatile size_t* counter;
+};
+
+//A task which runs a parallel_for of its own, to test nested waits
+struct Nested
+{
+  Nested(Pool* p, std::vector<size_t>* o, size_t i): pool(p), out(o), id(i) {}
+
+  struct Body
+  {
+    Body(std::vector<size_t>* o, size_t i): out(o), id(i) {}
+    void operator()(size_t j) const { (*out)[id * 100 + j] = id + j; }
+    std::vector<size_t>* out;
+    size_t id;
+  };
+
+  void operator()() const { pool->parallel_for(0, 100, Body(out, id), 7); }
+
+  Pool* pool;
+  std::vector<size_t>* out;
+  size_t id;
+};
+
+bool testPool(size_t nThreads)
+{
+  Pool pool;
+  pool.setThreadCount(nThreads);
+
+  const size_t N = 10000;
+  values.assign(N, 0);
+
+  //The ThreadPool interface
+  for (size_t i(0); i < N; ++i)
+    pool.queueTask(magnet::function::Task::makeTask(setValue, i));
+  pool.wait();
+
+  for (size_t i(0); i < N; ++i)
+    if (values[i] != i * i)
+      {
+	std::cerr << nThreads << " threads: queueTask failed for " << i << "\n";
+	return false;
+      }
+
+  //parallel_for, with the default and a fixed grain
+  pool.parallel_for(0, N, SetValue());
+  for (size_t i(0); i < N; ++i)
+    if (values[i] != 3 * i)
+      {
+	std::cerr << nThreads << " threads: parallel_for failed for " << i << "\n";
+	return false;
+      }
+
+  values.assign(N, 0);
+  pool.parallel_for(5, N, SetValue(), 13);
+  for (size_t i(0); i < N; ++i)
+    if (values[i] != ((i < 5) ? 0 : 3 * i))
+      {
+	std::cerr << nThreads << " threads: parallel_for with a grain failed for " << i << "\n";
+	return false;
+      }
+
+  //parallel_reduce
+  unsigned long long expected = 0;
+  for (size_t i(0); i < N; ++i)
+    expected += i * i;
+
+  if (pool.parallel_reduce(0, N, 0ull, SumSquares(), std::plus<unsigned long long>()) != expected)
+    {
+      std::cerr << nThreads << " threads: parallel_reduce failed\n";
+      return false;
+    }
+
+  //Individual futures
+  volatile size_t counter = 0;
+  std::vector<Pool::Future> futures;
+  for (size_t i(0); i < 1000; ++i)
+    futures.push_back(pool.submit(Increment(&counter)));
+  for (size_t i(0); i < futures.size(); ++i)
+    {
+      futures[i].wait();
+      if (!futures[i].ready())
+	{
+	  std::cerr << nThreads << " threads: a future was not ready after its wait\n";
+	  return false;
+	}
+    }
+  if (counter != 1000)
+    {
+      std::cerr << nThreads << " threads: only " << counter << " futures ran\n";
+      return false;
+    }
+
+  //Tasks which wait on their own sub-tasks
+  std::vector<size_t> nested(100 * 100, 0);
+  futures.clear();
+  for (size_t i(0); i < 100; ++i)
+    futures.push_back(pool.submit(Nested(&pool, &nested, i)));
+  for (size_t i(0); i < futures.size(); ++i)
+    futures[i].wait();
+  for (size_t i(0); i < 100; ++i)
+    for (size_t j(0); j < 100; ++j)
+      if (nested[i * 100 + j] != i + j)
+	{
+	  std::cerr << nThreads << " threads: nested parallel_for failed\n";
+	  return false;
+	}
+
+  //Exceptions are reported by the future of the task
+  Pool::Future failing = pool.submit(Thrower());
+  try {
+    failing.wait();
+    std::cerr << nThreads << " threads: the future did not rethrow the exception\n";
+    return false;
+  } catch (std::exception&) {}
+
+  //The pool itself is not affected by the failed future
+  pool.wait();
+
+  //Or by wait(), for tasks without a future
+  pool.queueTask(magnet::function::Task::makeTask(throwError));
+  try {
+    pool.wait();
+    std::cerr << nThreads << " threads: wait() did not rethrow the exception\n";
+    return false;
+  } catch (std::exception&) {}
+
+  return true;
+}
+
+int main()
+{
+  const size_t threads[] = {0, 1, 4};
+  for (size_t i(0); i < sizeof(threads) / sizeof(threads[0]); ++i)
+    if (!testPool(threads[i]))
+      return 1;
+
+  std::cerr << "Finished\n";
+  return 0;
+}
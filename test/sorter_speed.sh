@@ -0,0 +1,31 @@
+#!/bin/bash
+# Compares the event rate of the Future Event List sorters on a
+# steady state system (elastic hard spheres) and on a system whose
+# event rate drifts strongly (a cooling inelastic gas).
+dynamod="../bin/dynamod"
+dynarun="../bin/dynarun"
+
+NUMRUN=3
+NCOLL=2000000
+SORTERS="BoundedPQMinMax3 CBT LadderQueue"
+
+function testrun {
+    for sorter in $SORTERS; do
+	> speedvals
+	bzcat config.out.xml.bz2 | sed 's/<Sorter Type="[^"]*"/<Sorter Type="'$sorter'"/' | bzip2 > sorter.xml.bz2
+	for i in $(seq 1 $NUMRUN); do
+	    val=$($dynarun sorter.xml.bz2 -c $NCOLL | grep "Avg Events/s" | gawk '{print $NF}')
+	    echo $val >> speedvals
+	done
+	echo $1 $sorter $(cat speedvals | gawk 'BEGIN {sum=0; sqrsum=0} { sum += $1; sqrsum += $1*$1} END {print "Colls Avg "sum/NR" Dev "sqrt((sqrsum - sum * sum /NR) / NR)}')
+    done
+    rm -f speedvals sorter.xml.bz2
+}
+
+#Elastic hard spheres
+$dynamod -m 0 -d 0.5 -C 20
+testrun "Elastic"
+
+#Cooling granular gas
+$dynamod -m 0 -d 0.1 -C 20 --f1 0.9
+testrun "Granular"
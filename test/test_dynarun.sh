@@ -157,6 +157,38 @@ function wallsw_bailout {
 }
 
 
+function Wall_compressiontest {
+    #Hard spheres between two walls, the walls are moved into the
+    #system so their contact regions start part way across a cell
+    ./dynamod -s1 -m 6 -C 6 -d 0.3 -o config.start.xml.bz2 &> run.log
+
+    bzcat config.start.xml.bz2 | gawk 'BEGIN {FS = OFS = "\""}
+        /<Origin / {$2 = ($2 > 0) ? $2 - 2.8 : $2 + 2.8; wall = ($2 > 0) ? $2 : -$2}
+        /<Pt / {pt = ""; inpt = 1}
+        inpt {pt = pt $0 "\n"}
+        inpt && /<P / {x = $2}
+        /<\/Pt>/ {inpt = 0; if ((x < wall - 0.51) && (x > 0.51 - wall)) printf "%s", pt; next}
+        !inpt {print}' | bzip2 > config.walls.xml.bz2
+
+    ./dynarun -s 2 --engine 3 --growth-rate 0.1 --target-pack-frac 0.3 config.walls.xml.bz2 \
+	-o config.end.xml.bz2 --out-data-file output.xml.bz2 >> run.log 2>&1
+
+    #No particle may have passed into the walls
+    if [ $(bzcat config.end.xml.bz2 | gawk 'BEGIN {FS = "\""}
+        /<Origin / {wall = ($2 > 0) ? $2 : -$2}
+        /<P / {if (($2 > wall - 0.5 + 1e-8) || ($2 < 0.5 - wall - 1e-8)) ++out}
+        END {print out + 0}') != "0" ]; then
+	echo "Wall compression -: FAILED, particles passed through the walls"
+	exit 1
+    else
+	echo "Wall compression -: PASSED"
+    fi
+
+    #Cleanup
+    rm -Rf config.start.xml.bz2 config.walls.xml.bz2 config.end.xml.bz2 \
+	output.xml.bz2 run.log
+}
+
 function Ring_compressiontest { 
     ./dynamod -m 7 --f3 0 &> run.log
     ./dynamod -m 3 --s1 config.out.xml.bz2 --i1 1 -C 4 -d 0.01 -o tmp.xml.bz2 &> run.log
@@ -396,6 +428,53 @@ function HardSphereTest {
 	tmp.xml.bz2 run.log
 }
 
+function SortedHardSphereTest {
+    > run.log
+
+    #The same seeded run, with and without renumbering the particles
+    #in Morton order, must follow the same trajectory
+    ./dynamod -s 1 -m 0 -o config.start.xml.bz2 &> run.log
+    bzcat config.start.xml.bz2 | \
+	$Xml ed -i '//Globals/Global[@Name="SchedulerNBList"]' -t attr -n "SortInterval" -v "0.5" \
+	| bzip2 > config.sorted.xml.bz2
+
+    ./dynarun -s 2 -c 20000 -L MSD config.start.xml.bz2 \
+	-o config.end.xml.bz2 --out-data-file output.xml.bz2 >> run.log 2>&1
+    ./dynarun -s 2 -c 20000 -L MSD config.sorted.xml.bz2 \
+	-o config.sorted.end.xml.bz2 --out-data-file output.sorted.xml.bz2 >> run.log 2>&1
+
+    if [ $(grep -c "Renumbered the particles" run.log) == "0" ]; then
+	echo "SortedHardSphereTest -: FAILED, the particles were never renumbered"
+	exit 1
+    fi
+
+    #The particle IDs differ, so quantities which do not depend on
+    #the order of the particles are compared
+    for file in config.end.xml.bz2 config.sorted.end.xml.bz2; do
+	bzcat $file | $Xml sel -t -m '//ParticleData/Pt' \
+	    -v 'P/@x' -o ' ' -v 'P/@y' -o ' ' -v 'P/@z' -n \
+	    | gawk 'NF {x += $1*$1; y += $2*$2; z += $3*$3} END {printf "%.10e %.10e %.10e\n", x, y, z}' > $file.sums
+    done
+
+    MSD1=$(bzcat output.xml.bz2 | $Xml sel -t -v '/OutputData/MSD/Species/@val')
+    MSD2=$(bzcat output.sorted.xml.bz2 | $Xml sel -t -v '/OutputData/MSD/Species/@val')
+
+    if [ $(echo $MSD1 $MSD2 $(cat config.end.xml.bz2.sums) $(cat config.sorted.end.xml.bz2.sums) \
+	| gawk 'function near(a, b) { var=(a-b)/a; return (var < 1e-5) && (var > -1e-5) }
+                {print near($1,$2) && near($3,$6) && near($4,$7) && near($5,$8)}') != "1" ]; then
+	echo "SortedHardSphereTest -: FAILED, the renumbered trajectory differs, MSD =" $MSD2 \
+	    ", expected MSD =" $MSD1
+	exit 1
+    else
+	echo "SortedHardSphereTest -: PASSED"
+    fi
+
+#Cleanup
+    rm -Rf config.start.xml.bz2 config.sorted.xml.bz2 config.end.xml.bz2 \
+	config.sorted.end.xml.bz2 output.xml.bz2 output.sorted.xml.bz2 \
+	config.end.xml.bz2.sums config.sorted.end.xml.bz2.sums run.log
+}
+
 function SquareWellTest {
     > run.log
 
@@ -428,6 +507,70 @@ function SquareWellTest {
 	tmp.xml.bz2 run.log
 }
 
+function CheckpointTest {
+    > run.log
+
+    #Square wells carry a capture map and hard lines carry orientation
+    #data, both must survive a binary checkpoint
+    for mode in 1 9; do
+	./dynamod -s1 -m $mode -C 5 -o config.start.xml.bz2 >> run.log 2>&1
+	./dynarun -s 2 -c 20000 config.start.xml.bz2 \
+	    -o config.end.xml.bz2 --out-data-file output.xml.bz2 >> run.log 2>&1
+	./dynarun -s 2 -c 20000 config.start.xml.bz2 \
+	    -o config.end.dynbin --out-data-file output.xml.bz2 >> run.log 2>&1
+
+	#Reload both end states and write them back out as XML, the
+	#only differences allowed are the rounding of the XML values
+	./dynarun -s 3 -c 1 config.end.xml.bz2 \
+	    -o config.xml.xml.bz2 --out-data-file output.xml.bz2 >> run.log 2>&1
+	./dynarun -s 3 -c 1 config.end.dynbin \
+	    -o config.bin.xml.bz2 --out-data-file output.xml.bz2 >> run.log 2>&1
+
+	bzcat config.xml.xml.bz2 > config.xml.xml
+	bzcat config.bin.xml.bz2 > config.bin.xml
+
+	if [ $(gawk 'NR == FNR {line[FNR] = $0; lines = FNR; next}
+                     $0 != line[FNR] {
+                       n = split(line[FNR], a, "\"");
+                       if (n != split($0, b, "\"")) bad = 1;
+                       for (i = 1; i <= n; ++i)
+                         if (a[i] != b[i]) {
+                           d = a[i] - b[i]; s = a[i];
+                           if (d < 0) d = -d; if (s < 0) s = -s;
+                           if ((a[i] !~ /^[-+.0-9eE]+$/) || (d > 1e-8 * (1 + s))) bad = 1;
+                         }
+                     }
+                     END {print (!bad && (FNR == lines))}' config.xml.xml config.bin.xml) != "1" ]; then
+	    echo "CheckpointTest -: FAILED, the checkpoint of dynamod mode $mode does not reload"
+	    exit 1
+	fi
+    done
+
+    #Damaged checkpoints must be rejected
+    head -c 1000 config.end.dynbin > config.short.dynbin
+    ./dynarun -c 1 config.short.dynbin -o config.bad.xml.bz2 > bad.log 2>&1
+    if [ $(grep -c "is truncated" bad.log) == "0" ]; then
+	echo "CheckpointTest -: FAILED, a truncated checkpoint was not rejected"
+	exit 1
+    fi
+
+    cp config.end.dynbin config.magic.dynbin
+    printf 'XXXXXXXX' | dd of=config.magic.dynbin bs=1 count=8 conv=notrunc 2> /dev/null
+    ./dynarun -c 1 config.magic.dynbin -o config.bad.xml.bz2 > bad.log 2>&1
+    if [ $(grep -c "is not a DynamO checkpoint" bad.log) == "0" ]; then
+	echo "CheckpointTest -: FAILED, a checkpoint with a bad magic number was not rejected"
+	exit 1
+    fi
+
+    echo "CheckpointTest -: PASSED"
+
+#Cleanup
+    rm -Rf config.start.xml.bz2 config.end.xml.bz2 config.end.dynbin \
+	config.xml.xml.bz2 config.bin.xml.bz2 config.xml.xml config.bin.xml \
+	config.short.dynbin config.magic.dynbin config.bad.xml.bz2 \
+	output.xml.bz2 bad.log run.log
+}
+
 function BinarySphereTest {
     > run.log
 
@@ -728,10 +871,14 @@ echo ""
 echo "INTERACTIONS+Dynamod Systems"
 echo "Testing Hard Spheres, NeighbourLists and BoundedPQ's"
 HardSphereTest
+echo "Testing hard spheres renumbered in Morton order, NeighbourLists and BoundedPQ's"
+SortedHardSphereTest
 echo "Testing binary hard spheres, NeighbourLists and BoundedPQ's"
 BinarySphereTest "Cells"
 echo "Testing Square Wells, Thermostats, NeighbourLists and BoundedPQ's"
 SquareWellTest
+echo "Testing binary checkpoints of square wells and lines"
+CheckpointTest
 echo "Testing infinitely heavy particles"
 HeavySphereTest
 echo "Testing Lines, NeighbourLists and BoundedPQ's"
@@ -778,6 +925,8 @@ echo "Testing compression of hard spheres"
 HS_compressiontest "NeighbourList"
 echo "Testing compression in the prescence of infinitely heavy particles"
 HeavySphereCompressionTest
+echo "Testing compression of hard spheres between walls"
+Wall_compressiontest
 echo "Testing compression of polymers (very sensitive to errors in the algorithm)"
 Ring_compressiontest
 echo "Packing of a square well polymer into a larger system, and compressing the system"